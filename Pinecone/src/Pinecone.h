@@ -7,6 +7,7 @@
 #include "Pinecone/Core/Assert.h"
 #include "Pinecone/Core/Log.h"
 #include "Pinecone/Core/Timestep.h"
+#include "Pinecone/Core/JobSystem.h"
 
 #include "Pinecone/Core/Input.h"
 #include "Pinecone/Core/KeyCodes.h"
@@ -19,6 +20,9 @@
 #include "Pinecone/Scene/Components.h"
 #include "Pinecone/Scene/ScriptableGameObject.h"
 
+#include "Pinecone/Asset/AssetHandle.h"
+#include "Pinecone/Asset/AssetManager.h"
+
 //// Renderer
 #include "Pinecone/Renderer/Renderer.h"
 #include "Pinecone/Renderer/Renderer2D.h"
@@ -31,6 +35,9 @@
 
 #include "Pinecone/Renderer/Texture.h"
 #include "Pinecone/Renderer/Texture2D.h"
+#include "Pinecone/Renderer/SubTexture2D.h"
+#include "Pinecone/Renderer/TextureAtlas.h"
+#include "Pinecone/Renderer/TextureStreamer.h"
 
 #include "Pinecone/Renderer/Shader.h"
 #include "Pinecone/Renderer/Framebuffer.h"
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace Pinecone
+{
+	class Texture2D;
+	class Font;
+
+	/// <summary>
+	/// A 32 bit handle to an asset owned by the AssetManager. The low bits are the index of the slot
+	/// the asset is in and the high bits are the generation of that slot, which changes every time
+	/// the slot is reused, so a handle to an asset that was unloaded never finds the asset that took
+	/// its place. Copying a handle is free as there is no reference count to update
+	/// </summary>
+	template<typename T>
+	class AssetHandle
+	{
+	public:
+		static const uint32_t IndexBits = 20;
+		static const uint32_t IndexMask = (1u << IndexBits) - 1;
+		// Generation 0 is never used, so a handle with a value of 0 is always null
+		static const uint32_t MaxGeneration = (1u << (32 - IndexBits)) - 1;
+
+		/// <summary>
+		/// The AssetHandle constructor for a null handle
+		/// </summary>
+		AssetHandle() = default;
+		/// <summary>
+		/// The AssetHandle constructor for a handle to a slot
+		/// </summary>
+		/// <param name="index">The index of the slot</param>
+		/// <param name="generation">The generation of the slot</param>
+		AssetHandle(uint32_t index, uint32_t generation)
+			: m_Value((generation << IndexBits) | (index & IndexMask)) {}
+
+		/// <summary>
+		/// Get the index of the slot the asset is in
+		/// </summary>
+		/// <returns>The slot index</returns>
+		uint32_t GetIndex() const { return m_Value & IndexMask; }
+		/// <summary>
+		/// Get the generation of the slot the handle was made for
+		/// </summary>
+		/// <returns>The slot generation</returns>
+		uint32_t GetGeneration() const { return m_Value >> IndexBits; }
+		/// <summary>
+		/// Get the index and generation packed into 32 bits
+		/// </summary>
+		/// <returns>The handle value</returns>
+		uint32_t GetValue() const { return m_Value; }
+
+		/// <summary>
+		/// Is the handle not null? A handle that is not null may still point to an asset that was unloaded
+		/// </summary>
+		operator bool() const { return m_Value != 0; }
+
+		bool operator==(const AssetHandle& other) const { return m_Value == other.m_Value; }
+		bool operator!=(const AssetHandle& other) const { return m_Value != other.m_Value; }
+	private:
+		uint32_t m_Value = 0;
+	};
+
+	using TextureHandle = AssetHandle<Texture2D>;
+	using FontHandle = AssetHandle<Font>;
+}
\ No newline at end of file
@@ -0,0 +1,279 @@
+#include "pcpch.h"
+#include "AssetManager.h"
+
+namespace Pinecone
+{
+	/// <summary>
+	/// The slots of every loaded asset of one type. Slots of unloaded assets are reused, bumping their
+	/// generation so the handles to the old asset stop resolving
+	/// </summary>
+	template<typename T>
+	struct AssetPool
+	{
+		struct Slot
+		{
+			Ref<T> Asset; // Null if the slot is free
+			UUID ID = 0;
+			std::string Path; // Empty for assets that were not loaded from a file
+			uint32_t RefCount = 0;
+			uint32_t Generation = 1;
+		};
+
+		std::vector<Slot> Slots;
+		std::vector<uint32_t> FreeSlots;
+		std::unordered_map<std::string, uint32_t> PathLookup;
+		std::unordered_map<UUID, uint32_t> UUIDLookup;
+
+		/// <summary>
+		/// Find the slot a handle points to
+		/// </summary>
+		/// <returns>The slot, null if the handle is null or its asset was unloaded</returns>
+		Slot* Find(AssetHandle<T> handle)
+		{
+			uint32_t index = handle.GetIndex();
+			if (!handle || index >= Slots.size())
+				return nullptr;
+
+			Slot& slot = Slots[index];
+			return slot.Generation == handle.GetGeneration() && slot.Asset ? &slot : nullptr;
+		}
+
+		AssetHandle<T> MakeHandle(uint32_t index) const
+		{
+			return AssetHandle<T>(index, Slots[index].Generation);
+		}
+
+		AssetHandle<T> FindPath(const std::string& path) const
+		{
+			auto it = PathLookup.find(path);
+			return it != PathLookup.end() ? MakeHandle(it->second) : AssetHandle<T>();
+		}
+
+		AssetHandle<T> FindUUID(UUID uuid) const
+		{
+			auto it = UUIDLookup.find(uuid);
+			return it != UUIDLookup.end() ? MakeHandle(it->second) : AssetHandle<T>();
+		}
+
+		/// <summary>
+		/// Put an asset in a free slot with one reference
+		/// </summary>
+		AssetHandle<T> Add(const Ref<T>& asset, const std::string& path)
+		{
+			uint32_t index;
+			if (!FreeSlots.empty())
+			{
+				index = FreeSlots.back();
+				FreeSlots.pop_back();
+			}
+			else
+			{
+				index = (uint32_t)Slots.size();
+				PC_CORE_ASSERT(index <= AssetHandle<T>::IndexMask, "Too many assets loaded!");
+				Slots.emplace_back();
+			}
+
+			Slot& slot = Slots[index];
+			slot.Asset = asset;
+			slot.ID = UUID();
+			slot.Path = path;
+			slot.RefCount = 1;
+
+			if (!path.empty())
+				PathLookup[path] = index;
+			UUIDLookup[slot.ID] = index;
+			return MakeHandle(index);
+		}
+
+		void Acquire(AssetHandle<T> handle)
+		{
+			Slot* slot = Find(handle);
+			PC_CORE_ASSERT(slot, "Handle does not point to a loaded asset!");
+			if (slot)
+				slot->RefCount++;
+		}
+
+		void Release(AssetHandle<T> handle)
+		{
+			// Releasing a handle whose asset is already gone does nothing, such as when the
+			// AssetManager was shut down first
+			Slot* slot = Find(handle);
+			if (!slot || --slot->RefCount > 0)
+				return;
+
+			if (!slot->Path.empty())
+				PathLookup.erase(slot->Path);
+			UUIDLookup.erase(slot->ID);
+
+			// The asset is freed here unless something still holds a Ref to it
+			slot->Asset = nullptr;
+			slot->Path.clear();
+			slot->Generation = slot->Generation == AssetHandle<T>::MaxGeneration ? 1 : slot->Generation + 1;
+			FreeSlots.push_back(handle.GetIndex());
+		}
+
+		void Clear()
+		{
+			// Keep the slots so their generations keep handles to the unloaded assets from resolving
+			for (uint32_t i = 0; i < (uint32_t)Slots.size(); i++)
+			{
+				if (!Slots[i].Asset)
+					continue;
+
+				Slots[i].RefCount = 1;
+				Release(MakeHandle(i));
+			}
+		}
+	};
+
+	struct AssetManagerData
+	{
+		AssetPool<Texture2D> Textures;
+		AssetPool<Font> Fonts;
+
+		// Returned for handles that do not point to an asset
+		Ref<Texture2D> NullTexture;
+		Ref<Font> NullFont;
+	};
+
+	static AssetManagerData s_Data;
+
+	/// <summary>
+	/// Turn a file path into the key it is cached by, so different spellings of the same path find the same asset
+	/// </summary>
+	static std::string GetPathKey(const std::filesystem::path& filepath)
+	{
+		return filepath.lexically_normal().generic_string();
+	}
+
+	void AssetManager::Shutdown()
+	{
+		PC_PROFILE_FUNCTION();
+
+		s_Data.Textures.Clear();
+		s_Data.Fonts.Clear();
+	}
+
+	TextureHandle AssetManager::LoadTexture(const std::string& filepath, bool async)
+	{
+		return LoadTexture(TextureSpecification(), filepath, async);
+	}
+
+	TextureHandle AssetManager::LoadTexture(const TextureSpecification& specification, const std::string& filepath, bool async)
+	{
+		PC_PROFILE_FUNCTION();
+
+		std::string key = GetPathKey(filepath);
+		TextureHandle handle = s_Data.Textures.FindPath(key);
+		if (handle)
+		{
+			s_Data.Textures.Acquire(handle);
+			return handle;
+		}
+
+		Ref<Texture2D> texture = async ? Texture2D::CreateAsync(specification, filepath) : Texture2D::Create(specification, filepath);
+		return s_Data.Textures.Add(texture, key);
+	}
+
+	TextureHandle AssetManager::AddTexture(const Ref<Texture2D>& texture)
+	{
+		PC_PROFILE_FUNCTION();
+
+		return s_Data.Textures.Add(texture, std::string());
+	}
+
+	FontHandle AssetManager::LoadFont(const std::filesystem::path& filepath)
+	{
+		PC_PROFILE_FUNCTION();
+
+		std::string key = GetPathKey(filepath);
+		FontHandle handle = s_Data.Fonts.FindPath(key);
+		if (handle)
+		{
+			s_Data.Fonts.Acquire(handle);
+			return handle;
+		}
+
+		return s_Data.Fonts.Add(Font::Create(filepath), key);
+	}
+
+	const Ref<Texture2D>& AssetManager::GetTexture(TextureHandle handle)
+	{
+		auto* slot = s_Data.Textures.Find(handle);
+		return slot ? slot->Asset : s_Data.NullTexture;
+	}
+
+	const Ref<Font>& AssetManager::GetFont(FontHandle handle)
+	{
+		auto* slot = s_Data.Fonts.Find(handle);
+		return slot ? slot->Asset : s_Data.NullFont;
+	}
+
+	TextureHandle AssetManager::FindTexture(const std::string& filepath)
+	{
+		return s_Data.Textures.FindPath(GetPathKey(filepath));
+	}
+
+	TextureHandle AssetManager::FindTexture(UUID uuid)
+	{
+		return s_Data.Textures.FindUUID(uuid);
+	}
+
+	FontHandle AssetManager::FindFont(const std::filesystem::path& filepath)
+	{
+		return s_Data.Fonts.FindPath(GetPathKey(filepath));
+	}
+
+	FontHandle AssetManager::FindFont(UUID uuid)
+	{
+		return s_Data.Fonts.FindUUID(uuid);
+	}
+
+	UUID AssetManager::GetUUID(TextureHandle handle)
+	{
+		auto* slot = s_Data.Textures.Find(handle);
+		return slot ? slot->ID : UUID(0);
+	}
+
+	UUID AssetManager::GetUUID(FontHandle handle)
+	{
+		auto* slot = s_Data.Fonts.Find(handle);
+		return slot ? slot->ID : UUID(0);
+	}
+
+	void AssetManager::Acquire(TextureHandle handle)
+	{
+		s_Data.Textures.Acquire(handle);
+	}
+
+	void AssetManager::Release(TextureHandle handle)
+	{
+		PC_PROFILE_FUNCTION();
+
+		s_Data.Textures.Release(handle);
+	}
+
+	void AssetManager::Acquire(FontHandle handle)
+	{
+		s_Data.Fonts.Acquire(handle);
+	}
+
+	void AssetManager::Release(FontHandle handle)
+	{
+		PC_PROFILE_FUNCTION();
+
+		s_Data.Fonts.Release(handle);
+	}
+
+	uint32_t AssetManager::GetRefCount(TextureHandle handle)
+	{
+		auto* slot = s_Data.Textures.Find(handle);
+		return slot ? slot->RefCount : 0;
+	}
+
+	uint32_t AssetManager::GetRefCount(FontHandle handle)
+	{
+		auto* slot = s_Data.Fonts.Find(handle);
+		return slot ? slot->RefCount : 0;
+	}
+}
\ No newline at end of file
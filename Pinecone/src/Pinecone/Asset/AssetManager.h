@@ -0,0 +1,145 @@
+#pragma once
+
+#include "Pinecone/Asset/AssetHandle.h"
+#include "Pinecone/Core/UUID.h"
+#include "Pinecone/Renderer/Texture2D.h"
+#include "Pinecone/Renderer/Font.h"
+
+namespace Pinecone
+{
+	/// <summary>
+	/// Owns the textures and fonts loaded from files, so every file is only loaded and uploaded once
+	/// no matter how many times it is asked for. Assets are found by their file path or by the UUID
+	/// they are given when they are loaded, and are used through handles instead of Refs.
+	///
+	/// Every asset has a reference count that is changed explicitly. Loading an asset or acquiring a
+	/// handle to it adds a reference, and releasing the handle removes one. Once the last reference is
+	/// released the asset is unloaded and its handles stop resolving. Assets must be loaded and released
+	/// on the main thread, handles can be resolved from any thread in between
+	/// </summary>
+	class AssetManager
+	{
+	public:
+		/// <summary>
+		/// Unload every asset, whatever its reference count
+		/// </summary>
+		static void Shutdown();
+
+		/// <summary>
+		/// Load a texture from a file, or add a reference to it if it is already loaded
+		/// </summary>
+		/// <param name="filepath">The file path to the texture file</param>
+		/// <param name="async">Load the texture in the background with Texture2D::CreateAsync</param>
+		/// <returns>A handle to the texture</returns>
+		static TextureHandle LoadTexture(const std::string& filepath, bool async = false);
+		/// <summary>
+		/// Load a texture from a file with a texture specification, or add a reference to it if it is already
+		/// loaded. A texture that is already loaded keeps the specification it was loaded with
+		/// </summary>
+		/// <param name="specification">The texture specification</param>
+		/// <param name="filepath">The file path to the texture file</param>
+		/// <param name="async">Load the texture in the background with Texture2D::CreateAsync</param>
+		/// <returns>A handle to the texture</returns>
+		static TextureHandle LoadTexture(const TextureSpecification& specification, const std::string& filepath, bool async = false);
+		/// <summary>
+		/// Add a texture that was not loaded from a file, such as one drawn at runtime, so it can be
+		/// used through a handle. The texture starts with one reference
+		/// </summary>
+		/// <param name="texture">The texture</param>
+		/// <returns>A handle to the texture</returns>
+		static TextureHandle AddTexture(const Ref<Texture2D>& texture);
+		/// <summary>
+		/// Load a font from a file, or add a reference to it if it is already loaded
+		/// </summary>
+		/// <param name="filepath">The file path to the font file</param>
+		/// <returns>A handle to the font</returns>
+		static FontHandle LoadFont(const std::filesystem::path& filepath);
+
+		/// <summary>
+		/// Get the texture a handle points to. This does not touch any reference count
+		/// </summary>
+		/// <param name="handle">The handle</param>
+		/// <returns>The texture, null if the handle is null or the texture was unloaded</returns>
+		static const Ref<Texture2D>& GetTexture(TextureHandle handle);
+		/// <summary>
+		/// Get the font a handle points to. This does not touch any reference count
+		/// </summary>
+		/// <param name="handle">The handle</param>
+		/// <returns>The font, null if the handle is null or the font was unloaded</returns>
+		static const Ref<Font>& GetFont(FontHandle handle);
+
+		/// <summary>
+		/// Find a loaded texture by its file path without adding a reference to it
+		/// </summary>
+		/// <param name="filepath">The file path to the texture file</param>
+		/// <returns>A handle to the texture, null if it is not loaded</returns>
+		static TextureHandle FindTexture(const std::string& filepath);
+		/// <summary>
+		/// Find a loaded texture by its UUID without adding a reference to it
+		/// </summary>
+		/// <param name="uuid">The UUID of the texture</param>
+		/// <returns>A handle to the texture, null if it is not loaded</returns>
+		static TextureHandle FindTexture(UUID uuid);
+		/// <summary>
+		/// Find a loaded font by its file path without adding a reference to it
+		/// </summary>
+		/// <param name="filepath">The file path to the font file</param>
+		/// <returns>A handle to the font, null if it is not loaded</returns>
+		static FontHandle FindFont(const std::filesystem::path& filepath);
+		/// <summary>
+		/// Find a loaded font by its UUID without adding a reference to it
+		/// </summary>
+		/// <param name="uuid">The UUID of the font</param>
+		/// <returns>A handle to the font, null if it is not loaded</returns>
+		static FontHandle FindFont(UUID uuid);
+
+		/// <summary>
+		/// Get the UUID a texture was given when it was loaded
+		/// </summary>
+		/// <param name="handle">The handle</param>
+		/// <returns>The UUID, 0 if the handle does not point to a texture</returns>
+		static UUID GetUUID(TextureHandle handle);
+		/// <summary>
+		/// Get the UUID a font was given when it was loaded
+		/// </summary>
+		/// <param name="handle">The handle</param>
+		/// <returns>The UUID, 0 if the handle does not point to a font</returns>
+		static UUID GetUUID(FontHandle handle);
+
+		/// <summary>
+		/// Add a reference to a texture
+		/// </summary>
+		/// <param name="handle">The handle</param>
+		static void Acquire(TextureHandle handle);
+		/// <summary>
+		/// Remove a reference from a texture, unloading it if it was the last one. Does nothing if the
+		/// texture is already unloaded
+		/// </summary>
+		/// <param name="handle">The handle</param>
+		static void Release(TextureHandle handle);
+		/// <summary>
+		/// Add a reference to a font
+		/// </summary>
+		/// <param name="handle">The handle</param>
+		static void Acquire(FontHandle handle);
+		/// <summary>
+		/// Remove a reference from a font, unloading it if it was the last one. Does nothing if the
+		/// font is already unloaded
+		/// </summary>
+		/// <param name="handle">The handle</param>
+		static void Release(FontHandle handle);
+
+		/// <summary>
+		/// Get the number of references to a texture
+		/// </summary>
+		/// <param name="handle">The handle</param>
+		/// <returns>The reference count, 0 if the handle does not point to a texture</returns>
+		static uint32_t GetRefCount(TextureHandle handle);
+		/// <summary>
+		/// Get the number of references to a font
+		/// </summary>
+		/// <param name="handle">The handle</param>
+		/// <returns>The reference count, 0 if the handle does not point to a font</returns>
+		static uint32_t GetRefCount(FontHandle handle);
+	};
+}
\ No newline at end of file
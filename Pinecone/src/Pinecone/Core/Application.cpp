@@ -2,7 +2,10 @@
 #include "Application.h"
 
 #include "Pinecone/Core/Log.h"
+#include "Pinecone/Core/JobSystem.h"
+#include "Pinecone/Asset/AssetManager.h"
 #include "Pinecone/Renderer/Renderer.h"
+#include "Pinecone/Renderer/TextureStreamer.h"
 #include "Pinecone/Utils/Utils.h"
 
 namespace Pinecone
@@ -22,6 +25,9 @@ namespace Pinecone
 		// Set the window event callback function to be the application OnEvent function
 		m_Window->SetEventCallback(PC_BIND_EVENT_FN(Application::OnEvent));
 
+		// Start the worker threads before anything that schedules jobs
+		JobSystem::Init();
+
 		// Initilize the renderer
 		Renderer::Init();
 
@@ -33,8 +39,13 @@ namespace Pinecone
 	{
 		PC_PROFILE_FUNCTION();
 
+		// Unload the assets while the renderer can still free their GPU memory
+		AssetManager::Shutdown();
+
 		// Shutdown the renderer
 		Renderer::Shutdown();
+
+		JobSystem::Shutdown();
 	}
 
 	void Application::Close()
@@ -96,6 +107,9 @@ namespace Pinecone
 			Timestep ts = time - m_LastFrameTime;
 			m_LastFrameTime = time;
 
+			// Upload the textures that finished loading in the background
+			TextureStreamer::Update();
+
 			// Don't update layers when minimized
 			if (!m_Minimized)
 			{
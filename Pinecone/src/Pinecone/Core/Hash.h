@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace Pinecone
+{
+	/// <summary>
+	/// Hash data with 64 bit FNV-1a
+	/// </summary>
+	/// <param name="data">The data to hash</param>
+	/// <param name="size">The size of the data in bytes</param>
+	/// <param name="hash">The hash to continue from</param>
+	/// <returns>The hash</returns>
+	inline uint64_t HashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+	{
+		const uint8_t* bytes = (const uint8_t*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+}
\ No newline at end of file
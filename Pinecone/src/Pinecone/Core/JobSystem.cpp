@@ -0,0 +1,289 @@
+#include "pcpch.h"
+#include "JobSystem.h"
+
+#include <thread>
+#include <deque>
+#include <condition_variable>
+
+namespace Pinecone
+{
+	struct QueuedJob
+	{
+		JobSystem::Job Function;
+		JobCounter* Counter;
+	};
+
+	/// <summary>
+	/// The jobs of one thread. The owner pushes and takes jobs at the back, so it works on the jobs
+	/// it scheduled last whose data is most likely still in its cache. Other threads steal from the
+	/// front, taking the oldest jobs which tend to be the largest pieces of work left
+	/// </summary>
+	struct JobQueue
+	{
+		std::mutex Mutex;
+		std::deque<QueuedJob> Jobs;
+	};
+
+	struct JobSystemData
+	{
+		// One queue per worker, and one more for the thread that called Init
+		std::vector<Scope<JobQueue>> Queues;
+		std::vector<std::thread> Workers;
+
+		// The number of jobs in the queues, workers only go to sleep when it is 0
+		std::atomic<uint32_t> QueuedJobCount = 0;
+		std::atomic<uint32_t> SleepingWorkerCount = 0;
+		std::mutex SleepMutex;
+		std::condition_variable SleepCondition;
+		std::atomic<bool> Running = false;
+
+		// Threads without a queue of their own spread their jobs over the workers
+		std::atomic<uint32_t> NextQueue = 0;
+	};
+
+	static JobSystemData s_Data;
+	// The index of the queue owned by the current thread, -1 if it has none
+	static thread_local int32_t t_QueueIndex = -1;
+
+	void JobCounter::Finish()
+	{
+		// Without continuations the decrement is the last time the counter is touched, so a thread
+		// waiting on it may destroy it as soon as it reaches zero
+		if (!m_HasContinuations.load(std::memory_order_acquire))
+		{
+			m_Count.fetch_sub(1, std::memory_order_acq_rel);
+			return;
+		}
+
+		std::vector<std::pair<JobSystem::Job, JobCounter*>> continuations;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (m_Count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				continuations.swap(m_Continuations);
+				m_HasContinuations.store(false, std::memory_order_release);
+			}
+		}
+
+		for (auto& [job, counter] : continuations)
+		{
+			JobSystem::Schedule(std::move(job), counter);
+			// The continuation was counted when it was added, now that it is scheduled it is counted twice
+			if (counter)
+				counter->Finish();
+		}
+	}
+
+	void JobSystem::Init(uint32_t workerCount)
+	{
+		PC_PROFILE_FUNCTION();
+
+		PC_CORE_ASSERT(s_Data.Queues.empty(), "JobSystem already initialized!");
+
+		if (workerCount == 0)
+		{
+			// hardware_concurrency may return 0 if it can not tell
+			uint32_t hardwareThreads = std::thread::hardware_concurrency();
+			workerCount = std::max(hardwareThreads, 2u) - 1;
+		}
+
+		for (uint32_t i = 0; i <= workerCount; i++)
+			s_Data.Queues.push_back(CreateScope<JobQueue>());
+		t_QueueIndex = (int32_t)workerCount;
+
+		s_Data.Running = true;
+		for (uint32_t i = 0; i < workerCount; i++)
+			s_Data.Workers.emplace_back(WorkerLoop, i);
+
+		PC_CORE_INFO("JobSystem started with {} worker threads", workerCount);
+	}
+
+	void JobSystem::Shutdown()
+	{
+		PC_PROFILE_FUNCTION();
+
+		{
+			std::lock_guard<std::mutex> lock(s_Data.SleepMutex);
+			s_Data.Running = false;
+		}
+		s_Data.SleepCondition.notify_all();
+		for (std::thread& worker : s_Data.Workers)
+			worker.join();
+		s_Data.Workers.clear();
+
+		// Run the jobs the workers did not get to, as something may still be waiting on them
+		while (RunNextJob());
+
+		s_Data.Queues.clear();
+		t_QueueIndex = -1;
+	}
+
+	void JobSystem::Schedule(Job job, JobCounter* counter)
+	{
+		if (counter)
+			counter->Add(1);
+
+		if (s_Data.Queues.empty())
+		{
+			job();
+			if (counter)
+				counter->Finish();
+			return;
+		}
+
+		uint32_t queueIndex = t_QueueIndex >= 0 ? (uint32_t)t_QueueIndex : s_Data.NextQueue.fetch_add(1, std::memory_order_relaxed) % (uint32_t)s_Data.Queues.size();
+		JobQueue& queue = *s_Data.Queues[queueIndex];
+		{
+			std::lock_guard<std::mutex> lock(queue.Mutex);
+			queue.Jobs.push_back({ std::move(job), counter });
+		}
+		s_Data.QueuedJobCount.fetch_add(1);
+
+		// A worker counts itself as sleeping before it checks the queued job count, so either it sees
+		// the new job or this sees it sleeping. Taking the lock makes sure it is waiting before the notify
+		if (s_Data.SleepingWorkerCount.load() > 0)
+		{
+			{
+				std::lock_guard<std::mutex> lock(s_Data.SleepMutex);
+			}
+			s_Data.SleepCondition.notify_one();
+		}
+	}
+
+	void JobSystem::ScheduleAfter(JobCounter& dependency, Job job, JobCounter* counter)
+	{
+		{
+			std::lock_guard<std::mutex> lock(dependency.m_Mutex);
+			if (!dependency.IsDone())
+			{
+				// Hold the dependency open while the continuation is added, in case its last job finishes
+				// before it saw that there are continuations
+				dependency.Add(1);
+				if (counter)
+					counter->Add(1);
+				dependency.m_Continuations.emplace_back(std::move(job), counter);
+				dependency.m_HasContinuations.store(true, std::memory_order_release);
+				job = nullptr;
+			}
+		}
+
+		if (job)
+			Schedule(std::move(job), counter);
+		else
+			dependency.Finish();
+	}
+
+	void JobSystem::Wait(JobCounter& counter)
+	{
+		PC_PROFILE_FUNCTION();
+
+		while (!counter.IsDone())
+		{
+			if (!RunNextJob())
+				std::this_thread::yield();
+		}
+
+		// The last job may still hold the lock while it takes the continuations, the counter can only be
+		// destroyed once it let go of it
+		std::lock_guard<std::mutex> lock(counter.m_Mutex);
+	}
+
+	void JobSystem::ParallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t, uint32_t)>& func)
+	{
+		if (count == 0)
+			return;
+
+		// Several batches per thread keep every thread busy when some batches take longer than others
+		if (batchSize == 0)
+			batchSize = std::max(count / ((GetWorkerCount() + 1) * 4), 1u);
+
+		JobCounter counter;
+		for (uint32_t begin = batchSize; begin < count; begin += batchSize)
+		{
+			const uint32_t end = std::min(begin + batchSize, count);
+			Schedule([&func, begin, end]() { func(begin, end); }, &counter);
+		}
+
+		func(0, std::min(batchSize, count));
+		Wait(counter);
+	}
+
+	void JobSystem::ParallelFor(uint32_t count, const std::function<void(uint32_t)>& func)
+	{
+		ParallelFor(count, 0, [&func](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; i++)
+					func(i);
+			});
+	}
+
+	uint32_t JobSystem::GetWorkerCount()
+	{
+		return (uint32_t)s_Data.Workers.size();
+	}
+
+	void JobSystem::WorkerLoop(uint32_t queueIndex)
+	{
+		t_QueueIndex = (int32_t)queueIndex;
+
+		while (s_Data.Running)
+		{
+			if (RunNextJob())
+				continue;
+
+			std::unique_lock<std::mutex> lock(s_Data.SleepMutex);
+			s_Data.SleepingWorkerCount.fetch_add(1);
+			s_Data.SleepCondition.wait(lock, []() { return s_Data.QueuedJobCount.load() > 0 || !s_Data.Running; });
+			s_Data.SleepingWorkerCount.fetch_sub(1);
+		}
+	}
+
+	bool JobSystem::RunNextJob()
+	{
+		if (s_Data.QueuedJobCount.load() == 0)
+			return false;
+
+		const uint32_t queueCount = (uint32_t)s_Data.Queues.size();
+		QueuedJob job;
+		bool found = false;
+
+		// The newest job of our own queue first
+		if (t_QueueIndex >= 0)
+		{
+			JobQueue& queue = *s_Data.Queues[t_QueueIndex];
+			std::lock_guard<std::mutex> lock(queue.Mutex);
+			if (!queue.Jobs.empty())
+			{
+				job = std::move(queue.Jobs.back());
+				queue.Jobs.pop_back();
+				found = true;
+			}
+		}
+
+		// Then the oldest job of any other queue, starting after our own so threads steal from different queues
+		for (uint32_t i = 1; !found && i <= queueCount; i++)
+		{
+			const uint32_t victim = (uint32_t)(t_QueueIndex + (int32_t)i) % queueCount;
+			if ((int32_t)victim == t_QueueIndex)
+				continue;
+
+			JobQueue& queue = *s_Data.Queues[victim];
+			std::unique_lock<std::mutex> lock(queue.Mutex, std::try_to_lock);
+			if (!lock.owns_lock() || queue.Jobs.empty())
+				continue;
+
+			job = std::move(queue.Jobs.front());
+			queue.Jobs.pop_front();
+			found = true;
+		}
+
+		if (!found)
+			return false;
+
+		s_Data.QueuedJobCount.fetch_sub(1);
+		job.Function();
+		if (job.Counter)
+			job.Counter->Finish();
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+
+namespace Pinecone
+{
+	/// <summary>
+	/// Counts the jobs of a group that have not finished yet. Pass it to JobSystem::Schedule for
+	/// every job of the group, then wait for the group with JobSystem::Wait or schedule more jobs to
+	/// run after it with JobSystem::ScheduleAfter. A counter that jobs were scheduled with must be
+	/// waited on before it is destroyed
+	/// </summary>
+	class JobCounter
+	{
+	public:
+		JobCounter() = default;
+		JobCounter(const JobCounter&) = delete;
+		JobCounter& operator=(const JobCounter&) = delete;
+
+		/// <summary>
+		/// Check if every job counted by the counter has finished
+		/// </summary>
+		/// <returns>True if there are no jobs left</returns>
+		bool IsDone() const { return m_Count.load(std::memory_order_acquire) == 0; }
+		/// <summary>
+		/// Get the number of jobs that have not finished yet
+		/// </summary>
+		/// <returns>The number of jobs left</returns>
+		uint32_t GetCount() const { return m_Count.load(std::memory_order_acquire); }
+	private:
+		void Add(uint32_t count) { m_Count.fetch_add(count, std::memory_order_relaxed); }
+		void Finish();
+	private:
+		std::atomic<uint32_t> m_Count = 0;
+
+		// Jobs scheduled to run once the count reaches zero
+		std::mutex m_Mutex;
+		std::vector<std::pair<std::function<void()>, JobCounter*>> m_Continuations;
+		std::atomic<bool> m_HasContinuations = false;
+
+		friend class JobSystem;
+	};
+
+	/// <summary>
+	/// Runs jobs on a pool of worker threads. Every worker has its own queue of jobs, a worker takes
+	/// the newest job from its own queue and when that is empty steals the oldest job from the queue of
+	/// another worker, so workers rarely wait on each other. Threads waiting for jobs to finish run
+	/// jobs instead of blocking, so jobs can schedule and wait on other jobs
+	/// </summary>
+	class JobSystem
+	{
+	public:
+		using Job = std::function<void()>;
+
+		/// <summary>
+		/// Initialize the JobSystem and start the worker threads
+		/// </summary>
+		/// <param name="workerCount">The number of worker threads, 0 for one less than the number
+		/// of hardware threads as the thread calling Init does work as well</param>
+		static void Init(uint32_t workerCount = 0);
+		/// <summary>
+		/// Stop the worker threads. Jobs that were never started are run on the calling thread first
+		/// </summary>
+		static void Shutdown();
+
+		/// <summary>
+		/// Schedule a job to be run by the workers. If the JobSystem is not initialized, the job
+		/// is run right away on the calling thread
+		/// </summary>
+		/// <param name="job">The job</param>
+		/// <param name="counter">The counter of the group the job belongs to, can be null</param>
+		static void Schedule(Job job, JobCounter* counter = nullptr);
+		/// <summary>
+		/// Schedule a job to be run once every job of another group has finished
+		/// </summary>
+		/// <param name="dependency">The counter of the group that has to finish first</param>
+		/// <param name="job">The job</param>
+		/// <param name="counter">The counter of the group the job belongs to, can be null</param>
+		static void ScheduleAfter(JobCounter& dependency, Job job, JobCounter* counter = nullptr);
+		/// <summary>
+		/// Wait until every job of a group has finished, running other jobs in the meantime
+		/// </summary>
+		/// <param name="counter">The counter of the group</param>
+		static void Wait(JobCounter& counter);
+
+		/// <summary>
+		/// Call a function for ranges of indices in parallel and wait until all of them are done.
+		/// The calling thread runs the first range itself
+		/// </summary>
+		/// <param name="count">The number of indices</param>
+		/// <param name="batchSize">The number of indices in each range, 0 to pick one from the worker count</param>
+		/// <param name="func">The function, called with the first index of a range and one past its last index</param>
+		static void ParallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t, uint32_t)>& func);
+		/// <summary>
+		/// Call a function for every index in parallel and wait until all of them are done
+		/// </summary>
+		/// <param name="count">The number of indices</param>
+		/// <param name="func">The function, called with each index</param>
+		static void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& func);
+
+		/// <summary>
+		/// Get the number of worker threads
+		/// </summary>
+		/// <returns>The number of worker threads, 0 if the JobSystem is not initialized</returns>
+		static uint32_t GetWorkerCount();
+	private:
+		/// <summary>
+		/// The loop each worker thread runs until the JobSystem is shut down
+		/// </summary>
+		/// <param name="queueIndex">The index of the workers own queue</param>
+		static void WorkerLoop(uint32_t queueIndex);
+		/// <summary>
+		/// Take a job from the queue of the calling thread or steal one from another queue and run it
+		/// </summary>
+		/// <returns>True if a job was run</returns>
+		static bool RunNextJob();
+	};
+}
\ No newline at end of file
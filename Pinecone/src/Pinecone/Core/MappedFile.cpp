@@ -0,0 +1,44 @@
+#include "pcpch.h"
+#include "MappedFile.h"
+
+namespace Pinecone
+{
+	MappedFile::MappedFile(const std::filesystem::path& filepath)
+	{
+		PC_PROFILE_FUNCTION();
+
+		HANDLE file = CreateFileW(filepath.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return;
+		m_FileHandle = file;
+
+		LARGE_INTEGER size;
+		// Empty files can not be mapped, treat them the same as a file that could not be opened
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+			return;
+
+		HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mapping)
+		{
+			PC_CORE_ERROR("Failed to map file: {}", filepath.string());
+			return;
+		}
+		m_MappingHandle = mapping;
+
+		m_Data = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (m_Data)
+			m_Size = (size_t)size.QuadPart;
+		else
+			PC_CORE_ERROR("Failed to map file: {}", filepath.string());
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (m_Data)
+			UnmapViewOfFile(m_Data);
+		if (m_MappingHandle)
+			CloseHandle(m_MappingHandle);
+		if (m_FileHandle)
+			CloseHandle(m_FileHandle);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <filesystem>
+
+namespace Pinecone
+{
+	/// <summary>
+	/// A read only view of a whole file mapped into memory. The operating system pages the file
+	/// in as it is read, so large files can be used without copying them into a buffer first
+	/// </summary>
+	class MappedFile
+	{
+	public:
+		/// <summary>
+		/// The MappedFile constructor that maps a file into memory
+		/// </summary>
+		/// <param name="filepath">The file path to map</param>
+		MappedFile(const std::filesystem::path& filepath);
+		/// <summary>
+		/// The MappedFile deconstructor, unmaps the file
+		/// </summary>
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		/// <summary>
+		/// Was the file mapped successfully?
+		/// </summary>
+		/// <returns>True if the file is mapped</returns>
+		bool IsOpen() const { return m_Data != nullptr; }
+		/// <summary>
+		/// Get the contents of the file
+		/// </summary>
+		/// <returns>A pointer to the first byte of the file, null if the file could not be mapped</returns>
+		const uint8_t* GetData() const { return m_Data; }
+		/// <summary>
+		/// Get the size of the file
+		/// </summary>
+		/// <returns>The size of the file in bytes</returns>
+		size_t GetSize() const { return m_Size; }
+	private:
+		const uint8_t* m_Data = nullptr;
+		size_t m_Size = 0;
+		void* m_FileHandle = nullptr;
+		void* m_MappingHandle = nullptr;
+	};
+}
\ No newline at end of file
@@ -7,57 +7,337 @@
 #include "GlyphGeometry.h"
 
 #include "Pinecone/Renderer/MSDFData.h"
+#include "Pinecone/Core/MappedFile.h"
+#include "Pinecone/Core/JobSystem.h"
+#include "Pinecone/Core/Hash.h"
+
+#include <fstream>
+#include <mutex>
+#include <deque>
 
 namespace Pinecone {
 
 	Ref<Font> Font::s_DefaultFont = nullptr;
+	size_t Font::s_GlyphCacheBudget = 8 * 1024 * 1024;
+
+	// Stores the first and last character values
+	struct CharsetRange
+	{
+		uint32_t Begin, End;
+	};
+
+	// Use a character range between 32 (space) and 255 as characters before 
+	// 32 are all special characters that cannot be seen.
+	// Ref: https://www.rapidtables.com/code/text/ascii-table.html
+	static const CharsetRange s_CharsetRanges[] =
+	{
+		{ 0x0020, 0x00FF }
+	};
+
+	static const double s_EmSize = 40.0;
+	static const double s_PixelRange = 2.0;
+	static const double s_MiterLimit = 1.0;
+
+	// The size of the glyph pages that glyphs outside of the preloaded charset are rasterized into
+	static const uint32_t s_GlyphPageSize = 512;
+	static const size_t s_GlyphPageBytes = (size_t)s_GlyphPageSize * s_GlyphPageSize * 3;
+
+	// Generated font atlases are cached here so they only have to be generated once
+	static const std::filesystem::path s_FontCacheDirectory = "assets/cache/fonts";
+
+	/// <summary>
+	/// The start of a font cache file. It is followed by the glyphs, the glyph lookup,
+	/// the kerning pairs and then the RGB8 atlas pixels
+	/// </summary>
+	struct FontCacheHeader
+	{
+		// Bump the version whenever the layout of the cache or of the glyph table changes
+		static const uint32_t CurrentMagic = 0x43464350; // "PCFC"
+		static const uint32_t CurrentVersion = 2;
+
+		uint32_t Magic;
+		uint32_t Version;
+		uint64_t Key;
+		uint32_t AtlasWidth;
+		uint32_t AtlasHeight;
+		uint32_t GlyphCount;
+		uint32_t GlyphLookupCount;
+		uint32_t KerningPairCount;
+		float LineHeight;
+	};
 
 	template<typename T, typename S, int N, msdf_atlas::GeneratorFunction<S, N> GenFunc>
-	static Ref<Texture2D> CreateAndCacheAtlas(const std::string& fontName, float fontSize, const std::vector<msdf_atlas::GlyphGeometry>& glyphs,
-		const msdf_atlas::FontGeometry& fontGeometry, uint32_t width, uint32_t height)
+	static std::vector<T> GenerateAtlas(const std::vector<msdf_atlas::GlyphGeometry>& glyphs, uint32_t width, uint32_t height)
+	{
+		PC_PROFILE_FUNCTION();
+
+		std::vector<T> pixels((size_t)width * height * N, T());
+		msdfgen::BitmapRef<T, N> atlas(pixels.data(), (int)width, (int)height);
+
+		// Each glyph is generated on its own and copied into its box in the atlas. The boxes never
+		// overlap, so the glyphs are spread over the job system the same way ImmediateAtlasGenerator
+		// spreads them over its own threads
+		JobSystem::ParallelFor((uint32_t)glyphs.size(), 0, [&](uint32_t begin, uint32_t end)
+			{
+				PC_PROFILE_SCOPE("GenerateFontAtlas");
+
+				msdf_atlas::GeneratorAttributes attributes;
+				attributes.config.overlapSupport = true;
+				attributes.scanlinePass = true;
+
+				for (uint32_t i = begin; i < end; i++)
+				{
+					const msdf_atlas::GlyphGeometry& glyph = glyphs[i];
+					if (glyph.isWhitespace())
+						continue;
+
+					int l, b, w, h;
+					glyph.getBoxRect(l, b, w, h);
+					msdfgen::Bitmap<S, N> glyphBitmap(w, h);
+					GenFunc(glyphBitmap, glyph, attributes);
+					msdf_atlas::blit(atlas, (msdfgen::BitmapConstRef<S, N>)glyphBitmap, l, b, 0, 0, w, h);
+				}
+			});
+
+		return pixels;
+	}
+
+	/// <summary>
+	/// Create the font atlas texture from RGB8 pixels
+	/// </summary>
+	static Ref<Texture2D> CreateAtlasTexture(const uint8_t* pixels, uint32_t width, uint32_t height)
 	{
 		PC_PROFILE_FUNCTION();
 
+		TextureSpecification spec;
+		spec.Width = width;
+		spec.Height = height;
+		spec.Format = ImageFormat::RGB8;
+		spec.GenerateMips = false;
+		spec.Filter = TextureFilter::LINEAR;
+
+		Ref<Texture2D> texture = Texture2D::Create(spec);
+		texture->SetData((void*)pixels, width * height * 3);
+		return texture;
+	}
+
+	/// <summary>
+	/// A glyph rasterized by the glyph rasterizer, ready to be uploaded to a glyph page
+	/// </summary>
+	struct RasterizedGlyph
+	{
+		uint32_t Codepoint = 0;
+		bool Found = false; // False if the font has no glyph for the codepoint
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		glm::vec2 QuadMin = { 0.0f, 0.0f };
+		glm::vec2 QuadMax = { 0.0f, 0.0f };
+		float Advance = 0.0f;
+		std::vector<uint8_t> Pixels; // RGB8
+	};
+
+	/// <summary>
+	/// Rasterize a single glyph with the same settings as the preloaded atlas
+	/// </summary>
+	static RasterizedGlyph RasterizeGlyph(msdfgen::FontHandle* font, uint32_t codepoint, double geometryScale, double fsScale)
+	{
+		RasterizedGlyph result;
+		result.Codepoint = codepoint;
+
+		msdf_atlas::GlyphGeometry glyph;
+		if (!font || !glyph.load(font, geometryScale, codepoint))
+			return result;
+		result.Found = true;
+
+		glyph.edgeColoring(msdfgen::edgeColoringInkTrap, 3.0, 0);
+		glyph.wrapBox(s_EmSize, s_PixelRange / s_EmSize, s_MiterLimit);
+		result.Advance = (float)(fsScale * glyph.getAdvance());
+
+		// Whitespace has no box, so there is nothing to rasterize
+		int width, height;
+		glyph.getBoxSize(width, height);
+		if (width <= 0 || height <= 0)
+			return result;
+
+		double pl, pb, pr, pt;
+		glyph.getQuadPlaneBounds(pl, pb, pr, pt);
+		result.QuadMin = { (float)(pl * fsScale), (float)(pb * fsScale) };
+		result.QuadMax = { (float)(pr * fsScale), (float)(pt * fsScale) };
+
 		msdf_atlas::GeneratorAttributes attributes;
 		attributes.config.overlapSupport = true;
 		attributes.scanlinePass = true;
 
-		msdf_atlas::ImmediateAtlasGenerator<S, N, GenFunc, msdf_atlas::BitmapAtlasStorage<T, N>> generator(width, height);
+		msdfgen::Bitmap<float, 3> bitmap(width, height);
+		msdf_atlas::msdfGenerator(bitmap, glyph, attributes);
+
+		result.Width = (uint32_t)width;
+		result.Height = (uint32_t)height;
+		result.Pixels.resize((size_t)width * height * 3);
+		uint8_t* pixel = result.Pixels.data();
+		for (int y = 0; y < height; y++)
 		{
-			PC_PROFILE_SCOPE("GenerateFontAtlas");
-			generator.setAttributes(attributes);
-			generator.setThreadCount(8);
-			generator.generate(glyphs.data(), (int)glyphs.size());
+			for (int x = 0; x < width; x++)
+			{
+				const float* value = bitmap(x, y);
+				for (int channel = 0; channel < 3; channel++)
+					*pixel++ = (uint8_t)std::clamp(256.0f * value[channel], 0.0f, 255.0f);
+			}
 		}
+		return result;
+	}
+
+	/// <summary>
+	/// Rasterizes glyphs outside of the preloaded charset on the job system. FreeType handles can not be
+	/// used by two threads at once, so the rasterizer loads the font itself and only one of its jobs is
+	/// scheduled at a time. The job rasterizes requests until there are none left, then ends
+	/// </summary>
+	struct GlyphRasterizer
+	{
+		std::filesystem::path Filepath;
+
+		std::mutex Mutex;
+		std::deque<uint32_t> Requests;
+		std::vector<RasterizedGlyph> Finished;
+		bool JobScheduled = false;
+		bool Stop = false;
+		JobCounter Counter;
 
-		msdfgen::BitmapConstRef<T, N> bitmap = (msdfgen::BitmapConstRef<T, N>)generator.atlasStorage();
+		// Loaded by the first job and only used by the jobs
+		msdfgen::FreetypeHandle* FreeType = nullptr;
+		msdfgen::FontHandle* FontFace = nullptr;
+		double GeometryScale = 1.0;
+		double FsScale = 1.0;
+		bool Loaded = false;
 
+		GlyphRasterizer(const std::filesystem::path& filepath)
+			: Filepath(filepath)
 		{
-			PC_PROFILE_SCOPE("CreateFontTexture");
-			TextureSpecification spec;
-			spec.Width = bitmap.width;
-			spec.Height = bitmap.height;
-			spec.Format = ImageFormat::RGB8;
-			spec.GenerateMips = false;
-			spec.Filter = TextureFilter::LINEAR;
+		}
+
+		~GlyphRasterizer()
+		{
+			{
+				std::lock_guard<std::mutex> lock(Mutex);
+				Stop = true;
+			}
+			JobSystem::Wait(Counter);
 
-			Ref<Texture2D> texture = Texture2D::Create(spec);
-			texture->SetData((void*)bitmap.pixels, bitmap.width * bitmap.height * 3);
-			return texture;
+			if (FontFace)
+				msdfgen::destroyFont(FontFace);
+			if (FreeType)
+				msdfgen::deinitializeFreetype(FreeType);
 		}
-	}
+
+		void Request(uint32_t codepoint)
+		{
+			{
+				std::lock_guard<std::mutex> lock(Mutex);
+				Requests.push_back(codepoint);
+				if (JobScheduled)
+					return;
+				JobScheduled = true;
+			}
+
+			// Scheduled without the lock held, as the job runs straight away when the job system is not running
+			JobSystem::Schedule([this]() { Run(); }, &Counter);
+		}
+
+		void Load()
+		{
+			FreeType = msdfgen::initializeFreetype();
+			std::string fileString = Filepath.string();
+			FontFace = FreeType ? msdfgen::loadFont(FreeType, fileString.c_str()) : nullptr;
+			if (!FontFace)
+				PC_CORE_ERROR("Glyph rasterizer failed to load font: {}", fileString);
+
+			// Scale the glyphs the same way FontGeometry::loadCharset does for the preloaded glyphs
+			msdfgen::FontMetrics metrics;
+			if (FontFace && msdfgen::getFontMetrics(metrics, FontFace))
+			{
+				if (metrics.emSize <= 0.0)
+					metrics.emSize = 32.0;
+				GeometryScale = 1.0 / metrics.emSize;
+				FsScale = 1.0 / ((metrics.ascenderY - metrics.descenderY) * GeometryScale);
+			}
+			Loaded = true;
+		}
+
+		void Run()
+		{
+			PC_PROFILE_FUNCTION();
+
+			if (!Loaded)
+				Load();
+
+			while (true)
+			{
+				uint32_t codepoint;
+				{
+					std::lock_guard<std::mutex> lock(Mutex);
+					if (Stop || Requests.empty())
+					{
+						JobScheduled = false;
+						return;
+					}
+
+					codepoint = Requests.front();
+					Requests.pop_front();
+				}
+
+				RasterizedGlyph glyph = RasterizeGlyph(FontFace, codepoint, GeometryScale, FsScale);
+
+				std::lock_guard<std::mutex> lock(Mutex);
+				Finished.push_back(std::move(glyph));
+			}
+		}
+	};
 
 	Font::Font(const std::filesystem::path& filepath)
-		: m_Data(new MSDFData())
+		: m_Data(new MSDFData()), m_Filepath(filepath)
 	{
 		PC_PROFILE_FUNCTION();
 
+		// Page 0 is the atlas of the preloaded charset, which is stored separately
+		m_Pages.emplace_back();
+
+		std::string fileString = filepath.string();
+
+		// The cache key covers everything that changes the generated atlas, so a cache made from an
+		// older version of the font file or with different settings is never used
+		uint64_t cacheKey;
+		{
+			MappedFile fontFile(filepath);
+			if (!fontFile.IsOpen())
+			{
+				PC_CORE_ERROR("Failed to load font: {}", fileString);
+				return;
+			}
+
+			cacheKey = HashBytes(fontFile.GetData(), fontFile.GetSize());
+			cacheKey = HashBytes(s_CharsetRanges, sizeof(s_CharsetRanges), cacheKey);
+			cacheKey = HashBytes(&s_EmSize, sizeof(s_EmSize), cacheKey);
+			cacheKey = HashBytes(&s_PixelRange, sizeof(s_PixelRange), cacheKey);
+		}
+
+		// The cache file is named with a hash of the path and the settings as well, so fonts with the same
+		// file name in different folders do not overwrite each others cache
+		std::string normalPath = filepath.lexically_normal().generic_string();
+		uint64_t nameHash = HashBytes(normalPath.data(), normalPath.size());
+		nameHash = HashBytes(s_CharsetRanges, sizeof(s_CharsetRanges), nameHash);
+		nameHash = HashBytes(&s_EmSize, sizeof(s_EmSize), nameHash);
+		nameHash = HashBytes(&s_PixelRange, sizeof(s_PixelRange), nameHash);
+
+		char cacheName[32];
+		snprintf(cacheName, sizeof(cacheName), "-%016llx.pcfont", (unsigned long long)nameHash);
+		std::filesystem::path cachePath = s_FontCacheDirectory / (filepath.stem().string() + cacheName);
+		if (LoadFromCache(cachePath, cacheKey))
+			return;
+
 		// Initialize the FreeType font library
 		msdfgen::FreetypeHandle* ft = msdfgen::initializeFreetype();
 		PC_CORE_ASSERT(ft);
 
-		std::string fileString = filepath.string();
-
 		// Load the font from the passed in file path
 		msdfgen::FontHandle* font = msdfgen::loadFont(ft, fileString.c_str());
 		if (!font)
@@ -66,23 +346,9 @@ namespace Pinecone {
 			return;
 		}
 
-		// Stores the first and last character values
-		struct CharsetRange
-		{
-			uint32_t Begin, End;
-		};
-
-		// Use a character range between 32 (space) and 255 as characters before 
-		// 32 are all special characters that cannot be seen.
-		// Ref: https://www.rapidtables.com/code/text/ascii-table.html
-		static const CharsetRange charsetRanges[] =
-		{
-			{ 0x0020, 0x00FF }
-		};
-
 		// Add the characters in our charset-range to the MSDF atlas charset
 		msdf_atlas::Charset charset;
-		for (CharsetRange range : charsetRanges)
+		for (CharsetRange range : s_CharsetRanges)
 		{
 			for (uint32_t c = range.Begin; c <= range.End; c++)
 				charset.add(c);
@@ -95,11 +361,11 @@ namespace Pinecone {
 		int glyphsLoaded = m_Data->FontGeometry.loadCharset(font, fontScale, charset);
 		PC_CORE_INFO("Loaded {} glyphs from font (out of {})", glyphsLoaded, charset.size());
 
-		double emSize = 40.0;
+		double emSize = s_EmSize;
 
 		msdf_atlas::TightAtlasPacker atlasPacker;
-		atlasPacker.setPixelRange(2.0);
-		atlasPacker.setMiterLimit(1.0);
+		atlasPacker.setPixelRange(s_PixelRange);
+		atlasPacker.setMiterLimit(s_MiterLimit);
 		atlasPacker.setPadding(0);
 		atlasPacker.setScale(emSize);
 		int remaining = atlasPacker.pack(m_Data->Glyphs.data(), (int)m_Data->Glyphs.size());
@@ -107,22 +373,19 @@ namespace Pinecone {
 
 		int width, height;
 		atlasPacker.getDimensions(width, height);
-		emSize = atlasPacker.getScale();
 
 #define DEFAULT_ANGLE_THRESHOLD 3.0
 #define LCG_MULTIPLIER 6364136223846793005ull
 #define LCG_INCREMENT 1442695040888963407ull
-#define THREAD_COUNT 8
 
 		uint64_t coloringSeed = 0;
 		bool expensiveColoring = false;
 		if (expensiveColoring)
 		{
-			msdf_atlas::Workload([&glyphs = m_Data->Glyphs, &coloringSeed](int i, int threadNo) -> bool {
+			JobSystem::ParallelFor((uint32_t)m_Data->Glyphs.size(), [&glyphs = m_Data->Glyphs, &coloringSeed](uint32_t i) {
 				unsigned long long glyphSeed = (LCG_MULTIPLIER * (coloringSeed ^ i) + LCG_INCREMENT) * !!coloringSeed;
 				glyphs[i].edgeColoring(msdfgen::edgeColoringInkTrap, DEFAULT_ANGLE_THRESHOLD, glyphSeed);
-				return true;
-			}, m_Data->Glyphs.size()).finish(THREAD_COUNT);
+			});
 		}
 		else {
 			unsigned long long glyphSeed = coloringSeed;
@@ -133,12 +396,93 @@ namespace Pinecone {
 			}
 		}
 
-		m_AtlasTexture = CreateAndCacheAtlas<uint8_t, float, 3, msdf_atlas::msdfGenerator>("FontTest", (float)emSize, m_Data->Glyphs, m_Data->FontGeometry, width, height);
+		std::vector<uint8_t> atlasPixels = GenerateAtlas<uint8_t, float, 3, msdf_atlas::msdfGenerator>(m_Data->Glyphs, width, height);
+		m_AtlasTexture = CreateAtlasTexture(atlasPixels.data(), width, height);
+		BuildGlyphTable();
+		WriteCache(cachePath, cacheKey, atlasPixels.data());
 
 		msdfgen::destroyFont(font);
 		msdfgen::deinitializeFreetype(ft);
 	}
 
+	bool Font::LoadFromCache(const std::filesystem::path& cachePath, uint64_t key)
+	{
+		PC_PROFILE_FUNCTION();
+
+		MappedFile file(cachePath);
+		if (!file.IsOpen() || file.GetSize() < sizeof(FontCacheHeader))
+			return false;
+
+		FontCacheHeader header;
+		memcpy(&header, file.GetData(), sizeof(FontCacheHeader));
+		if (header.Magic != FontCacheHeader::CurrentMagic || header.Version != FontCacheHeader::CurrentVersion || header.Key != key)
+		{
+			PC_CORE_INFO("Font cache {} is out of date, regenerating it", cachePath.string());
+			return false;
+		}
+
+		const size_t glyphsSize = header.GlyphCount * sizeof(FontGlyph);
+		const size_t glyphLookupSize = header.GlyphLookupCount * sizeof(int32_t);
+		const size_t kerningPairsSize = header.KerningPairCount * sizeof(FontKerningPair);
+		const size_t atlasSize = (size_t)header.AtlasWidth * header.AtlasHeight * 3;
+		if (file.GetSize() != sizeof(FontCacheHeader) + glyphsSize + glyphLookupSize + kerningPairsSize + atlasSize)
+		{
+			PC_CORE_WARN("Font cache {} is corrupt, regenerating it", cachePath.string());
+			return false;
+		}
+
+		const uint8_t* data = file.GetData() + sizeof(FontCacheHeader);
+		m_Glyphs.resize(header.GlyphCount);
+		memcpy(m_Glyphs.data(), data, glyphsSize);
+		data += glyphsSize;
+
+		m_GlyphLookup.resize(header.GlyphLookupCount);
+		memcpy(m_GlyphLookup.data(), data, glyphLookupSize);
+		data += glyphLookupSize;
+
+		m_KerningPairs.resize(header.KerningPairCount);
+		memcpy(m_KerningPairs.data(), data, kerningPairsSize);
+		data += kerningPairsSize;
+
+		m_LineHeight = header.LineHeight;
+
+		// Upload the atlas straight from the mapped file
+		m_AtlasTexture = CreateAtlasTexture(data, header.AtlasWidth, header.AtlasHeight);
+		return true;
+	}
+
+	void Font::WriteCache(const std::filesystem::path& cachePath, uint64_t key, const uint8_t* atlasPixels) const
+	{
+		PC_PROFILE_FUNCTION();
+
+		std::error_code error;
+		std::filesystem::create_directories(cachePath.parent_path(), error);
+
+		std::ofstream out(cachePath, std::ios::out | std::ios::binary);
+		if (!out)
+		{
+			PC_CORE_WARN("Could not write font cache {}", cachePath.string());
+			return;
+		}
+
+		FontCacheHeader header;
+		header.Magic = FontCacheHeader::CurrentMagic;
+		header.Version = FontCacheHeader::CurrentVersion;
+		header.Key = key;
+		header.AtlasWidth = m_AtlasTexture->GetWidth();
+		header.AtlasHeight = m_AtlasTexture->GetHeight();
+		header.GlyphCount = (uint32_t)m_Glyphs.size();
+		header.GlyphLookupCount = (uint32_t)m_GlyphLookup.size();
+		header.KerningPairCount = (uint32_t)m_KerningPairs.size();
+		header.LineHeight = m_LineHeight;
+
+		out.write((const char*)&header, sizeof(FontCacheHeader));
+		out.write((const char*)m_Glyphs.data(), m_Glyphs.size() * sizeof(FontGlyph));
+		out.write((const char*)m_GlyphLookup.data(), m_GlyphLookup.size() * sizeof(int32_t));
+		out.write((const char*)m_KerningPairs.data(), m_KerningPairs.size() * sizeof(FontKerningPair));
+		out.write((const char*)atlasPixels, (size_t)header.AtlasWidth * header.AtlasHeight * 3);
+	}
+
 	Font::~Font()
 	{
 		PC_PROFILE_FUNCTION();
@@ -146,6 +490,262 @@ namespace Pinecone {
 		delete m_Data;
 	}
 
+	void Font::BuildGlyphTable()
+	{
+		PC_PROFILE_FUNCTION();
+
+		const auto& metrics = m_Data->FontGeometry.getMetrics();
+		// Scale everything so that a line of text is 1 unit high
+		double fsScale = 1.0 / (metrics.ascenderY - metrics.descenderY);
+		m_LineHeight = (float)(fsScale * metrics.lineHeight);
+
+		float texelWidth = 1.0f / m_AtlasTexture->GetWidth();
+		float texelHeight = 1.0f / m_AtlasTexture->GetHeight();
+
+		// The kerning table uses the glyph indices of the font file, so keep track of where they end up
+		std::unordered_map<int, uint32_t> fontIndexToGlyph;
+
+		m_Glyphs.clear();
+		m_Glyphs.reserve(m_Data->Glyphs.size());
+		m_GlyphLookup.clear();
+		for (const msdf_atlas::GlyphGeometry& geometry : m_Data->Glyphs)
+		{
+			FontGlyph glyph;
+
+			double al, ab, ar, at;
+			geometry.getQuadAtlasBounds(al, ab, ar, at);
+			glyph.TexCoordMin = { (float)al * texelWidth, (float)ab * texelHeight };
+			glyph.TexCoordMax = { (float)ar * texelWidth, (float)at * texelHeight };
+
+			double pl, pb, pr, pt;
+			geometry.getQuadPlaneBounds(pl, pb, pr, pt);
+			glyph.QuadMin = { (float)(pl * fsScale), (float)(pb * fsScale) };
+			glyph.QuadMax = { (float)(pr * fsScale), (float)(pt * fsScale) };
+
+			glyph.Advance = (float)(fsScale * geometry.getAdvance());
+			glyph.Page = 0;
+			glyph.KerningBegin = 0;
+			glyph.KerningCount = 0;
+
+			uint32_t index = (uint32_t)m_Glyphs.size();
+			uint32_t codepoint = geometry.getCodepoint();
+			if (codepoint >= m_GlyphLookup.size())
+				m_GlyphLookup.resize(codepoint + 1, -1);
+			m_GlyphLookup[codepoint] = (int32_t)index;
+			fontIndexToGlyph[geometry.getIndex()] = index;
+
+			m_Glyphs.push_back(glyph);
+		}
+
+		// The kerning map is sorted by the pair of font glyph indices, so group the pairs by the glyph
+		// they start with, then sort each group so that it can be binary searched
+		std::vector<std::vector<FontKerningPair>> kerningByGlyph(m_Glyphs.size());
+		for (const auto& [pair, offset] : m_Data->FontGeometry.getKerning())
+		{
+			auto first = fontIndexToGlyph.find(pair.first);
+			auto second = fontIndexToGlyph.find(pair.second);
+			if (first == fontIndexToGlyph.end() || second == fontIndexToGlyph.end())
+				continue;
+
+			kerningByGlyph[first->second].push_back({ second->second, (float)(fsScale * offset) });
+		}
+
+		m_KerningPairs.clear();
+		for (uint32_t i = 0; i < m_Glyphs.size(); i++)
+		{
+			auto& pairs = kerningByGlyph[i];
+			std::sort(pairs.begin(), pairs.end(), [](const FontKerningPair& a, const FontKerningPair& b) { return a.NextGlyph < b.NextGlyph; });
+
+			m_Glyphs[i].KerningBegin = (uint32_t)m_KerningPairs.size();
+			m_Glyphs[i].KerningCount = (uint32_t)pairs.size();
+			m_KerningPairs.insert(m_KerningPairs.end(), pairs.begin(), pairs.end());
+		}
+
+		PC_CORE_INFO("Built font glyph table with {} glyphs and {} kerning pairs", m_Glyphs.size(), m_KerningPairs.size());
+	}
+
+	int32_t Font::GetGlyphIndex(uint32_t codepoint) const
+	{
+		if (codepoint < m_GlyphLookup.size())
+			return m_GlyphLookup[codepoint];
+
+		auto it = m_DynamicGlyphLookup.find(codepoint);
+		return it != m_DynamicGlyphLookup.end() ? (int32_t)it->second : -1;
+	}
+
+	void Font::RequestGlyph(uint32_t codepoint)
+	{
+		// Characters in the range of the preloaded charset that are not loaded are not in the font.
+		// Other characters are only requested once, even if the font does not have them
+		if (codepoint < m_GlyphLookup.size() || !m_RequestedGlyphs.insert(codepoint).second)
+			return;
+
+		// Only create the rasterizer once it is actually needed
+		if (!m_Rasterizer)
+			m_Rasterizer = CreateScope<GlyphRasterizer>(m_Filepath);
+
+		m_Rasterizer->Request(codepoint);
+	}
+
+	void Font::UploadRasterizedGlyphs()
+	{
+		if (!m_Rasterizer)
+			return;
+
+		std::vector<RasterizedGlyph> finished;
+		{
+			std::lock_guard<std::mutex> lock(m_Rasterizer->Mutex);
+			if (m_Rasterizer->Finished.empty())
+				return;
+			finished.swap(m_Rasterizer->Finished);
+		}
+
+		PC_PROFILE_FUNCTION();
+
+		for (const RasterizedGlyph& rasterized : finished)
+		{
+			// Glyphs the font does not have stay in the requested set, so they are not requested again
+			if (!rasterized.Found)
+				continue;
+
+			FontGlyph glyph = {};
+			glyph.QuadMin = rasterized.QuadMin;
+			glyph.QuadMax = rasterized.QuadMax;
+			glyph.Advance = rasterized.Advance;
+			glyph.Page = 0;
+
+			if (rasterized.Width > 0)
+			{
+				uint32_t x, y;
+				glyph.Page = AllocateGlyph(rasterized.Width, rasterized.Height, x, y);
+				m_Pages[glyph.Page].Texture->SetSubData(rasterized.Pixels.data(), x, y, rasterized.Width, rasterized.Height);
+				m_Pages[glyph.Page].Codepoints.push_back(rasterized.Codepoint);
+
+				// Sample from the centers of the edge pixels, the same as msdf-atlas-gen does
+				float texelSize = 1.0f / s_GlyphPageSize;
+				glyph.TexCoordMin = { (x + 0.5f) * texelSize, (y + 0.5f) * texelSize };
+				glyph.TexCoordMax = { (x + rasterized.Width - 0.5f) * texelSize, (y + rasterized.Height - 0.5f) * texelSize };
+			}
+
+			uint32_t index;
+			if (!m_FreeGlyphs.empty())
+			{
+				index = m_FreeGlyphs.back();
+				m_FreeGlyphs.pop_back();
+				m_Glyphs[index] = glyph;
+			}
+			else
+			{
+				index = (uint32_t)m_Glyphs.size();
+				m_Glyphs.push_back(glyph);
+			}
+
+			m_DynamicGlyphLookup[rasterized.Codepoint] = index;
+			m_RequestedGlyphs.erase(rasterized.Codepoint);
+		}
+	}
+
+	uint32_t Font::AllocateGlyph(uint32_t width, uint32_t height, uint32_t& x, uint32_t& y)
+	{
+		PC_CORE_ASSERT(width <= s_GlyphPageSize && height <= s_GlyphPageSize, "Glyph is larger than a glyph page!");
+
+		// Put the glyph at the end of the current shelf, or start a new shelf above it
+		auto fitOnShelf = [&](GlyphPage& page) -> bool
+		{
+			if (page.ShelfX + width > s_GlyphPageSize)
+			{
+				page.ShelfY += page.ShelfHeight;
+				page.ShelfX = 0;
+				page.ShelfHeight = 0;
+			}
+			if (page.ShelfY + height > s_GlyphPageSize)
+				return false;
+
+			x = page.ShelfX;
+			y = page.ShelfY;
+			// Leave a pixel between glyphs so they do not bleed into each other when filtered
+			page.ShelfX += width + 1;
+			page.ShelfHeight = std::max(page.ShelfHeight, height + 1);
+			return true;
+		};
+
+		uint32_t pageCount = 0;
+		for (uint32_t i = 1; i < m_Pages.size(); i++)
+		{
+			if (!m_Pages[i].Texture)
+				continue;
+			if (fitOnShelf(m_Pages[i]))
+				return i;
+			pageCount++;
+		}
+
+		// Every page is full, evict the least recently used pages until a new page fits in the budget
+		while (pageCount > 0 && (pageCount + 1) * s_GlyphPageBytes > s_GlyphCacheBudget)
+		{
+			uint32_t leastRecentlyUsed = 0;
+			for (uint32_t i = 1; i < m_Pages.size(); i++)
+			{
+				if (m_Pages[i].Texture && (leastRecentlyUsed == 0 || m_Pages[i].LastUsed < m_Pages[leastRecentlyUsed].LastUsed))
+					leastRecentlyUsed = i;
+			}
+
+			EvictPage(leastRecentlyUsed);
+			pageCount--;
+		}
+
+		// Reuse the slot of an evicted page if there is one
+		uint32_t page = 1;
+		while (page < m_Pages.size() && m_Pages[page].Texture)
+			page++;
+		if (page == m_Pages.size())
+			m_Pages.emplace_back();
+
+		TextureSpecification spec;
+		spec.Width = s_GlyphPageSize;
+		spec.Height = s_GlyphPageSize;
+		spec.Format = ImageFormat::RGB8;
+		spec.GenerateMips = false;
+		spec.Filter = TextureFilter::LINEAR;
+
+		// Clear the page so the space between glyphs is empty
+		std::vector<uint8_t> clear(s_GlyphPageBytes, 0);
+		m_Pages[page].Texture = Texture2D::Create(spec);
+		m_Pages[page].Texture->SetData(clear.data(), (uint32_t)clear.size());
+		m_Pages[page].LastUsed = ++m_PageUseCounter;
+
+		fitOnShelf(m_Pages[page]);
+		return page;
+	}
+
+	void Font::EvictPage(uint32_t page)
+	{
+		PC_PROFILE_FUNCTION();
+
+		// The glyphs in the page have to be rasterized again the next time they are drawn
+		for (uint32_t codepoint : m_Pages[page].Codepoints)
+		{
+			auto it = m_DynamicGlyphLookup.find(codepoint);
+			m_FreeGlyphs.push_back(it->second);
+			m_DynamicGlyphLookup.erase(it);
+		}
+
+		// The renderer may still be holding on to the texture for the current batch,
+		// so it is only deleted once nothing uses it anymore
+		m_Pages[page] = GlyphPage();
+	}
+
+	float Font::GetKerning(uint32_t glyph, uint32_t nextGlyph) const
+	{
+		const FontGlyph& first = m_Glyphs[glyph];
+		auto begin = m_KerningPairs.begin() + first.KerningBegin;
+		auto end = begin + first.KerningCount;
+
+		auto it = std::lower_bound(begin, end, nextGlyph, [](const FontKerningPair& pair, uint32_t next) { return pair.NextGlyph < next; });
+		if (it != end && it->NextGlyph == nextGlyph)
+			return it->Offset;
+		return 0.0f;
+	}
+
 	Ref<Font> Font::GetDefault()
 	{
 		if (!s_DefaultFont)
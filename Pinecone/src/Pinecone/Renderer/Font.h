@@ -4,10 +4,40 @@
 #include "Pinecone/Renderer/Texture2D.h"
 
 #include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <glm/glm.hpp>
 
 namespace Pinecone
 {
 	struct MSDFData;
+	struct GlyphRasterizer;
+
+	/// <summary>
+	/// A glyph of a font with everything needed to draw it. All sizes are in units of the
+	/// font line height, so they only need to be scaled by the text transform
+	/// </summary>
+	struct FontGlyph
+	{
+		glm::vec2 TexCoordMin; // Normalized texture coordinates of the glyph in the font atlas
+		glm::vec2 TexCoordMax;
+		glm::vec2 QuadMin;     // The bounds of the glyph quad relative to the pen position
+		glm::vec2 QuadMax;
+		float Advance;         // How far to move the pen after drawing the glyph
+		uint32_t Page;         // The glyph page the glyph is in, page 0 is the atlas of the preloaded charset
+		uint32_t KerningBegin; // The kerning pairs where this glyph comes first
+		uint32_t KerningCount;
+	};
+
+	/// <summary>
+	/// The kerning between a glyph and the glyph after it
+	/// </summary>
+	struct FontKerningPair
+	{
+		uint32_t NextGlyph;
+		float Offset;
+	};
 
 	class Font
 	{
@@ -22,20 +52,74 @@ namespace Pinecone
 		/// </summary>
 		~Font();
 
-		/// <summary>
-		/// Get the MSDF (multi-channel signed distance field) data created fron the font file.
-		/// </summary>
-		/// <remarks>
-		/// Reference https://github.com/Chlumsky/msdfgen
-		/// </remarks>
-		/// <returns>The font MSDF data</returns>
-		const MSDFData* GetMSDFData() const { return m_Data; }
 		/// <summary>
 		/// Get the font atlas texture generated from the font file
 		/// </summary>
 		/// <returns>The font atlas texture</returns>
 		Ref<Texture2D> GetAtlasTexture() const { return m_AtlasTexture; }
 
+		/// <summary>
+		/// Get the texture of a glyph page
+		/// </summary>
+		/// <param name="page">The page index, page 0 is the atlas of the preloaded charset</param>
+		/// <returns>The page texture</returns>
+		const Ref<Texture2D>& GetPageTexture(uint32_t page) const { return page == 0 ? m_AtlasTexture : m_Pages[page].Texture; }
+
+		/// <summary>
+		/// Get the index of the glyph for a character
+		/// </summary>
+		/// <param name="codepoint">The unicode codepoint of the character</param>
+		/// <returns>The glyph index, or -1 if the glyph is not loaded</returns>
+		int32_t GetGlyphIndex(uint32_t codepoint) const;
+		/// <summary>
+		/// Get a glyph from the glyph table
+		/// </summary>
+		/// <param name="index">The glyph index</param>
+		/// <returns>The glyph</returns>
+		const FontGlyph& GetGlyph(uint32_t index) const { return m_Glyphs[index]; }
+		/// <summary>
+		/// Get the kerning offset to add to the advance of a glyph when it is followed by another glyph
+		/// </summary>
+		/// <param name="glyph">The glyph index</param>
+		/// <param name="nextGlyph">The index of the glyph after it</param>
+		/// <returns>The kerning offset, 0 if the pair has no kerning</returns>
+		float GetKerning(uint32_t glyph, uint32_t nextGlyph) const;
+		/// <summary>
+		/// Get the distance between two lines of text
+		/// </summary>
+		/// <returns>The line height</returns>
+		float GetLineHeight() const { return m_LineHeight; }
+
+		/// <summary>
+		/// Request a glyph that is not loaded. Glyphs outside of the preloaded charset are rasterized
+		/// on the job system into glyph pages, the glyph can be drawn once it has been uploaded
+		/// </summary>
+		/// <param name="codepoint">The unicode codepoint of the character</param>
+		void RequestGlyph(uint32_t codepoint);
+		/// <summary>
+		/// Upload the glyphs the job system has finished rasterizing, evicting the least
+		/// recently used glyph pages if the glyph cache budget is exceeded. Must be called on the
+		/// render thread, Renderer2D::DrawString calls this before drawing
+		/// </summary>
+		void UploadRasterizedGlyphs();
+		/// <summary>
+		/// Mark a glyph page as used, so it is not evicted before pages that have not been used for longer
+		/// </summary>
+		/// <param name="page">The page index</param>
+		void TouchPage(uint32_t page) { m_Pages[page].LastUsed = ++m_PageUseCounter; }
+
+		/// <summary>
+		/// Set how much memory the glyph pages of each font can use before the least recently
+		/// used page is evicted. The atlas of the preloaded charset does not count towards this
+		/// </summary>
+		/// <param name="bytes">The budget in bytes</param>
+		static void SetGlyphCacheBudget(size_t bytes) { s_GlyphCacheBudget = bytes; }
+		/// <summary>
+		/// Get how much memory the glyph pages of each font can use
+		/// </summary>
+		/// <returns>The budget in bytes</returns>
+		static size_t GetGlyphCacheBudget() { return s_GlyphCacheBudget; }
+
 		/// <summary>
 		/// Get the default font
 		/// </summary>
@@ -49,9 +133,73 @@ namespace Pinecone
 		/// <returns>A shared pointer to a new Font</returns>
 		static Ref<Font> Create(const std::filesystem::path& font);
 	private:
+		/// <summary>
+		/// Build the glyph and kerning tables from the MSDF data
+		/// </summary>
+		void BuildGlyphTable();
+		/// <summary>
+		/// Load the glyph tables and the atlas from a font cache file
+		/// </summary>
+		/// <param name="cachePath">The cache file path</param>
+		/// <param name="key">The key the cache must have been written with</param>
+		/// <returns>True if the cache was loaded, false if it is missing or out of date</returns>
+		bool LoadFromCache(const std::filesystem::path& cachePath, uint64_t key);
+		/// <summary>
+		/// Write the glyph tables and the atlas to a font cache file
+		/// </summary>
+		/// <param name="cachePath">The cache file path</param>
+		/// <param name="key">The cache key</param>
+		/// <param name="atlasPixels">The RGB8 atlas pixels</param>
+		void WriteCache(const std::filesystem::path& cachePath, uint64_t key, const uint8_t* atlasPixels) const;
+		/// <summary>
+		/// Find room for a glyph in the glyph pages, creating a new page if none of them have room
+		/// </summary>
+		/// <param name="width">The glyph width in pixels</param>
+		/// <param name="height">The glyph height in pixels</param>
+		/// <param name="x">The x position of the glyph in the page</param>
+		/// <param name="y">The y position of the glyph in the page</param>
+		/// <returns>The page index</returns>
+		uint32_t AllocateGlyph(uint32_t width, uint32_t height, uint32_t& x, uint32_t& y);
+		/// <summary>
+		/// Remove a glyph page and every glyph in it
+		/// </summary>
+		/// <param name="page">The page index</param>
+		void EvictPage(uint32_t page);
+	private:
+		// Glyphs are packed into a page in rows (shelves) from the bottom up
+		struct GlyphPage
+		{
+			Ref<Texture2D> Texture; // Null if the page was evicted and can be reused
+			uint32_t ShelfX = 0;
+			uint32_t ShelfY = 0;
+			uint32_t ShelfHeight = 0;
+			uint64_t LastUsed = 0;
+			std::vector<uint32_t> Codepoints;
+		};
+
 		MSDFData* m_Data;
 		Ref<Texture2D> m_AtlasTexture;
+		std::filesystem::path m_Filepath;
+
+		std::vector<FontGlyph> m_Glyphs;
+		// Maps a codepoint to its index in m_Glyphs, or -1 if the font has no glyph for it
+		std::vector<int32_t> m_GlyphLookup;
+		// Sorted by first glyph, then by next glyph
+		std::vector<FontKerningPair> m_KerningPairs;
+		float m_LineHeight = 0.0f;
+
+		// Glyphs that are not in the preloaded charset
+		std::unordered_map<uint32_t, uint32_t> m_DynamicGlyphLookup;
+		// Codepoints that have been requested but are not loaded, either still rasterizing or not in the font
+		std::unordered_set<uint32_t> m_RequestedGlyphs;
+		// Glyph table entries freed by evicted pages
+		std::vector<uint32_t> m_FreeGlyphs;
+		// Page 0 is a placeholder for the atlas of the preloaded charset
+		std::vector<GlyphPage> m_Pages;
+		uint64_t m_PageUseCounter = 0;
+		Scope<GlyphRasterizer> m_Rasterizer;
 	private:
 		static Ref<Font> s_DefaultFont;
+		static size_t s_GlyphCacheBudget;
 	};
 }
\ No newline at end of file
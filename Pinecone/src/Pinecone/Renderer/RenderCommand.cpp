@@ -2,6 +2,7 @@
 #include "RenderCommand.h"
 
 #include <glad/glad.h>
+#include <glm/gtc/type_ptr.hpp>
 
 namespace Pinecone
 {
@@ -42,9 +43,8 @@ namespace Pinecone
 		glEnable(GL_BLEND);
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-		// Enable depth testing and anti-aliasing of lines
+		// Enable depth testing
 		glEnable(GL_DEPTH_TEST);
-		glEnable(GL_LINE_SMOOTH);
 	}
 
 	void RenderCommand::SetViewport(int x, int y, int width, int height)
@@ -52,6 +52,13 @@ namespace Pinecone
 		glViewport(x, y, width, height);
 	}
 
+	glm::ivec4 RenderCommand::GetViewport()
+	{
+		glm::ivec4 viewport;
+		glGetIntegerv(GL_VIEWPORT, glm::value_ptr(viewport));
+		return viewport;
+	}
+
 	void RenderCommand::SetClearColor(const glm::vec4& color)
 	{
 		glClearColor(color.r, color.g, color.b, color.a);
@@ -62,24 +69,20 @@ namespace Pinecone
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	}
 
-	void RenderCommand::DrawIndexed(const Ref<VertexArray>& vertexArray, uint32_t indexCount)
+	void RenderCommand::DrawIndexed(const Ref<VertexArray>& vertexArray, uint32_t indexCount, uint32_t baseVertex)
 	{
 		// Bind the vertex array
 		vertexArray->Bind();
 		// Get the count of the total number of indices from either the vertex array or the specified index count
 		uint32_t count = indexCount ? indexCount : vertexArray->GetIndexBuffer()->GetCount();
 		// Draw the elements with OpenGL
-		glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, nullptr);
+		glDrawElementsBaseVertex(GL_TRIANGLES, count, GL_UNSIGNED_INT, nullptr, baseVertex);
 	}
 
-	void RenderCommand::DrawLines(const Ref<VertexArray>& vertexArray, uint32_t vertexCount)
+	void RenderCommand::DrawInstanced(const Ref<VertexArray>& vertexArray, uint32_t vertexCount, uint32_t instanceCount, uint32_t baseInstance)
 	{
+		// Bind the vertex array and draw the instances with OpenGL
 		vertexArray->Bind();
-		glDrawArrays(GL_LINES, 0, vertexCount);
-	}
-
-	void RenderCommand::SetLineWidth(float width)
-	{
-		glLineWidth(width);
+		glDrawArraysInstancedBaseInstance(GL_TRIANGLES, 0, vertexCount, instanceCount, baseInstance);
 	}
 }
\ No newline at end of file
@@ -22,6 +22,11 @@ namespace Pinecone
 		/// <param name="height">The height of the viewport</param>
 		static void SetViewport(int x, int y, int width, int height);
 		/// <summary>
+		/// Get the current OpenGL viewport, including viewports set when binding a framebuffer
+		/// </summary>
+		/// <returns>The lower left corner (x and y) and the size (z and w) of the viewport in pixels</returns>
+		static glm::ivec4 GetViewport();
+		/// <summary>
 		/// Set the color which we should use when the buffer is cleared
 		/// </summary>
 		/// <param name="color">The color to use when clearing the buffers</param>
@@ -38,10 +43,16 @@ namespace Pinecone
 		/// <param name="vertexArray">The vertex data</param>
 		/// <param name="indexCount">The number of indices (set to 0 or leave as default to use 
 		/// the number in the vertex array)</param>
-		static void DrawIndexed(const Ref<VertexArray>& vertexArray, uint32_t indexCount = 0);
-
-		static void DrawLines(const Ref<VertexArray>& vertexArray, uint32_t vertexCount);
+		/// <param name="baseVertex">A constant added to every index, used to draw from a segment of a ring buffer</param>
+		static void DrawIndexed(const Ref<VertexArray>& vertexArray, uint32_t indexCount = 0, uint32_t baseVertex = 0);
 
-		static void SetLineWidth(float width);
+		/// <summary>
+		/// Draw a number of instances of our vertex array data without an index buffer.
+		/// </summary>
+		/// <param name="vertexArray">The vertex data</param>
+		/// <param name="vertexCount">The number of vertices for each instance</param>
+		/// <param name="instanceCount">The number of instances to draw</param>
+		/// <param name="baseInstance">The first instance to read instanced vertex data from</param>
+		static void DrawInstanced(const Ref<VertexArray>& vertexArray, uint32_t vertexCount, uint32_t instanceCount, uint32_t baseInstance = 0);
 	};
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include "Pinecone/Renderer/RenderCommand.h"
 #include "Pinecone/Renderer/Renderer2D.h"
+#include "Pinecone/Renderer/TextureStreamer.h"
 
 namespace Pinecone
 {
@@ -14,10 +15,12 @@ namespace Pinecone
 
 		RenderCommand::Init();
 		Renderer2D::Init();
+		TextureStreamer::Init();
 	}
 
 	void Renderer::Shutdown()
 	{
+		TextureStreamer::Shutdown();
 		Renderer2D::Shutdown();
 	}
 
@@ -26,7 +29,8 @@ namespace Pinecone
 		// Bind the shader and upload our view projection matrix that was setup inside the
 		// BeginScene function from the specified camera
 		shader->Bind();
-		shader->UploadUniformMat4("u_ViewProjection", s_SceneData->ViewProjectionMatrix);
+		static constexpr UniformName viewProjection = "u_ViewProjection";
+		shader->UploadUniformMat4(viewProjection, s_SceneData->ViewProjectionMatrix);
 
 		// Draw our vertex array
 		RenderCommand::DrawIndexed(vertexArray);
@@ -5,11 +5,17 @@
 #include "Pinecone/Renderer/Shader.h"
 #include "Pinecone/Renderer/RenderCommand.h"
 #include "Pinecone/Renderer/UniformBuffer.h"
-#include "Pinecone/Renderer/MSDFData.h"
+#include "Pinecone/Asset/AssetManager.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+// x86-64 always has SSE, other targets fall back to scalar code
+#if defined(_M_X64) || defined(__SSE__)
+	#define PC_RENDERER2D_SSE
+	#include <xmmintrin.h>
+#endif
+
 namespace Pinecone
 {
 	struct QuadVertex
@@ -21,10 +27,38 @@ namespace Pinecone
 		float TilingFactor;
 	};
 
-	struct LineVertex
+	// What an instance of the instanced quad pipeline draws, the Renderer2D_QuadInstanced shader uses the same values
+	enum class ShapeType : int
 	{
-		glm::vec3 Position;
-		glm::vec4 Color;
+		Quad = 0,
+		Circle = 1,
+		RoundedRect = 2
+	};
+
+	// A single quad, circle or rounded rectangle for the instanced quad pipeline. The corners of the
+	// quad are expanded in the vertex shader so only one of these is needed per quad. Shapes are a
+	// signed distance field evaluated per pixel, they share the stream with quads so both are drawn
+	// in the order they were submitted
+	struct QuadInstanceVertex
+	{
+		glm::vec4 TransformRow0; // The first row of the 2D affine transform, w is the depth
+		glm::vec3 TransformRow1; // The second row of the 2D affine transform
+		uint32_t Color;          // RGBA8 packed color
+		glm::vec4 TexRect;       // Texture coordinates of the bottom left (xy) and top right (zw) corners. For shapes
+		                         // the thickness, fade and corner radius of the shape
+		int TexIndex;
+		float TilingFactor;
+		int Shape;               // The ShapeType
+	};
+
+	// A single line segment for the line pipeline. The segment is expanded into a quad with the
+	// width of the line in the vertex shader, the quad is shaped into a line in the fragment shader
+	struct LineInstanceVertex
+	{
+		glm::vec3 Start;
+		glm::vec3 End;
+		uint32_t Color; // RGBA8 packed color
+		float Width;    // In pixels
 	};
 
 	struct TextVertex
@@ -32,6 +66,156 @@ namespace Pinecone
 		glm::vec3 Position;
 		glm::vec4 Color;
 		glm::vec2 TexCoord;
+		float AtlasIndex;
+	};
+
+	/// <summary>
+	/// The part of a quads transform that places its corners. The corners of a quad all have a z
+	/// of 0 and a w of 1, so only the first, second and fourth columns of the transform matter.
+	/// Each member is a row holding the x and y coefficients followed by the translation
+	/// </summary>
+	struct QuadTransform
+	{
+		glm::vec3 X;
+		glm::vec3 Y;
+		glm::vec3 Z;
+	};
+
+	/// <summary>
+	/// Maps texture renderer IDs to the texture slot they are bound to in the current batch.
+	/// It is a small open addressing hash table where every entry is stamped with the
+	/// generation it was added in, so the whole table is cleared by bumping the generation.
+	/// </summary>
+	struct TextureSlotTable
+	{
+		// Must be a power of two and at least twice the number of texture slots to keep probes short
+		static const uint32_t Capacity = 64;
+
+		struct Entry
+		{
+			uint32_t RendererID = 0;
+			uint32_t Generation = 0;
+			uint32_t Slot = 0;
+		};
+
+		std::array<Entry, Capacity> Entries;
+		uint32_t Generation = 1;
+
+		/// <summary>
+		/// Remove every texture from the table
+		/// </summary>
+		void Reset()
+		{
+			// Entries from older generations are treated as empty. Only when the generation
+			// wraps around do the entries have to actually be cleared
+			if (++Generation == 0)
+			{
+				Entries.fill({});
+				Generation = 1;
+			}
+		}
+
+		/// <summary>
+		/// Find the slot a texture is bound to
+		/// </summary>
+		/// <param name="rendererID">The texture renderer ID</param>
+		/// <returns>The texture slot, or -1 if the texture is not in a slot</returns>
+		int32_t Find(uint32_t rendererID) const
+		{
+			for (uint32_t i = Hash(rendererID);; i = (i + 1) & (Capacity - 1))
+			{
+				const Entry& entry = Entries[i];
+				if (entry.Generation != Generation)
+					return -1;
+				if (entry.RendererID == rendererID)
+					return (int32_t)entry.Slot;
+			}
+		}
+
+		/// <summary>
+		/// Add a texture and the slot it is bound to. The texture must not already be in the table
+		/// </summary>
+		/// <param name="rendererID">The texture renderer ID</param>
+		/// <param name="slot">The texture slot</param>
+		void Insert(uint32_t rendererID, uint32_t slot)
+		{
+			uint32_t i = Hash(rendererID);
+			while (Entries[i].Generation == Generation)
+				i = (i + 1) & (Capacity - 1);
+			Entries[i] = { rendererID, Generation, slot };
+		}
+
+		static uint32_t Hash(uint32_t rendererID)
+		{
+			// Fibonacci hashing, renderer IDs are small sequential numbers so spread them out
+			return (rendererID * 2654435769u) >> 26;
+		}
+	};
+
+	// The pipeline a sorted draw command is drawn with, this is part of the sort key
+	enum class SortPipeline : uint8_t
+	{
+		Quad = 0,
+		Text = 1,
+		Shape = 2
+	};
+
+	// A quad recorded for sorted submission
+	struct QuadCommand
+	{
+		QuadTransform Transform;
+		glm::vec4 Color;
+		glm::vec4 TexRect;
+		const Texture2D* Texture; // Null for a plain colored quad
+		float TilingFactor;
+	};
+
+	// A circle or rounded rectangle recorded for sorted submission
+	struct ShapeCommand
+	{
+		QuadTransform Transform;
+		glm::vec4 Color;
+		glm::vec3 Params;
+		ShapeType Shape;
+	};
+
+	// A string recorded for sorted submission. The characters are copied into the text arena, and
+	// the font is not kept alive by the command, just like the texture of a quad command
+	struct TextCommand
+	{
+		uint32_t Offset; // The first character of the string in the text arena
+		uint32_t Length;
+		Font* Font;
+		glm::mat4 Transform;
+		glm::vec4 Color;
+	};
+
+	// The sort key of a draw command and the index of the command in its pipelines command list
+	struct SortItem
+	{
+		uint64_t Key;
+		uint32_t Index;
+	};
+
+	/// <summary>
+	/// The quads drawn by a thread while it is recording. Each context has its own staging
+	/// vertices and texture list so recording threads never touch the shared batch
+	/// </summary>
+	struct RecordingContext
+	{
+		// The TexIndex of each vertex is 0 for the white texture, otherwise it is 1 + the index into Textures
+		std::vector<QuadVertex> Vertices;
+		std::vector<const Texture2D*> Textures;
+		std::unordered_map<uint32_t, uint32_t> TextureLookup;
+		Renderer2D::ContextStatistics Stats;
+
+		void Reset()
+		{
+			Vertices.clear();
+			Textures.clear();
+			TextureLookup.clear();
+			Stats = {};
+		}
 	};
 
 	struct Renderer2DData
@@ -39,7 +223,12 @@ namespace Pinecone
 		static const uint32_t MaxQuads = 20000;
 		static const uint32_t MaxVertices = MaxQuads * 4;
 		static const uint32_t MaxIndices = MaxQuads * 6;
+		static const uint32_t MaxLines = MaxQuads * 4;
 		static const uint32_t MaxTextureSlots = 32;
+		static const uint32_t MaxFontAtlasSlots = 16;
+		// Number of segments in each persistently mapped vertex buffer. Every batch writes into
+		// its own segment so the CPU can fill one while the GPU is still drawing the others
+		static const uint32_t VertexBufferSegments = 3;
 
 		Ref<VertexArray> QuadVertexArray;
 		Ref<VertexBuffer> QuadVertexBuffer;
@@ -50,15 +239,22 @@ namespace Pinecone
 		QuadVertex* QuadVertexBufferBase = nullptr;
 		QuadVertex* QuadVertexBufferPtr = nullptr;
 
+		Ref<VertexArray> QuadInstanceVertexArray;
+		Ref<VertexBuffer> QuadInstanceVertexBuffer;
+		Ref<Shader> QuadInstanceShader;
+
+		bool QuadInstancing = false;
+		uint32_t QuadInstanceCount = 0;
+		QuadInstanceVertex* QuadInstanceBufferBase = nullptr;
+		QuadInstanceVertex* QuadInstanceBufferPtr = nullptr;
+
 		Ref<VertexArray> LineVertexArray;
 		Ref<VertexBuffer> LineVertexBuffer;
 		Ref<Shader> LineShader;
 
-		uint32_t LineVertexCount = 0;
-		LineVertex* LineVertexBufferBase = nullptr;
-		LineVertex* LineVertexBufferPtr = nullptr;
-
-		float LineWidth = 1.0f;
+		uint32_t LineCount = 0;
+		LineInstanceVertex* LineBufferBase = nullptr;
+		LineInstanceVertex* LineBufferPtr = nullptr;
 
 		Ref<VertexArray> TextVertexArray;
 		Ref<VertexBuffer> TextVertexBuffer;
@@ -68,34 +264,606 @@ namespace Pinecone
 		TextVertex* TextVertexBufferBase = nullptr;
 		TextVertex* TextVertexBufferPtr = nullptr;
 
-		std::array<Ref<Texture2D>, MaxTextureSlots> TextureSlots;
+		// The textures are not kept alive by the batch, so copying them in costs no reference count
+		// updates. Whoever drew with a texture has to keep it alive until the end of the scene
+		std::array<const Texture2D*, MaxTextureSlots> TextureSlots = {};
 		uint32_t TextureSlotIndex = 1; // 0 = white texture
+		TextureSlotTable TextureSlotLookup;
+
+		std::array<Ref<Texture2D>, MaxFontAtlasSlots> FontAtlasSlots;
+		uint32_t FontAtlasSlotIndex = 0;
+		TextureSlotTable FontAtlasSlotLookup;
 
-		Ref<Texture2D> FontAtlasTexture;
+		bool SortedSubmission = false;
+		bool ExecutingSortedCommands = false;
+		uint8_t SortLayer = 0;
+		std::vector<SortItem> SortItems;
+		std::vector<SortItem> SortScratch;
+		std::vector<QuadCommand> QuadCommands;
+		std::vector<ShapeCommand> ShapeCommands;
+		std::vector<TextCommand> TextCommands;
+		// The characters of every recorded string, one after another
+		std::vector<char> TextArena;
 
-		glm::vec4 QuadVertexPositions[4];
+		std::vector<Scope<RecordingContext>> RecordingContexts;
 
 		Renderer2D::Statistics Stats;
 
 		struct CameraData
 		{
 			glm::mat4 ViewProjection;
+			glm::vec2 ViewportSize; // In pixels, lines use this to get their width on screen
+			glm::vec2 Padding;
 		};
 		CameraData CameraBuffer;
 		Ref<UniformBuffer> CameraUniformBuffer;
 	};
 
 	static Renderer2DData s_Data;
+	// The recording context of the calling thread, null when the thread draws straight to the batch
+	static thread_local RecordingContext* t_RecordingContext = nullptr;
+
+	/// <summary>
+	/// Build the sort key for a draw command. From most to least significant the key holds the
+	/// sort layer (8 bits), the depth (24 bits), the pipeline (4 bits) and the texture (28 bits)
+	/// </summary>
+	/// <param name="depth">The depth of the draw</param>
+	/// <param name="pipeline">The pipeline the draw uses</param>
+	/// <param name="textureID">The renderer ID of the texture the draw uses</param>
+	/// <returns>The sort key</returns>
+	static uint64_t BuildSortKey(float depth, SortPipeline pipeline, uint32_t textureID)
+	{
+		// Flip the float bits so that the depth sorts correctly as an unsigned integer,
+		// then only keep the most significant 24 bits
+		uint32_t depthBits;
+		memcpy(&depthBits, &depth, sizeof(float));
+		depthBits = (depthBits & 0x80000000) ? ~depthBits : depthBits | 0x80000000;
+		depthBits >>= 8;
+
+		return ((uint64_t)s_Data.SortLayer << 56)
+			| ((uint64_t)depthBits << 32)
+			| ((uint64_t)pipeline << 28)
+			| (uint64_t)(textureID & 0x0FFFFFFF);
+	}
+
+	/// <summary>
+	/// Get the pipeline of a sorted draw command from its sort key
+	/// </summary>
+	static SortPipeline GetSortPipeline(uint64_t key)
+	{
+		return (SortPipeline)((key >> 28) & 0xF);
+	}
+
+	/// <summary>
+	/// Sort items by their key using a least significant digit radix sort. The sort is stable so
+	/// draws with the same key stay in submission order. Passes where every key has the same
+	/// digit are skipped, which is common for the layer and pipeline bits
+	/// </summary>
+	/// <param name="items">The items to sort</param>
+	/// <param name="scratch">A buffer to sort into, resized to fit the items</param>
+	static void RadixSort(std::vector<SortItem>& items, std::vector<SortItem>& scratch)
+	{
+		PC_PROFILE_FUNCTION();
+
+		const size_t count = items.size();
+		if (count < 2)
+			return;
+
+		scratch.resize(count);
+		SortItem* source = items.data();
+		SortItem* destination = scratch.data();
+
+		for (uint32_t shift = 0; shift < 64; shift += 8)
+		{
+			// Count how many keys have each digit
+			uint32_t offsets[256] = {};
+			for (size_t i = 0; i < count; i++)
+				offsets[(source[i].Key >> shift) & 0xFF]++;
+
+			if (offsets[(source[0].Key >> shift) & 0xFF] == count)
+				continue;
+
+			// Turn the counts into the position each digit starts at
+			uint32_t total = 0;
+			for (uint32_t& offset : offsets)
+			{
+				uint32_t digitCount = offset;
+				offset = total;
+				total += digitCount;
+			}
+
+			for (size_t i = 0; i < count; i++)
+				destination[offsets[(source[i].Key >> shift) & 0xFF]++] = source[i];
+
+			std::swap(source, destination);
+		}
+
+		if (source != items.data())
+			std::copy(source, source + count, items.data());
+	}
+
+	/// <summary>
+	/// Count how many times the quad pipeline would have to start a new batch if the sorted draw
+	/// commands were drawn in the given order, either from running out of room or texture slots
+	/// </summary>
+	/// <param name="items">The draw commands in the order they would be drawn</param>
+	/// <returns>The number of batch breaks</returns>
+	static uint32_t CountBatchBreaks(const std::vector<SortItem>& items)
+	{
+		uint32_t breaks = 0;
+		uint32_t quadCount = 0;
+		uint32_t slotIndex = 1;
+		TextureSlotTable slots;
+
+		for (const SortItem& item : items)
+		{
+			// Shapes are drawn in the quad batch as well
+			const SortPipeline pipeline = GetSortPipeline(item.Key);
+			if (pipeline != SortPipeline::Quad && pipeline != SortPipeline::Shape)
+				continue;
+
+			if (quadCount >= Renderer2DData::MaxQuads)
+			{
+				breaks++;
+				quadCount = 0;
+				slotIndex = 1;
+				slots.Reset();
+			}
+
+			// Plain colored quads and shapes use the white texture, which is always in slot 0
+			const Texture2D* texture = pipeline == SortPipeline::Quad ? s_Data.QuadCommands[item.Index].Texture : nullptr;
+			if (texture && slots.Find(texture->GetRendererID()) < 0)
+			{
+				if (slotIndex >= Renderer2DData::MaxTextureSlots)
+				{
+					breaks++;
+					quadCount = 0;
+					slotIndex = 1;
+					slots.Reset();
+				}
+				slots.Insert(texture->GetRendererID(), slotIndex++);
+			}
+
+			quadCount++;
+		}
+		return breaks;
+	}
+
+	/// <summary>
+	/// Decode the UTF-8 character starting at a position in a string. Invalid bytes decode
+	/// to the replacement character (U+FFFD) so that one bad byte only affects one character
+	/// </summary>
+	/// <param name="string">The UTF-8 string</param>
+	/// <param name="i">The position of the first byte of the character, moved past the character</param>
+	/// <returns>The unicode codepoint</returns>
+	static uint32_t DecodeUTF8(std::string_view string, size_t& i)
+	{
+		const uint32_t replacement = 0xFFFD;
+
+		uint8_t lead = (uint8_t)string[i++];
+		if (lead < 0x80)
+			return lead;
+
+		// The lead byte says how many continuation bytes follow, and the smallest codepoint
+		// that needs that many so that overlong encodings can be rejected
+		uint32_t continuationCount;
+		uint32_t minimum;
+		uint32_t codepoint;
+		if ((lead & 0xE0) == 0xC0)
+		{
+			continuationCount = 1;
+			minimum = 0x80;
+			codepoint = lead & 0x1F;
+		}
+		else if ((lead & 0xF0) == 0xE0)
+		{
+			continuationCount = 2;
+			minimum = 0x800;
+			codepoint = lead & 0x0F;
+		}
+		else if ((lead & 0xF8) == 0xF0)
+		{
+			continuationCount = 3;
+			minimum = 0x10000;
+			codepoint = lead & 0x07;
+		}
+		else
+			return replacement;
+
+		for (uint32_t n = 0; n < continuationCount; n++)
+		{
+			if (i >= string.size() || ((uint8_t)string[i] & 0xC0) != 0x80)
+				return replacement;
+			codepoint = (codepoint << 6) | ((uint8_t)string[i++] & 0x3F);
+		}
+
+		if (codepoint < minimum || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+			return replacement;
+		return codepoint;
+	}
+
+	/// <summary>
+	/// Pack a color into 8 bits per channel (RGBA8)
+	/// </summary>
+	/// <param name="color">The color to pack</param>
+	/// <returns>The packed color</returns>
+	static uint32_t PackColor(const glm::vec4& color)
+	{
+		uint32_t r = (uint32_t)(std::clamp(color.r, 0.0f, 1.0f) * 255.0f + 0.5f);
+		uint32_t g = (uint32_t)(std::clamp(color.g, 0.0f, 1.0f) * 255.0f + 0.5f);
+		uint32_t b = (uint32_t)(std::clamp(color.b, 0.0f, 1.0f) * 255.0f + 0.5f);
+		uint32_t a = (uint32_t)(std::clamp(color.a, 0.0f, 1.0f) * 255.0f + 0.5f);
+		return r | (g << 8) | (b << 16) | (a << 24);
+	}
+
+	/// <summary>
+	/// Get the quad transform of a transform matrix
+	/// </summary>
+	static QuadTransform ToQuadTransform(const glm::mat4& transform)
+	{
+		return {
+			{ transform[0][0], transform[1][0], transform[3][0] },
+			{ transform[0][1], transform[1][1], transform[3][1] },
+			{ transform[0][2], transform[1][2], transform[3][2] }
+		};
+	}
+
+	/// <summary>
+	/// Get the quad transform of an axis aligned quad without building any matrices
+	/// </summary>
+	static QuadTransform ToQuadTransform(const glm::vec3& position, const glm::vec2& size)
+	{
+		return {
+			{ size.x, 0.0f, position.x },
+			{ 0.0f, size.y, position.y },
+			{ 0.0f, 0.0f, position.z }
+		};
+	}
+
+	/// <summary>
+	/// Get the quad transform of a quad rotated around the z axis without building any matrices.
+	/// This is the same as translate * rotate * scale
+	/// </summary>
+	static QuadTransform ToQuadTransform(const glm::vec3& position, const glm::vec2& size, float rotation)
+	{
+		const float c = std::cos(rotation);
+		const float s = std::sin(rotation);
+		return {
+			{ c * size.x, -s * size.y, position.x },
+			{ s * size.x,  c * size.y, position.y },
+			{ 0.0f, 0.0f, position.z }
+		};
+	}
+
+	static QuadTransform ToQuadTransform(const QuadInstance& quad)
+	{
+		if (quad.Rotation == 0.0f)
+			return ToQuadTransform(quad.Position, quad.Size);
+		return ToQuadTransform(quad.Position, quad.Size, quad.Rotation);
+	}
+
+	// The corners of a quad in the order the quad indices expect
+	alignas(16) static const float s_QuadCornersX[4] = { -0.5f,  0.5f, 0.5f, -0.5f };
+	alignas(16) static const float s_QuadCornersY[4] = { -0.5f, -0.5f, 0.5f,  0.5f };
+
+	/// <summary>
+	/// Generate the 4 vertices of a quad. Each row of the transform is applied to all 4 corners
+	/// at once, with one SIMD lane per corner
+	/// </summary>
+	static void GenerateQuadVertices(QuadVertex* vertex, const QuadTransform& transform, const glm::vec4& color, float textureIndex, float tilingFactor, const glm::vec4& texRect)
+	{
+		alignas(16) float x[4];
+		alignas(16) float y[4];
+		alignas(16) float z[4];
+
+#ifdef PC_RENDERER2D_SSE
+		const __m128 cornersX = _mm_load_ps(s_QuadCornersX);
+		const __m128 cornersY = _mm_load_ps(s_QuadCornersY);
+		auto applyRow = [&](const glm::vec3& row, float* out)
+		{
+			__m128 result = _mm_mul_ps(_mm_set1_ps(row.x), cornersX);
+			result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(row.y), cornersY));
+			_mm_store_ps(out, _mm_add_ps(result, _mm_set1_ps(row.z)));
+		};
+		applyRow(transform.X, x);
+		applyRow(transform.Y, y);
+		applyRow(transform.Z, z);
+#else
+		for (size_t i = 0; i < 4; i++)
+		{
+			x[i] = transform.X.x * s_QuadCornersX[i] + transform.X.y * s_QuadCornersY[i] + transform.X.z;
+			y[i] = transform.Y.x * s_QuadCornersX[i] + transform.Y.y * s_QuadCornersY[i] + transform.Y.z;
+			z[i] = transform.Z.x * s_QuadCornersX[i] + transform.Z.y * s_QuadCornersY[i] + transform.Z.z;
+		}
+#endif
+
+		const glm::vec2 textureCoords[] = { { texRect.x, texRect.y }, { texRect.z, texRect.y }, { texRect.z, texRect.w }, { texRect.x, texRect.w } };
+
+		// Set the vertex data for every vertex in a quad
+		for (size_t i = 0; i < 4; i++)
+		{
+			vertex[i].Position = { x[i], y[i], z[i] };
+			vertex[i].Color = color;
+			vertex[i].TexCoord = textureCoords[i];
+			vertex[i].TexIndex = textureIndex;
+			vertex[i].TilingFactor = tilingFactor;
+		}
+	}
+
+	/// <summary>
+	/// Write the 4 vertices of a quad to the quad vertex buffer
+	/// </summary>
+	static void WriteQuadVertices(const QuadTransform& transform, const glm::vec4& color, float textureIndex, float tilingFactor, const glm::vec4& texRect)
+	{
+		GenerateQuadVertices(s_Data.QuadVertexBufferPtr, transform, color, textureIndex, tilingFactor, texRect);
+		s_Data.QuadVertexBufferPtr += 4;
+
+		// Increment the index count by the number of indices needed for a quad
+		s_Data.QuadIndexCount += 6;
+
+		// Update the number of quads in the statistics
+		s_Data.Stats.QuadCount++;
+	}
+
+	/// <summary>
+	/// Record a quad into a recording context
+	/// </summary>
+	static void RecordQuad(RecordingContext& context, const QuadTransform& transform, const Texture2D* texture, const glm::vec4& texRect, float tilingFactor, const glm::vec4& color)
+	{
+		float textureIndex = 0.0f;
+		if (texture)
+		{
+			auto [it, inserted] = context.TextureLookup.try_emplace(texture->GetRendererID(), (uint32_t)context.Textures.size() + 1);
+			if (inserted)
+				context.Textures.push_back(texture);
+			textureIndex = (float)it->second;
+		}
+
+		size_t offset = context.Vertices.size();
+		context.Vertices.resize(offset + 4);
+		GenerateQuadVertices(&context.Vertices[offset], transform, color, textureIndex, tilingFactor, texRect);
+
+		context.Stats.QuadCount++;
+		context.Stats.TextureCount = (uint32_t)context.Textures.size();
+	}
+
+	/// <summary>
+	/// Write a quad to the instanced quad pipeline. The transform is reduced to a 2D affine
+	/// transform and a depth, which is all a 2D quad needs
+	/// </summary>
+	static void WriteQuadInstance(const QuadTransform& transform, const glm::vec4& color, float textureIndex, float tilingFactor, const glm::vec4& texRect)
+	{
+		s_Data.QuadInstanceBufferPtr->TransformRow0 = { transform.X.x, transform.X.y, transform.X.z, transform.Z.z };
+		s_Data.QuadInstanceBufferPtr->TransformRow1 = transform.Y;
+		s_Data.QuadInstanceBufferPtr->Color = PackColor(color);
+		s_Data.QuadInstanceBufferPtr->TexRect = texRect;
+		s_Data.QuadInstanceBufferPtr->TexIndex = (int)textureIndex;
+		s_Data.QuadInstanceBufferPtr->TilingFactor = tilingFactor;
+		s_Data.QuadInstanceBufferPtr->Shape = (int)ShapeType::Quad;
+		s_Data.QuadInstanceBufferPtr++;
+
+		s_Data.QuadInstanceCount++;
+
+		// Update the number of quads in the statistics
+		s_Data.Stats.QuadCount++;
+	}
+
+	/// <summary>
+	/// Start a new quad batch in the next segment of the quad vertex buffers. Both quad pipelines
+	/// share the texture slots, so they always start and flush together
+	/// </summary>
+	static void StartQuadBatch()
+	{
+		s_Data.QuadIndexCount = 0;
+		s_Data.QuadVertexBufferBase = (QuadVertex*)s_Data.QuadVertexBuffer->MapSegment();
+		s_Data.QuadVertexBufferPtr = s_Data.QuadVertexBufferBase;
+
+		s_Data.QuadInstanceCount = 0;
+		s_Data.QuadInstanceBufferBase = (QuadInstanceVertex*)s_Data.QuadInstanceVertexBuffer->MapSegment();
+		s_Data.QuadInstanceBufferPtr = s_Data.QuadInstanceBufferBase;
+
+		s_Data.TextureSlotIndex = 1;
+		s_Data.TextureSlotLookup.Reset();
+		s_Data.TextureSlotLookup.Insert(s_Data.WhiteTexture->GetRendererID(), 0);
+	}
+
+	/// <summary>
+	/// Start a new line batch in the next segment of the line buffer
+	/// </summary>
+	static void StartLineBatch()
+	{
+		s_Data.LineCount = 0;
+		s_Data.LineBufferBase = (LineInstanceVertex*)s_Data.LineVertexBuffer->MapSegment();
+		s_Data.LineBufferPtr = s_Data.LineBufferBase;
+	}
+
+	/// <summary>
+	/// Start a new text batch in the next segment of the text vertex buffer
+	/// </summary>
+	static void StartTextBatch()
+	{
+		s_Data.TextIndexCount = 0;
+		s_Data.TextVertexBufferBase = (TextVertex*)s_Data.TextVertexBuffer->MapSegment();
+		s_Data.TextVertexBufferPtr = s_Data.TextVertexBufferBase;
+
+		s_Data.FontAtlasSlotIndex = 0;
+		s_Data.FontAtlasSlotLookup.Reset();
+	}
+
+	/// <summary>
+	/// Draw the quads in the current quad batch
+	/// </summary>
+	static void FlushQuads()
+	{
+		PC_PROFILE_FUNCTION();
+
+		// Draw our quads
+		if (s_Data.QuadIndexCount)
+		{
+			// Bind textures
+			for (uint32_t i = 0; i < s_Data.TextureSlotIndex; i++)
+				s_Data.TextureSlots[i]->Bind(i);
+
+			// Bind the quad shader and draw our vertex data
+			// The vertex data is already in the mapped segment, so we only need to offset our
+			// indices to the start of that segment
+			s_Data.QuadShader->Bind();
+			uint32_t baseVertex = s_Data.QuadVertexBuffer->GetSegmentOffset() / sizeof(QuadVertex);
+			RenderCommand::DrawIndexed(s_Data.QuadVertexArray, s_Data.QuadIndexCount, baseVertex);
+			// Fence the segment so it is not written to again until the GPU is done with it
+			s_Data.QuadVertexBuffer->CommitSegment();
+			// Every time we draw something with the render command, we should increase our total drawcalls
+			s_Data.Stats.DrawCalls++;
+		}
+
+		// Draw instanced quads
+		if (s_Data.QuadInstanceCount)
+		{
+			// Bind textures
+			for (uint32_t i = 0; i < s_Data.TextureSlotIndex; i++)
+				s_Data.TextureSlots[i]->Bind(i);
+
+			// Each instance is drawn as 6 vertices (2 triangles) which the shader expands from the
+			// instance data, starting at the first instance in the current mapped segment
+			s_Data.QuadInstanceShader->Bind();
+			uint32_t baseInstance = s_Data.QuadInstanceVertexBuffer->GetSegmentOffset() / sizeof(QuadInstanceVertex);
+			RenderCommand::DrawInstanced(s_Data.QuadInstanceVertexArray, 6, s_Data.QuadInstanceCount, baseInstance);
+			s_Data.QuadInstanceVertexBuffer->CommitSegment();
+			s_Data.Stats.DrawCalls++;
+		}
+	}
+
+	/// <summary>
+	/// Draw the lines in the current line batch
+	/// </summary>
+	static void FlushLines()
+	{
+		PC_PROFILE_FUNCTION();
+
+		if (s_Data.LineCount)
+		{
+			// Like instanced quads, every line is drawn as 6 vertices which the shader expands
+			// into a quad as wide as the line
+			s_Data.LineShader->Bind();
+			uint32_t baseInstance = s_Data.LineVertexBuffer->GetSegmentOffset() / sizeof(LineInstanceVertex);
+			RenderCommand::DrawInstanced(s_Data.LineVertexArray, 6, s_Data.LineCount, baseInstance);
+			s_Data.LineVertexBuffer->CommitSegment();
+			s_Data.Stats.DrawCalls++;
+		}
+	}
+
+	/// <summary>
+	/// Draw the glyphs in the current text batch
+	/// </summary>
+	static void FlushText()
+	{
+		PC_PROFILE_FUNCTION();
+
+		if (s_Data.TextIndexCount)
+		{
+			// Bind the font atlases used by this batch
+			for (uint32_t i = 0; i < s_Data.FontAtlasSlotIndex; i++)
+				s_Data.FontAtlasSlots[i]->Bind(i);
+
+			// Bind the text shader and draw our vertex data
+			s_Data.TextShader->Bind();
+			uint32_t baseVertex = s_Data.TextVertexBuffer->GetSegmentOffset() / sizeof(TextVertex);
+			RenderCommand::DrawIndexed(s_Data.TextVertexArray, s_Data.TextIndexCount, baseVertex);
+			s_Data.TextVertexBuffer->CommitSegment();
+			// Every time we draw something with the render command, we should increase our total drawcalls
+			s_Data.Stats.DrawCalls++;
+		}
+	}
+
+	// Each pipeline starts a new batch on its own when it runs out of room, the other pipelines keep batching
+
+	static void NextQuadBatch()
+	{
+		FlushQuads();
+		StartQuadBatch();
+	}
+
+	static void NextLineBatch()
+	{
+		FlushLines();
+		StartLineBatch();
+	}
+
+	static void NextTextBatch()
+	{
+		FlushText();
+		StartTextBatch();
+	}
+
+	/// <summary>
+	/// Check if there is no room for another vertex quad in the current quad batch. The vertex quads of a
+	/// batch are drawn before its instances, so once a shape is in the batch vertex quads go in the next
+	/// one, which keeps them on top of the shapes drawn before them
+	/// </summary>
+	static bool IsQuadVertexBatchFull()
+	{
+		return s_Data.QuadIndexCount >= Renderer2DData::MaxIndices || s_Data.QuadInstanceCount > 0;
+	}
+
+	/// <summary>
+	/// Draw a circle or rounded rectangle as an instance of the instanced quad pipeline
+	/// </summary>
+	/// <param name="transform">The transform of the quad the shape fills</param>
+	/// <param name="shape">The type of shape</param>
+	/// <param name="color">The color of the shape</param>
+	/// <param name="params">The thickness, fade and corner radius of the shape</param>
+	static void SubmitShape(const QuadTransform& transform, ShapeType shape, const glm::vec4& color, const glm::vec3& params)
+	{
+		PC_CORE_ASSERT(!t_RecordingContext, "Shapes can not be drawn while recording!");
+
+		// Record the shape to be sorted and drawn at the end of the scene
+		if (s_Data.SortedSubmission && !s_Data.ExecutingSortedCommands)
+		{
+			s_Data.SortItems.push_back({ BuildSortKey(transform.Z.z, SortPipeline::Shape, 0), (uint32_t)s_Data.ShapeCommands.size() });
+			s_Data.ShapeCommands.push_back({ transform, color, params, shape });
+			return;
+		}
+
+		if (s_Data.QuadInstanceCount >= Renderer2DData::MaxQuads)
+			NextQuadBatch();
+
+		// Shapes need no texture, they use the white texture in slot 0
+		s_Data.QuadInstanceBufferPtr->TransformRow0 = { transform.X.x, transform.X.y, transform.X.z, transform.Z.z };
+		s_Data.QuadInstanceBufferPtr->TransformRow1 = transform.Y;
+		s_Data.QuadInstanceBufferPtr->Color = PackColor(color);
+		s_Data.QuadInstanceBufferPtr->TexRect = glm::vec4(params, 0.0f);
+		s_Data.QuadInstanceBufferPtr->TexIndex = 0;
+		s_Data.QuadInstanceBufferPtr->TilingFactor = 1.0f;
+		s_Data.QuadInstanceBufferPtr->Shape = (int)shape;
+		s_Data.QuadInstanceBufferPtr++;
+
+		s_Data.QuadInstanceCount++;
+
+		// A shape is drawn as one quad
+		s_Data.Stats.QuadCount++;
+	}
+
+	/// <summary>
+	/// Get the size of the viewport being drawn to, which is the framebuffer when one is bound
+	/// </summary>
+	static glm::vec2 GetViewportSize()
+	{
+		glm::ivec4 viewport = RenderCommand::GetViewport();
+		return { (float)viewport.z, (float)viewport.w };
+	}
 
 	void Renderer2D::Init()
 	{
 		PC_PROFILE_FUNCTION();
 
+		auto initStart = std::chrono::steady_clock::now();
+
 		// Quads
 		s_Data.QuadVertexArray = VertexArray::Create();
 
-		// Create our vertex buffer and set the layout to be the same as the Renderer2D_Quad shader
-		s_Data.QuadVertexBuffer = VertexBuffer::Create(s_Data.MaxVertices * sizeof(QuadVertex));
+		// Create our vertex buffer and set the layout to be the same as the Renderer2D_Quad shader.
+		// The vertex buffer is persistently mapped so quads are written straight into GPU visible memory
+		s_Data.QuadVertexBuffer = VertexBuffer::CreatePersistent(s_Data.MaxVertices * sizeof(QuadVertex), s_Data.VertexBufferSegments);
 		s_Data.QuadVertexBuffer->SetLayout({
 			{ ShaderDataType::Float3, "a_Position"     },
 			{ ShaderDataType::Float4, "a_Color"        },
@@ -105,8 +873,6 @@ namespace Pinecone
 		});
 		// Add the vertex buffer to the vertex array
 		s_Data.QuadVertexArray->AddVertexBuffer(s_Data.QuadVertexBuffer);
-		// Create a new quad vertex buffer data array
-		s_Data.QuadVertexBufferBase = new QuadVertex[s_Data.MaxVertices];
 		uint32_t* quadIndices = new uint32_t[s_Data.MaxIndices];
 
 		// Setup the quad indices for all quads. 
@@ -136,39 +902,53 @@ namespace Pinecone
 		s_Data.QuadVertexArray->SetIndexBuffer(quadIB);
 		delete[] quadIndices;
 
+		// Instanced quads
+		s_Data.QuadInstanceVertexArray = VertexArray::Create();
+
+		// Every quad instance is a single element in the vertex buffer, the corners are generated
+		// in the Renderer2D_QuadInstanced shader so no index buffer is needed. Circles and rounded
+		// rectangles are drawn as instances as well
+		s_Data.QuadInstanceVertexBuffer = VertexBuffer::CreatePersistent(s_Data.MaxQuads * sizeof(QuadInstanceVertex), s_Data.VertexBufferSegments);
+		s_Data.QuadInstanceVertexBuffer->SetLayout({
+			{ ShaderDataType::Float4, "a_TransformRow0" },
+			{ ShaderDataType::Float3, "a_TransformRow1" },
+			{ ShaderDataType::Int,    "a_Color"         },
+			{ ShaderDataType::Float4, "a_TexRect"       },
+			{ ShaderDataType::Int,    "a_TexIndex"      },
+			{ ShaderDataType::Float,  "a_TilingFactor"  },
+			{ ShaderDataType::Int,    "a_Shape"         }
+		});
+		s_Data.QuadInstanceVertexArray->AddVertexBuffer(s_Data.QuadInstanceVertexBuffer, true);
+
 		// Lines
 		s_Data.LineVertexArray = VertexArray::Create();
 
-		s_Data.LineVertexBuffer = VertexBuffer::Create(s_Data.MaxVertices * sizeof(LineVertex));
+		// Every line segment is a single instance, the Renderer2D_Line shader expands it into a quad
+		// so lines can be wider than the 1 pixel that glLineWidth is limited to in core profiles
+		s_Data.LineVertexBuffer = VertexBuffer::CreatePersistent(s_Data.MaxLines * sizeof(LineInstanceVertex), s_Data.VertexBufferSegments);
 		s_Data.LineVertexBuffer->SetLayout({
-			{ ShaderDataType::Float3, "a_Position" },
-			{ ShaderDataType::Float4, "a_Color"    }
+			{ ShaderDataType::Float3, "a_Start" },
+			{ ShaderDataType::Float3, "a_End"   },
+			{ ShaderDataType::Int,    "a_Color" },
+			{ ShaderDataType::Float,  "a_Width" }
 			});
-		s_Data.LineVertexArray->AddVertexBuffer(s_Data.LineVertexBuffer);
-		s_Data.LineVertexBufferBase = new LineVertex[s_Data.MaxVertices];
-
-		// The basic vertex positions for a quad. This is modified by the transform matrix when the quad is drawn
-		s_Data.QuadVertexPositions[0] = { -0.5f, -0.5f, 0.0f, 1.0f };
-		s_Data.QuadVertexPositions[1] = { 0.5f, -0.5f, 0.0f, 1.0f };
-		s_Data.QuadVertexPositions[2] = { 0.5f,  0.5f, 0.0f, 1.0f };
-		s_Data.QuadVertexPositions[3] = { -0.5f,  0.5f, 0.0f, 1.0f };
+		s_Data.LineVertexArray->AddVertexBuffer(s_Data.LineVertexBuffer, true);
 
 		// Text
 		s_Data.TextVertexArray = VertexArray::Create();
 
 		// Create our vertex buffer and set the layout to be the same as the Renderer2D_Text shader
-		s_Data.TextVertexBuffer = VertexBuffer::Create(s_Data.MaxVertices * sizeof(TextVertex));
+		s_Data.TextVertexBuffer = VertexBuffer::CreatePersistent(s_Data.MaxVertices * sizeof(TextVertex), s_Data.VertexBufferSegments);
 		s_Data.TextVertexBuffer->SetLayout({
 			{ ShaderDataType::Float3, "a_Position"     },
 			{ ShaderDataType::Float4, "a_Color"        },
-			{ ShaderDataType::Float2, "a_TexCoord"     }
+			{ ShaderDataType::Float2, "a_TexCoord"     },
+			{ ShaderDataType::Float,  "a_AtlasIndex"   }
 			});
 		// Add the vertex buffer to the vertex array
 		s_Data.TextVertexArray->AddVertexBuffer(s_Data.TextVertexBuffer);
 		// This also uses the same indices that quads do so also add that to the vertex array
 		s_Data.TextVertexArray->SetIndexBuffer(quadIB);
-		// Create a new text vertex buffer array
-		s_Data.TextVertexBufferBase = new TextVertex[s_Data.MaxVertices];
 		
 		// Create a basic white texture. This is used for drawing 2D quads with only a color and no texture
 		s_Data.WhiteTexture = Texture2D::Create(TextureSpecification());
@@ -179,23 +959,44 @@ namespace Pinecone
 		// Create the shaders
 		// Note: These shader files currently do need to exist in the client application
 		s_Data.QuadShader = Shader::Create("assets/shaders/Renderer2D_Quad.glsl");
+		s_Data.QuadInstanceShader = Shader::Create("assets/shaders/Renderer2D_QuadInstanced.glsl");
 		s_Data.LineShader = Shader::Create("assets/shaders/Renderer2D_Line.glsl");
 		s_Data.TextShader = Shader::Create("assets/shaders/Renderer2D_Text.glsl");
 
 		// Set first texture slot to 0
-		s_Data.TextureSlots[0] = s_Data.WhiteTexture;
+		s_Data.TextureSlots[0] = s_Data.WhiteTexture.get();
 
 		// Create a uniform buffer to pass our camera data into
 		s_Data.CameraUniformBuffer = UniformBuffer::Create(sizeof(Renderer2DData::CameraData), 0);
+
+		// The shaders are needed for the first frame anyway, waiting for them here makes the startup time
+		// include them. The first start compiles every shader, later starts load them from the cache
+		uint32_t cachedShaderCount = 0;
+		const Ref<Shader> shaders[] = { s_Data.QuadShader, s_Data.QuadInstanceShader, s_Data.LineShader, s_Data.TextShader };
+		for (const Ref<Shader>& shader : shaders)
+		{
+			shader->WaitUntilLinked();
+			if (shader->IsLoadedFromCache())
+				cachedShaderCount++;
+		}
+
+		std::chrono::duration<float, std::milli> duration = std::chrono::steady_clock::now() - initStart;
+		PC_CORE_INFO("Renderer2D initialized in {0:.2f}ms ({1} of {2} shaders loaded from the cache)", duration.count(), cachedShaderCount, std::size(shaders));
 	}
 
 	void Renderer2D::Shutdown()
 	{
 		PC_PROFILE_FUNCTION();
 
-		// Delete our vertex buffer data arrays
-		delete[] s_Data.QuadVertexBufferBase;
-		delete[] s_Data.TextVertexBufferBase;
+		// The vertex buffer data lives in the mapped vertex buffers, so we only need to
+		// forget about the pointers. The buffers unmap themselves when they are deleted
+		s_Data.QuadVertexBufferBase = s_Data.QuadVertexBufferPtr = nullptr;
+		s_Data.QuadInstanceBufferBase = s_Data.QuadInstanceBufferPtr = nullptr;
+		s_Data.LineBufferBase = s_Data.LineBufferPtr = nullptr;
+		s_Data.TextVertexBufferBase = s_Data.TextVertexBufferPtr = nullptr;
+
+		// Release the textures held by the recording contexts while the graphics context is still alive
+		s_Data.RecordingContexts.clear();
 	}
 
 	void Renderer2D::BeginScene(const Camera& camera)
@@ -204,9 +1005,20 @@ namespace Pinecone
 
 		// Set the camera buffer view projection from the camera
 		s_Data.CameraBuffer.ViewProjection = camera.GetProjection();
+		s_Data.CameraBuffer.ViewportSize = GetViewportSize();
 		// Then set the data in the uniform buffer, this will set the view projection in our shaders
 		s_Data.CameraUniformBuffer->SetData(&s_Data.CameraBuffer, sizeof(Renderer2DData::CameraBuffer));
 
+		// Drop any commands left over from a scene that was never ended
+		s_Data.SortItems.clear();
+		s_Data.QuadCommands.clear();
+		s_Data.ShapeCommands.clear();
+		s_Data.TextCommands.clear();
+		s_Data.TextArena.clear();
+
+		for (auto& context : s_Data.RecordingContexts)
+			context->Reset();
+
 		// Start the first batch
 		StartBatch();
 	}
@@ -217,9 +1029,20 @@ namespace Pinecone
 
 		// Set the camera buffer view projection from the camera
 		s_Data.CameraBuffer.ViewProjection = camera.GetProjection() * glm::inverse(transform);
+		s_Data.CameraBuffer.ViewportSize = GetViewportSize();
 		// Then set the data in the uniform buffer, this will set the view projection in our shaders
 		s_Data.CameraUniformBuffer->SetData(&s_Data.CameraBuffer, sizeof(Renderer2DData::CameraBuffer));
 
+		// Drop any commands left over from a scene that was never ended
+		s_Data.SortItems.clear();
+		s_Data.QuadCommands.clear();
+		s_Data.ShapeCommands.clear();
+		s_Data.TextCommands.clear();
+		s_Data.TextArena.clear();
+
+		for (auto& context : s_Data.RecordingContexts)
+			context->Reset();
+
 		// Start the first batch
 		StartBatch();
 	}
@@ -234,76 +1057,172 @@ namespace Pinecone
 		// engine is updated to give it use but the program does not currently 
 		// use it. All it really does is just call flush but may do more in tne future
 		// that flush should not do
+		// The recording contexts go after every draw made on the render thread, sorted or not
+		if (s_Data.SortedSubmission)
+			ExecuteSortedCommands();
+		if (!s_Data.RecordingContexts.empty())
+			MergeRecordingContexts();
 		Flush();
 	}
 
-	void Renderer2D::StartBatch()
+	void Renderer2D::MergeRecordingContexts()
 	{
-		// Initialize the 2D renderer data
-		s_Data.QuadIndexCount = 0;
-		s_Data.QuadVertexBufferPtr = s_Data.QuadVertexBufferBase;
+		PC_PROFILE_FUNCTION();
 
-		s_Data.LineVertexCount = 0;
-		s_Data.LineVertexBufferPtr = s_Data.LineVertexBufferBase;
+		// The recorded vertices are already generated, so merging is just a copy. Only the texture
+		// index has to change, from the index in the contexts texture list to the slot in the batch
+		for (const auto& context : s_Data.RecordingContexts)
+		{
+			const QuadVertex* source = context->Vertices.data();
+			const size_t quadCount = context->Vertices.size() / 4;
+			for (size_t i = 0; i < quadCount; i++, source += 4)
+			{
+				if (IsQuadVertexBatchFull())
+					NextQuadBatch();
 
-		s_Data.TextIndexCount = 0;
-		s_Data.TextVertexBufferPtr = s_Data.TextVertexBufferBase;
+				uint32_t localIndex = (uint32_t)source->TexIndex;
+				float textureIndex = localIndex == 0 ? 0.0f : GetTextureIndex(context->Textures[localIndex - 1]);
 
-		s_Data.TextureSlotIndex = 1;
+				QuadVertex* destination = s_Data.QuadVertexBufferPtr;
+				memcpy(destination, source, 4 * sizeof(QuadVertex));
+				for (size_t v = 0; v < 4; v++)
+					destination[v].TexIndex = textureIndex;
+
+				s_Data.QuadVertexBufferPtr += 4;
+				s_Data.QuadIndexCount += 6;
+			}
+
+			s_Data.Stats.QuadCount += context->Stats.QuadCount;
+		}
 	}
 
-	void Renderer2D::Flush()
+	void Renderer2D::ExecuteSortedCommands()
 	{
 		PC_PROFILE_FUNCTION();
 
-		// Draw our quads
-		if (s_Data.QuadIndexCount)
+		// Sort the commands, keeping track of how many batches we saved by doing so
+		uint32_t unsortedBreaks = CountBatchBreaks(s_Data.SortItems);
+		RadixSort(s_Data.SortItems, s_Data.SortScratch);
+		uint32_t sortedBreaks = CountBatchBreaks(s_Data.SortItems);
+		if (unsortedBreaks > sortedBreaks)
+			s_Data.Stats.BatchBreaksRemoved += unsortedBreaks - sortedBreaks;
+
+		// Draw the commands in sorted order. While executing, the draw functions draw straight
+		// away instead of recording the commands again
+		s_Data.ExecutingSortedCommands = true;
+		for (const SortItem& item : s_Data.SortItems)
 		{
-			// Get the size of our vertex data we added and set that data in the vertex buffer
-			uint32_t dataSize = (uint32_t)((uint8_t*)s_Data.QuadVertexBufferPtr - (uint8_t*)s_Data.QuadVertexBufferBase);
-			s_Data.QuadVertexBuffer->SetData(s_Data.QuadVertexBufferBase, dataSize);
+			switch (GetSortPipeline(item.Key))
+			{
+			case SortPipeline::Quad:
+			{
+				const QuadCommand& command = s_Data.QuadCommands[item.Index];
+				SubmitQuad(command.Transform, command.Texture, command.TexRect, command.TilingFactor, command.Color);
+				break;
+			}
+			case SortPipeline::Shape:
+			{
+				const ShapeCommand& command = s_Data.ShapeCommands[item.Index];
+				SubmitShape(command.Transform, command.Shape, command.Color, command.Params);
+				break;
+			}
+			case SortPipeline::Text:
+			{
+				const TextCommand& command = s_Data.TextCommands[item.Index];
+				SubmitString({ s_Data.TextArena.data() + command.Offset, command.Length }, command.Font, command.Transform, command.Color);
+				break;
+			}
+			}
+		}
+		s_Data.ExecutingSortedCommands = false;
 
-			// Bind textures
-			for (uint32_t i = 0; i < s_Data.TextureSlotIndex; i++)
-				s_Data.TextureSlots[i]->Bind(i);
+		s_Data.SortItems.clear();
+		s_Data.QuadCommands.clear();
+		s_Data.ShapeCommands.clear();
+		s_Data.TextCommands.clear();
+		s_Data.TextArena.clear();
+	}
 
-			// Bind the quad shader and draw our vertex data
-			s_Data.QuadShader->Bind();
-			RenderCommand::DrawIndexed(s_Data.QuadVertexArray, s_Data.QuadIndexCount);
-			// Every time we draw something with the render command, we should increase our total drawcalls
-			s_Data.Stats.DrawCalls++;
-		}
+	void Renderer2D::StartBatch()
+	{
+		// Initialize the 2D renderer data. The vertex data is written straight into the
+		// current segment of each mapped vertex buffer
+		StartQuadBatch();
+		StartLineBatch();
+		StartTextBatch();
+	}
 
-		// Draw lines
-		if (s_Data.LineVertexCount)
-		{
-			uint32_t dataSize = (uint32_t)((uint8_t*)s_Data.LineVertexBufferPtr - (uint8_t*)s_Data.LineVertexBufferBase);
-			s_Data.LineVertexBuffer->SetData(s_Data.LineVertexBufferBase, dataSize);
+	void Renderer2D::Flush()
+	{
+		PC_PROFILE_FUNCTION();
 
-			s_Data.LineShader->Bind();
-			RenderCommand::SetLineWidth(s_Data.LineWidth);
-			RenderCommand::DrawLines(s_Data.LineVertexArray, s_Data.LineVertexCount);
-			s_Data.Stats.DrawCalls++;
-		}
-		
-		// Draw text
-		if (s_Data.TextIndexCount)
-		{
-			// Get the size of our vertex data we added and set that data in the vertex buffer
-			uint32_t dataSize = (uint32_t)((uint8_t*)s_Data.TextVertexBufferPtr - (uint8_t*)s_Data.TextVertexBufferBase);
-			s_Data.TextVertexBuffer->SetData(s_Data.TextVertexBufferBase, dataSize);
+		FlushQuads();
+		FlushLines();
+		FlushText();
+	}
 
-			// Bind the font atlas texture to texture slot 0
-			s_Data.FontAtlasTexture->Bind(0);
+	void Renderer2D::SetQuadInstancing(bool enabled)
+	{
+		s_Data.QuadInstancing = enabled;
+	}
 
-			// Bind the text shader and draw our vertex data
-			s_Data.TextShader->Bind();
-			RenderCommand::DrawIndexed(s_Data.TextVertexArray, s_Data.TextIndexCount);
-			// Every time we draw something with the render command, we should increase our total drawcalls
-			s_Data.Stats.DrawCalls++;
+	bool Renderer2D::IsQuadInstancing()
+	{
+		return s_Data.QuadInstancing;
+	}
+
+	void Renderer2D::SetSortedSubmission(bool enabled)
+	{
+		s_Data.SortedSubmission = enabled;
+	}
+
+	bool Renderer2D::IsSortedSubmission()
+	{
+		return s_Data.SortedSubmission;
+	}
+
+	void Renderer2D::SetSortLayer(uint8_t layer)
+	{
+		s_Data.SortLayer = layer;
+	}
+
+	void Renderer2D::SetRecordingContextCount(uint32_t count)
+	{
+		PC_CORE_ASSERT(!t_RecordingContext, "Can not change the recording contexts while recording!");
+
+		s_Data.RecordingContexts.resize(count);
+		for (auto& context : s_Data.RecordingContexts)
+		{
+			if (!context)
+				context = CreateScope<RecordingContext>();
 		}
 	}
 
+	uint32_t Renderer2D::GetRecordingContextCount()
+	{
+		return (uint32_t)s_Data.RecordingContexts.size();
+	}
+
+	void Renderer2D::BeginRecording(uint32_t contextIndex)
+	{
+		PC_CORE_ASSERT(contextIndex < s_Data.RecordingContexts.size(), "Recording context index out of range!");
+		PC_CORE_ASSERT(!t_RecordingContext, "This thread is already recording!");
+
+		t_RecordingContext = s_Data.RecordingContexts[contextIndex].get();
+	}
+
+	void Renderer2D::EndRecording()
+	{
+		t_RecordingContext = nullptr;
+	}
+
+	Renderer2D::ContextStatistics Renderer2D::GetContextStats(uint32_t contextIndex)
+	{
+		PC_CORE_ASSERT(contextIndex < s_Data.RecordingContexts.size(), "Recording context index out of range!");
+
+		return s_Data.RecordingContexts[contextIndex]->Stats;
+	}
+
 	void Renderer2D::DrawQuad(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color)
 	{
 		DrawQuad({ position.x, position.y, 0.0f }, size, color);
@@ -313,9 +1232,7 @@ namespace Pinecone
 	{
 		//PC_PROFILE_FUNCTION();
 
-		glm::mat4 transform = glm::translate(glm::mat4(1.0f), position)
-			* glm::scale(glm::mat4(1.0f), { size.x, size.y, 1.0f });
-		DrawQuad(transform, color);
+		SubmitQuad(ToQuadTransform(position, size), nullptr, { 0.0f, 0.0f, 1.0f, 1.0f }, 1.0f, color);
 	}
 
 	void Renderer2D::DrawQuad(const glm::vec2& position, const glm::vec2& size, const Ref<Texture2D>& texture, float tilingFactor, const glm::vec4& tintColor)
@@ -327,9 +1244,7 @@ namespace Pinecone
 	{
 		//PC_PROFILE_FUNCTION();
 
-		glm::mat4 transform = glm::translate(glm::mat4(1.0f), position)
-			* glm::scale(glm::mat4(1.0f), { size.x, size.y, 1.0f });
-		DrawQuad(transform, texture, tilingFactor, tintColor);
+		SubmitQuad(ToQuadTransform(position, size), texture.get(), { 0.0f, 0.0f, 1.0f, 1.0f }, tilingFactor, tintColor);
 	}
 
 	void Renderer2D::DrawRotatedQuad(const glm::vec2& position, const glm::vec2& size, float rotation, const glm::vec4& color)
@@ -341,10 +1256,7 @@ namespace Pinecone
 	{
 		//PC_PROFILE_FUNCTION();
 
-		glm::mat4 transform = glm::translate(glm::mat4(1.0f), position)
-			* glm::rotate(glm::mat4(1.0f), rotation, { 0.0f, 0.0f, 1.0f })
-			* glm::scale(glm::mat4(1.0f), { size.x, size.y, 1.0f });
-		DrawQuad(transform, color);
+		SubmitQuad(ToQuadTransform(position, size, rotation), nullptr, { 0.0f, 0.0f, 1.0f, 1.0f }, 1.0f, color);
 	}
 
 	void Renderer2D::DrawRotatedQuad(const glm::vec2& position, const glm::vec2& size, float rotation, const Ref<Texture2D>& texture, float tilingFactor, const glm::vec4& tintColor)
@@ -356,149 +1268,322 @@ namespace Pinecone
 	{
 		//PC_PROFILE_FUNCTION();
 
-		glm::mat4 transform = glm::translate(glm::mat4(1.0f), position)
-			* glm::rotate(glm::mat4(1.0f), rotation, { 0.0f, 0.0f, 1.0f })
-			* glm::scale(glm::mat4(1.0f), { size.x, size.y, 1.0f });
-		DrawQuad(transform, texture, tilingFactor, tintColor);
+		SubmitQuad(ToQuadTransform(position, size, rotation), texture.get(), { 0.0f, 0.0f, 1.0f, 1.0f }, tilingFactor, tintColor);
 	}
 
 	void Renderer2D::DrawQuad(const glm::mat4& transform, const glm::vec4& color)
 	{
 		//PC_PROFILE_FUNCTION();
 
-		const size_t quadVertexCount = 4;
-		const float textureIndex = 0.0f; // White Texture
-		const glm::vec2 textureCoords[] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
-		const float tilingFactor = 1.0f;
+		SubmitQuad(ToQuadTransform(transform), nullptr, { 0.0f, 0.0f, 1.0f, 1.0f }, 1.0f, color);
+	}
 
-		// If the number of indices has surpassed the max number of indices. Then we start the next batch
-		if (s_Data.QuadIndexCount >= Renderer2DData::MaxIndices)
-			NextBatch();
+	void Renderer2D::DrawQuad(const glm::mat4& transform, const Ref<Texture2D>& texture, float tilingFactor, const glm::vec4& tintColor, const glm::vec2& flipAxies)
+	{
+		//PC_PROFILE_FUNCTION();
 
-		// Set the vertex data for every vertex in a quad
-		for (size_t i = 0; i < quadVertexCount; i++)
-		{
-			s_Data.QuadVertexBufferPtr->Position = transform * s_Data.QuadVertexPositions[i];
-			s_Data.QuadVertexBufferPtr->Color = color;
-			s_Data.QuadVertexBufferPtr->TexCoord = textureCoords[i];
-			s_Data.QuadVertexBufferPtr->TexIndex = textureIndex;
-			s_Data.QuadVertexBufferPtr->TilingFactor = tilingFactor;
-			s_Data.QuadVertexBufferPtr++;
-		}
+		// Flipping negates the texture coordinates, the texture wraps around so this mirrors it
+		glm::vec2 textCoordFlip = { flipAxies.x ? -1.0f : 1.0f, flipAxies.y ? -1.0f : 1.0f };
+		SubmitQuad(ToQuadTransform(transform), texture.get(), { 0.0f, 0.0f, textCoordFlip.x, textCoordFlip.y }, tilingFactor, tintColor);
+	}
 
-		// Increment the index count by the number of indices needed for a quad
-		s_Data.QuadIndexCount += 6;
+	void Renderer2D::DrawQuad(const glm::vec2& position, const glm::vec2& size, const Ref<SubTexture2D>& subTexture, const glm::vec4& tintColor)
+	{
+		DrawQuad({ position.x, position.y, 0.0f }, size, subTexture, tintColor);
+	}
 
-		// Update the number of quads in the statistics
-		s_Data.Stats.QuadCount++;
+	void Renderer2D::DrawQuad(const glm::vec3& position, const glm::vec2& size, const Ref<SubTexture2D>& subTexture, const glm::vec4& tintColor)
+	{
+		//PC_PROFILE_FUNCTION();
+
+		const glm::vec2& min = subTexture->GetMin();
+		const glm::vec2& max = subTexture->GetMax();
+		SubmitQuad(ToQuadTransform(position, size), subTexture->GetTexture().get(), { min.x, min.y, max.x, max.y }, 1.0f, tintColor);
 	}
 
-	void Renderer2D::DrawQuad(const glm::mat4& transform, const Ref<Texture2D>& texture, float tilingFactor, const glm::vec4& tintColor, const glm::vec2& flipAxies)
+	void Renderer2D::DrawQuad(const glm::mat4& transform, const Ref<SubTexture2D>& subTexture, const glm::vec4& tintColor, const glm::vec2& flipAxies)
 	{
 		//PC_PROFILE_FUNCTION();
 
-		constexpr size_t quadVertexCount = 4;
-		constexpr glm::vec2 textureCoords[] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
-		glm::vec2 textCoordFlip = { flipAxies.x ? -1.0f : 1.0f, flipAxies.y ? -1.0f : 1.0f };
+		// Sub textures do not wrap around, so flipping swaps the corners of the region instead
+		glm::vec2 min = subTexture->GetMin();
+		glm::vec2 max = subTexture->GetMax();
+		if (flipAxies.x)
+			std::swap(min.x, max.x);
+		if (flipAxies.y)
+			std::swap(min.y, max.y);
 
-		// If the number of indices has surpassed the max number of indices. Then we start the next batch
-		if (s_Data.QuadIndexCount >= Renderer2DData::MaxIndices)
-			NextBatch();
+		SubmitQuad(ToQuadTransform(transform), subTexture->GetTexture().get(), { min.x, min.y, max.x, max.y }, 1.0f, tintColor);
+	}
 
-		// Find what texture slot the texture we want to render is at
-		float textureIndex = 0.0f;
-		for (uint32_t i = 1; i < s_Data.TextureSlotIndex; i++)
+	void Renderer2D::DrawQuads(const QuadInstance* quads, uint32_t count, const Ref<Texture2D>& texture, float tilingFactor)
+	{
+		PC_PROFILE_FUNCTION();
+
+		// Recording and sorted submission need every quad on its own, so draw them one at a time
+		if (t_RecordingContext || (s_Data.SortedSubmission && !s_Data.ExecutingSortedCommands))
 		{
-			if (*s_Data.TextureSlots[i] == *texture)
+			for (uint32_t i = 0; i < count; i++)
+				SubmitQuad(ToQuadTransform(quads[i]), texture.get(), quads[i].TexRect, tilingFactor, quads[i].Color);
+			return;
+		}
+
+		// The texture slot only has to be looked up once per batch, -1 means it has not been looked up yet
+		float textureIndex = -1.0f;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (s_Data.QuadInstancing ? s_Data.QuadInstanceCount >= Renderer2DData::MaxQuads : IsQuadVertexBatchFull())
 			{
-				textureIndex = (float)i;
-				break;
+				NextQuadBatch();
+				textureIndex = -1.0f;
 			}
+
+			if (textureIndex < 0.0f)
+				textureIndex = texture ? GetTextureIndex(texture.get()) : 0.0f;
+
+			const QuadInstance& quad = quads[i];
+			if (s_Data.QuadInstancing)
+				WriteQuadInstance(ToQuadTransform(quad), quad.Color, textureIndex, tilingFactor, quad.TexRect);
+			else
+				WriteQuadVertices(ToQuadTransform(quad), quad.Color, textureIndex, tilingFactor, quad.TexRect);
 		}
+	}
 
-		// Check if we could not find the texture
-		// Note: Texture slot 0 is not used in this function as that is our white texture
-		//		 for drawing plain colored quads
-		if (textureIndex == 0.0f)
-		{
-			// Start a new batch if we exceed our max number of texture slots
-			if (s_Data.TextureSlotIndex >= Renderer2DData::MaxTextureSlots)
-				NextBatch();
+	void Renderer2D::DrawQuads(const std::vector<QuadInstance>& quads, const Ref<Texture2D>& texture, float tilingFactor)
+	{
+		DrawQuads(quads.data(), (uint32_t)quads.size(), texture, tilingFactor);
+	}
+
+	float Renderer2D::GetTextureIndex(const Texture2D* texture)
+	{
+		// Find what texture slot the texture we want to render is at
+		uint32_t rendererID = texture->GetRendererID();
+		int32_t slot = s_Data.TextureSlotLookup.Find(rendererID);
+		if (slot >= 0)
+			return (float)slot;
+
+		// Start a new batch if we exceed our max number of texture slots
+		if (s_Data.TextureSlotIndex >= Renderer2DData::MaxTextureSlots)
+			NextQuadBatch();
+
+		// Set the texture in the texture slot at the current index
+		float textureIndex = (float)s_Data.TextureSlotIndex;
+		s_Data.TextureSlots[s_Data.TextureSlotIndex] = texture;
+		s_Data.TextureSlotLookup.Insert(rendererID, s_Data.TextureSlotIndex);
+		// Increase the current texture slot to be the next slot
+		s_Data.TextureSlotIndex++;
+		return textureIndex;
+	}
+
+	float Renderer2D::GetFontAtlasIndex(const Ref<Texture2D>& atlas)
+	{
+		// Find what slot the font atlas is at
+		uint32_t rendererID = atlas->GetRendererID();
+		int32_t slot = s_Data.FontAtlasSlotLookup.Find(rendererID);
+		if (slot >= 0)
+			return (float)slot;
+
+		// Start a new batch if we exceed our max number of font atlas slots
+		if (s_Data.FontAtlasSlotIndex >= Renderer2DData::MaxFontAtlasSlots)
+			NextTextBatch();
+
+		float atlasIndex = (float)s_Data.FontAtlasSlotIndex;
+		s_Data.FontAtlasSlots[s_Data.FontAtlasSlotIndex] = atlas;
+		s_Data.FontAtlasSlotLookup.Insert(rendererID, s_Data.FontAtlasSlotIndex);
+		s_Data.FontAtlasSlotIndex++;
+		return atlasIndex;
+	}
 
-			// Set the texture in the texture slot at the current index
-			textureIndex = (float)s_Data.TextureSlotIndex;
-			s_Data.TextureSlots[s_Data.TextureSlotIndex] = texture;
-			// Increase the current texture slot to be the next slot
-			s_Data.TextureSlotIndex++;
+	void Renderer2D::SubmitQuad(const QuadTransform& transform, const Texture2D* texture, const glm::vec4& texRect, float tilingFactor, const glm::vec4& tintColor)
+	{
+		// Threads that are recording never touch the shared batch
+		if (t_RecordingContext)
+		{
+			RecordQuad(*t_RecordingContext, transform, texture, texRect, tilingFactor, tintColor);
+			return;
 		}
 
-		// Set the vertex data for every vertex in a quad
-		for (size_t i = 0; i < quadVertexCount; i++)
+		// Record the quad to be sorted and drawn at the end of the scene
+		if (s_Data.SortedSubmission && !s_Data.ExecutingSortedCommands)
 		{
-			s_Data.QuadVertexBufferPtr->Position = transform * s_Data.QuadVertexPositions[i];
-			s_Data.QuadVertexBufferPtr->Color = tintColor;
-			s_Data.QuadVertexBufferPtr->TexCoord = textureCoords[i] * textCoordFlip;
-			s_Data.QuadVertexBufferPtr->TexIndex = textureIndex;
-			s_Data.QuadVertexBufferPtr->TilingFactor = tilingFactor;
-			s_Data.QuadVertexBufferPtr++;
+			uint32_t rendererID = texture ? texture->GetRendererID() : s_Data.WhiteTexture->GetRendererID();
+			s_Data.SortItems.push_back({ BuildSortKey(transform.Z.z, SortPipeline::Quad, rendererID), (uint32_t)s_Data.QuadCommands.size() });
+			s_Data.QuadCommands.push_back({ transform, tintColor, texRect, texture, tilingFactor });
+			return;
 		}
 
-		// Increment the index count by the number of indices needed for a quad
-		s_Data.QuadIndexCount += 6;
+		// If the quad does not fit in the batch any more then we start the next batch
+		if (s_Data.QuadInstancing ? s_Data.QuadInstanceCount >= Renderer2DData::MaxQuads : IsQuadVertexBatchFull())
+			NextQuadBatch();
 
-		// Update the number of quads in the statistics
-		s_Data.Stats.QuadCount++;
+		// Colored quads use the white texture, which is always in slot 0
+		float textureIndex = texture ? GetTextureIndex(texture) : 0.0f;
+
+		if (s_Data.QuadInstancing)
+			WriteQuadInstance(transform, tintColor, textureIndex, tilingFactor, texRect);
+		else
+			WriteQuadVertices(transform, tintColor, textureIndex, tilingFactor, texRect);
 	}
 
-	void Renderer2D::DrawLine(const glm::vec2& p0, const glm::vec2& p1, const glm::vec4& color)
+	void Renderer2D::DrawLine(const glm::vec2& p0, const glm::vec2& p1, const glm::vec4& color, float width)
 	{
-		DrawLine(glm::vec3(p0, 0.0f), glm::vec3(p1, 0.0f), color);
+		DrawLine(glm::vec3(p0, 0.0f), glm::vec3(p1, 0.0f), color, width);
 	}
 
-	void Renderer2D::DrawLine(const glm::vec3& p0, const glm::vec3& p1, const glm::vec4& color)
+	void Renderer2D::DrawLine(const glm::vec3& p0, const glm::vec3& p1, const glm::vec4& color, float width)
 	{
 		//PC_PROFILE_FUNCTION();
 
-		s_Data.LineVertexBufferPtr->Position = p0;
-		s_Data.LineVertexBufferPtr->Color = color;
-		s_Data.LineVertexBufferPtr++;
+		PC_CORE_ASSERT(!t_RecordingContext, "Lines can not be drawn while recording!");
+
+		// Only the line pipeline has to start a new batch when it is full
+		if (s_Data.LineCount >= Renderer2DData::MaxLines)
+			NextLineBatch();
+
+		s_Data.LineBufferPtr->Start = p0;
+		s_Data.LineBufferPtr->End = p1;
+		s_Data.LineBufferPtr->Color = PackColor(color);
+		s_Data.LineBufferPtr->Width = width;
+		s_Data.LineBufferPtr++;
+
+		s_Data.LineCount++;
+		s_Data.Stats.LineCount++;
+	}
+
+	void Renderer2D::DrawLineStrip(const glm::vec3* points, uint32_t count, const glm::vec4& color, float width)
+	{
+		PC_PROFILE_FUNCTION();
+
+		PC_CORE_ASSERT(!t_RecordingContext, "Lines can not be drawn while recording!");
+
+		const uint32_t packedColor = PackColor(color);
+		for (uint32_t i = 1; i < count; i++)
+		{
+			if (s_Data.LineCount >= Renderer2DData::MaxLines)
+				NextLineBatch();
+
+			s_Data.LineBufferPtr->Start = points[i - 1];
+			s_Data.LineBufferPtr->End = points[i];
+			s_Data.LineBufferPtr->Color = packedColor;
+			s_Data.LineBufferPtr->Width = width;
+			s_Data.LineBufferPtr++;
 
-		s_Data.LineVertexBufferPtr->Position = p1;
-		s_Data.LineVertexBufferPtr->Color = color;
-		s_Data.LineVertexBufferPtr++;
+			s_Data.LineCount++;
+			s_Data.Stats.LineCount++;
+		}
+	}
+
+	void Renderer2D::DrawLineStrip(const std::vector<glm::vec3>& points, const glm::vec4& color, float width)
+	{
+		DrawLineStrip(points.data(), (uint32_t)points.size(), color, width);
+	}
+
+	void Renderer2D::DrawCircle(const glm::vec3& position, float radius, const glm::vec4& color, float thickness, float fade)
+	{
+		SubmitShape(ToQuadTransform(position, { radius * 2.0f, radius * 2.0f }), ShapeType::Circle, color, { thickness, fade, 0.0f });
+	}
+
+	void Renderer2D::DrawCircle(const glm::mat4& transform, const glm::vec4& color, float thickness, float fade)
+	{
+		SubmitShape(ToQuadTransform(transform), ShapeType::Circle, color, { thickness, fade, 0.0f });
+	}
+
+	void Renderer2D::DrawRoundedRect(const glm::vec3& position, const glm::vec2& size, float cornerRadius, const glm::vec4& color, float thickness, float fade)
+	{
+		SubmitShape(ToQuadTransform(position, size), ShapeType::RoundedRect, color, { thickness, fade, cornerRadius });
+	}
 
-		s_Data.LineVertexCount += 2;
+	void Renderer2D::DrawRoundedRect(const glm::mat4& transform, float cornerRadius, const glm::vec4& color, float thickness, float fade)
+	{
+		SubmitShape(ToQuadTransform(transform), ShapeType::RoundedRect, color, { thickness, fade, cornerRadius });
 	}
 
 	void Renderer2D::DrawSprite(const glm::mat4& transform, SpriteComponent& sprite)
 	{
-		// If the sprites texture is not null, draw a textured quad. Otherwise draw a colored quad
-		if (sprite.Texture)
-			DrawQuad(transform, sprite.Texture, sprite.TilingFactor, sprite.Color, sprite.FlipAxies);
+		// Sprites from a texture atlas are drawn with their region of the atlas page. Otherwise
+		// if the sprites texture is not null, draw a textured quad. Otherwise draw a colored quad
+		if (sprite.SubTexture)
+			DrawQuad(transform, sprite.SubTexture, sprite.Color, sprite.FlipAxies);
+		else if (const Ref<Texture2D>& texture = AssetManager::GetTexture(sprite.Texture))
+			DrawQuad(transform, texture, sprite.TilingFactor, sprite.Color, sprite.FlipAxies);
 		else
 			DrawQuad(transform, sprite.Color);
 	}
 
+	void Renderer2D::DrawSpriteBuffer(const Ref<SpriteBuffer>& buffer)
+	{
+		PC_PROFILE_FUNCTION();
+
+		PC_CORE_ASSERT(!t_RecordingContext, "Sprite buffers can not be drawn while recording!");
+
+		buffer->Upload();
+		if (!buffer->GetSlotCount())
+			return;
+
+		// Draw everything submitted so far first, so the sprites blend over it in the order it was drawn.
+		// That includes the sorted draws, which would otherwise wait for the end of the scene
+		if (s_Data.SortedSubmission)
+			ExecuteSortedCommands();
+		Flush();
+		StartBatch();
+
+		// The buffer has its own texture table, slot 0 is still the white texture
+		s_Data.WhiteTexture->Bind(0);
+		const auto& textures = buffer->GetTextures();
+		for (uint32_t i = 0; i < (uint32_t)textures.size(); i++)
+		{
+			if (textures[i])
+				textures[i]->Bind(i + 1);
+		}
+
+		s_Data.QuadInstanceShader->Bind();
+		RenderCommand::DrawInstanced(buffer->GetVertexArray(), 6, buffer->GetSlotCount());
+		s_Data.Stats.DrawCalls++;
+		s_Data.Stats.QuadCount += buffer->GetSpriteCount();
+	}
+
 	void Renderer2D::DrawString(const std::string& string, Ref<Font> font, const glm::mat4& transform, const glm::vec4& color)
 	{
 		//PC_PROFILE_FUNCTION();
 
-		const auto& fontGeometry = font->GetMSDFData()->FontGeometry;
-		const auto& metrics = fontGeometry.getMetrics();
-		Ref<Texture2D> fontAtlas = font->GetAtlasTexture();
+		PC_CORE_ASSERT(!t_RecordingContext, "Strings can not be drawn while recording!");
 
-		// Set the font atlas texture to the texture created by the specified font
-		s_Data.FontAtlasTexture = fontAtlas;
+		// Record the string to be sorted and drawn at the end of the scene
+		if (s_Data.SortedSubmission && !s_Data.ExecutingSortedCommands)
+		{
+			s_Data.SortItems.push_back({ BuildSortKey(transform[3][2], SortPipeline::Text, font->GetAtlasTexture()->GetRendererID()), (uint32_t)s_Data.TextCommands.size() });
+			s_Data.TextCommands.push_back({ (uint32_t)s_Data.TextArena.size(), (uint32_t)string.size(), font.get(), transform, color });
+			s_Data.TextArena.insert(s_Data.TextArena.end(), string.begin(), string.end());
+			return;
+		}
+
+		SubmitString(string, font.get(), transform, color);
+	}
+
+	void Renderer2D::SubmitString(std::string_view string, Font* font, const glm::mat4& transform, const glm::vec4& color)
+	{
+		// Glyphs requested by earlier strings may be ready now
+		font->UploadRasterizedGlyphs();
+
+		// If the font can not show unknown characters then exit the function and draw no text
+		const int32_t fallbackGlyph = font->GetGlyphIndex('?');
+		if (fallbackGlyph < 0)
+			return;
+		const int32_t spaceGlyph = font->GetGlyphIndex(' ');
+		const float lineHeight = font->GetLineHeight();
+
+		// The glyph quads are flat, so only the x and y axes and the origin of the transform are needed
+		const glm::vec3 xAxis = transform[0];
+		const glm::vec3 yAxis = transform[1];
+		const glm::vec3 origin = transform[3];
 
-		double x = 0.0;
-		double fsScale = 1.0 / (metrics.ascenderY - metrics.descenderY);
-		double y = 0.0;
-		float lineHeightOffset = 0.0f;
+		float x = 0.0f;
+		float y = 0.0f;
 
 		// Loop through each character in the string
-		for (size_t i = 0; i < string.size(); i++)
+		for (size_t i = 0; i < string.size();)
 		{
-			char character = string[i];
+			uint32_t character = DecodeUTF8(string, i);
 			// If it is a return character, skip
 			if (character == '\r')
 				continue;
@@ -507,64 +1592,64 @@ namespace Pinecone
 			{
 				// Newline characters will reset the x position to 0 and increase the y position
 				// by the height of the text
-				x = 0;
-				y -= fsScale * metrics.lineHeight + lineHeightOffset;
+				x = 0.0f;
+				y -= lineHeight;
 				continue;
 			}
-			// Get the glyph data from our font
-			auto glyph = fontGeometry.getGlyph(character);
-			// If it is unknown, use a different char that should be known to indicate that the font
-			// does not support that char
-			if (!glyph)
-				glyph = fontGeometry.getGlyph('?');
-			// If still unknown then exit the function and draw no text
-			if (!glyph)
-				return;
-
-			// If the char is a tab then we will use ' ' as the glyph
+
+			// Get the glyph from our font. If the char is a tab then we will use ' ' as the glyph.
+			// If it is not loaded, request it and use a different char that should be known until
+			// it is ready (or forever if the font does not support that char). Kerning only applies
+			// to chars that use their own glyph
+			int32_t glyphIndex = font->GetGlyphIndex(character);
+			bool kerning = glyphIndex >= 0;
 			if (character == '\t')
-				glyph = fontGeometry.getGlyph(' ');
+			{
+				glyphIndex = spaceGlyph;
+				kerning = false;
+			}
+			else if (glyphIndex < 0)
+			{
+				font->RequestGlyph(character);
+				glyphIndex = fallbackGlyph;
+			}
 
-			// Get the texture coordinates for the glyph in the font texture atlas
-			double al, ab, ar, at;
-			glyph->getQuadAtlasBounds(al, ab, ar, at);
-			glm::vec2 texCoordMin((float)al, (float)ab);
-			glm::vec2 texCoordMax((float)ar, (float)at);
+			const FontGlyph& glyph = font->GetGlyph((uint32_t)glyphIndex);
 
-			float texelWidth = 1.0f / fontAtlas->GetWidth();
-			float texelHeight = 1.0f / fontAtlas->GetHeight();
-			texCoordMin *= glm::vec2(texelWidth, texelHeight);
-			texCoordMax *= glm::vec2(texelWidth, texelHeight);
+			// If the number of indices has surpassed the max number of indices. Then we start the next batch
+			if (s_Data.TextIndexCount >= Renderer2DData::MaxIndices)
+				NextTextBatch();
 
-			// Get the size of the glyph
-			double pl, pb, pr, pt;
-			glyph->getQuadPlaneBounds(pl, pb, pr, pt);
-			glm::vec2 quadMin((float)pl, (float)pb);
-			glm::vec2 quadMax((float)pr, (float)pt);
+			// Every font and glyph page has its own atlas texture, find the slot it is in
+			const float atlasIndex = GetFontAtlasIndex(font->GetPageTexture(glyph.Page));
+			font->TouchPage(glyph.Page);
 
-			quadMin *= fsScale, quadMax *= fsScale;
-			quadMin += glm::vec2(x, y);
-			quadMax += glm::vec2(x, y);
+			glm::vec2 quadMin = glyph.QuadMin + glm::vec2(x, y);
+			glm::vec2 quadMax = glyph.QuadMax + glm::vec2(x, y);
 
 			// Set the vertex data for the single char to draw
-			s_Data.TextVertexBufferPtr->Position = transform * glm::vec4(quadMin, 0.0f, 1.0f);
+			s_Data.TextVertexBufferPtr->Position = origin + xAxis * quadMin.x + yAxis * quadMin.y;
 			s_Data.TextVertexBufferPtr->Color = color;
-			s_Data.TextVertexBufferPtr->TexCoord = texCoordMin;
+			s_Data.TextVertexBufferPtr->TexCoord = glyph.TexCoordMin;
+			s_Data.TextVertexBufferPtr->AtlasIndex = atlasIndex;
 			s_Data.TextVertexBufferPtr++;
 
-			s_Data.TextVertexBufferPtr->Position = transform * glm::vec4(quadMin.x, quadMax.y, 0.0f, 1.0f);
+			s_Data.TextVertexBufferPtr->Position = origin + xAxis * quadMin.x + yAxis * quadMax.y;
 			s_Data.TextVertexBufferPtr->Color = color;
-			s_Data.TextVertexBufferPtr->TexCoord = { texCoordMin.x, texCoordMax.y };
+			s_Data.TextVertexBufferPtr->TexCoord = { glyph.TexCoordMin.x, glyph.TexCoordMax.y };
+			s_Data.TextVertexBufferPtr->AtlasIndex = atlasIndex;
 			s_Data.TextVertexBufferPtr++;
 
-			s_Data.TextVertexBufferPtr->Position = transform * glm::vec4(quadMax, 0.0f, 1.0f);
+			s_Data.TextVertexBufferPtr->Position = origin + xAxis * quadMax.x + yAxis * quadMax.y;
 			s_Data.TextVertexBufferPtr->Color = color;
-			s_Data.TextVertexBufferPtr->TexCoord = texCoordMax;
+			s_Data.TextVertexBufferPtr->TexCoord = glyph.TexCoordMax;
+			s_Data.TextVertexBufferPtr->AtlasIndex = atlasIndex;
 			s_Data.TextVertexBufferPtr++;
 
-			s_Data.TextVertexBufferPtr->Position = transform * glm::vec4(quadMax.x, quadMin.y, 0.0f, 1.0f);
+			s_Data.TextVertexBufferPtr->Position = origin + xAxis * quadMax.x + yAxis * quadMin.y;
 			s_Data.TextVertexBufferPtr->Color = color;
-			s_Data.TextVertexBufferPtr->TexCoord = { texCoordMax.x, texCoordMin.y };
+			s_Data.TextVertexBufferPtr->TexCoord = { glyph.TexCoordMax.x, glyph.TexCoordMin.y };
+			s_Data.TextVertexBufferPtr->AtlasIndex = atlasIndex;
 			s_Data.TextVertexBufferPtr++;
 
 			// Increment the index count by the number of indices needed for a quad
@@ -573,24 +1658,21 @@ namespace Pinecone
 			s_Data.Stats.QuadCount++;
 
 			// Advance the x position if there is more chars in the string to render
-			if (i < string.size() - 1)
+			if (i < string.size())
 			{
-				double advance = glyph->getAdvance();
-				char nextCharacter = string[i + 1];
-				fontGeometry.getAdvance(advance, character, nextCharacter);
+				x += glyph.Advance;
 
-				float kerningOffset = 0.0f;
-				x += fsScale * advance + kerningOffset;
+				size_t next = i;
+				int32_t nextGlyph = font->GetGlyphIndex(DecodeUTF8(string, next));
+				if (kerning && nextGlyph >= 0)
+					x += font->GetKerning((uint32_t)glyphIndex, (uint32_t)nextGlyph);
 			}
 		}
 	}
 
-	void Renderer2D::NextBatch()
+	void Renderer2D::AddCulledCount(uint32_t count)
 	{
-		// Draw the current batch
-		Flush();
-		// Then stat the new batch
-		StartBatch();
+		s_Data.Stats.CulledCount += count;
 	}
 
 	void Renderer2D::ResetStats()
@@ -2,12 +2,28 @@
 
 #include "Pinecone/Renderer/Camera.h"
 #include "Pinecone/Renderer/Texture2D.h"
+#include "Pinecone/Renderer/SubTexture2D.h"
 #include "Pinecone/Renderer/Font.h"
+#include "Pinecone/Renderer/SpriteBuffer.h"
 
 #include "Pinecone/Scene/Components.h"
 
 namespace Pinecone
 {
+	struct QuadTransform;
+
+	/// <summary>
+	/// A quad drawn with Renderer2D::DrawQuads
+	/// </summary>
+	struct QuadInstance
+	{
+		glm::vec3 Position = { 0.0f, 0.0f, 0.0f };
+		glm::vec2 Size = { 1.0f, 1.0f };
+		float Rotation = 0.0f; // In radians
+		glm::vec4 Color = { 1.0f, 1.0f, 1.0f, 1.0f };
+		glm::vec4 TexRect = { 0.0f, 0.0f, 1.0f, 1.0f }; // Texture coordinates of the bottom left (xy) and top right (zw) corners
+	};
+
 	class Renderer2D
 	{
 	public:
@@ -40,6 +56,65 @@ namespace Pinecone
 		/// </summary>
 		static void Flush();
 
+		/// <summary>
+		/// Set whether quads are drawn with the instanced quad pipeline. Instead of 4 vertices, each
+		/// quad is submitted as a single compact instance and its corners are expanded in the shader.
+		/// Changing this in the middle of a scene is allowed, both pipelines are flushed together.
+		/// </summary>
+		/// <param name="enabled">True to draw quads as instances</param>
+		static void SetQuadInstancing(bool enabled);
+		/// <summary>
+		/// Are quads drawn with the instanced quad pipeline?
+		/// </summary>
+		/// <returns>True if quads are drawn as instances</returns>
+		static bool IsQuadInstancing();
+
+		/// <summary>
+		/// Set whether draws are sorted before they are drawn. When enabled, quads, sprites, shapes and strings
+		/// are recorded as commands with a sort key built from the sort layer, depth, pipeline and
+		/// texture. At EndScene the commands are sorted and then drawn, which groups draws that share
+		/// a texture into the same batch. Lines are always drawn in submission order.
+		/// </summary>
+		/// <param name="enabled">True to sort draws</param>
+		static void SetSortedSubmission(bool enabled);
+		/// <summary>
+		/// Are draws sorted before they are drawn?
+		/// </summary>
+		/// <returns>True if draws are sorted</returns>
+		static bool IsSortedSubmission();
+		/// <summary>
+		/// Set the sort layer of the draws that follow. Lower layers are drawn first. Only used when
+		/// sorted submission is enabled, within a layer draws are ordered from back to front by depth
+		/// </summary>
+		/// <param name="layer">The sort layer</param>
+		static void SetSortLayer(uint8_t layer);
+
+		/// <summary>
+		/// Set the number of recording contexts. Recording contexts let other threads draw quads and
+		/// sprites, each context has its own vertex staging buffer and texture list. This must be
+		/// called from the render thread while nothing is recording
+		/// </summary>
+		/// <param name="count">The number of recording contexts</param>
+		static void SetRecordingContextCount(uint32_t count);
+		/// <summary>
+		/// Get the number of recording contexts
+		/// </summary>
+		/// <returns>The number of recording contexts</returns>
+		static uint32_t GetRecordingContextCount();
+		/// <summary>
+		/// Start recording the quads and sprites drawn on the calling thread into a recording context.
+		/// Call this between BeginScene and EndScene, only one thread can record into a context at a time.
+		/// At EndScene the contexts are merged into the batch in context index order after the draws
+		/// made on the render thread, so the result does not depend on how the threads were scheduled.
+		/// Lines, shapes and strings can not be drawn while recording
+		/// </summary>
+		/// <param name="contextIndex">The index of the recording context</param>
+		static void BeginRecording(uint32_t contextIndex);
+		/// <summary>
+		/// Stop recording on the calling thread, draws made after this go straight to the batch again
+		/// </summary>
+		static void EndRecording();
+
 		/// <summary>
 		/// Draw a 2D quad with a given position, size, and color
 		/// </summary>
@@ -127,8 +202,123 @@ namespace Pinecone
 		/// <param name="tintColor">The tint color (leave as white to render the texture in full colors)</param>
 		static void DrawQuad(const glm::mat4& transform, const Ref<Texture2D>& texture, float tilingFactor = 1.0f, const glm::vec4& tintColor = glm::vec4(1.0f), const glm::vec2& flipAxies = { 0.0f, 0.0f });
 
-		static void DrawLine(const glm::vec2& p0, const glm::vec2& p1, const glm::vec4& color);
-		static void DrawLine(const glm::vec3& p0, const glm::vec3& p1, const glm::vec4& color);
+		/// <summary>
+		/// Draw a 2D quad with a given position, size, and sub texture (such as a region of a texture atlas)
+		/// </summary>
+		/// <param name="position">The position to draw the quad</param>
+		/// <param name="size">The size of the quad</param>
+		/// <param name="subTexture">The sub texture to render the quad with</param>
+		/// <param name="tintColor">The tint color (leave as white to render the texture in full colors)</param>
+		static void DrawQuad(const glm::vec2& position, const glm::vec2& size, const Ref<SubTexture2D>& subTexture, const glm::vec4& tintColor = glm::vec4(1.0f));
+		/// <summary>
+		/// Draw a 2D quad with a given position, size, and sub texture (such as a region of a texture atlas)
+		/// </summary>
+		/// <param name="position">The position to draw the quad</param>
+		/// <param name="size">The size of the quad</param>
+		/// <param name="subTexture">The sub texture to render the quad with</param>
+		/// <param name="tintColor">The tint color (leave as white to render the texture in full colors)</param>
+		static void DrawQuad(const glm::vec3& position, const glm::vec2& size, const Ref<SubTexture2D>& subTexture, const glm::vec4& tintColor = glm::vec4(1.0f));
+		/// <summary>
+		/// Draw a 2D quad with a given transform matrix and a sub texture (such as a region of a texture atlas).
+		/// Sub textures do not repeat, so there is no tiling factor
+		/// </summary>
+		/// <param name="transform">The quads transform</param>
+		/// <param name="subTexture">The sub texture to render the quad with</param>
+		/// <param name="tintColor">The tint color (leave as white to render the texture in full colors)</param>
+		/// <param name="flipAxies">Which axies the sub texture should be flipped on</param>
+		static void DrawQuad(const glm::mat4& transform, const Ref<SubTexture2D>& subTexture, const glm::vec4& tintColor = glm::vec4(1.0f), const glm::vec2& flipAxies = { 0.0f, 0.0f });
+
+		/// <summary>
+		/// Draw many quads at once. This is much faster than calling DrawQuad for every quad, use it
+		/// for particles, tile maps and anything else that draws lots of quads with the same texture
+		/// </summary>
+		/// <param name="quads">The quads to draw</param>
+		/// <param name="count">The number of quads</param>
+		/// <param name="texture">The texture to render the quads with (leave as null for colored quads)</param>
+		/// <param name="tilingFactor">How should the texture be tiled (1 is to show the full texture without tiling)</param>
+		static void DrawQuads(const QuadInstance* quads, uint32_t count, const Ref<Texture2D>& texture = nullptr, float tilingFactor = 1.0f);
+		/// <summary>
+		/// Draw many quads at once
+		/// </summary>
+		/// <param name="quads">The quads to draw</param>
+		/// <param name="texture">The texture to render the quads with (leave as null for colored quads)</param>
+		/// <param name="tilingFactor">How should the texture be tiled (1 is to show the full texture without tiling)</param>
+		static void DrawQuads(const std::vector<QuadInstance>& quads, const Ref<Texture2D>& texture = nullptr, float tilingFactor = 1.0f);
+
+		/// <summary>
+		/// Draw a line between two points. Lines have round ends, so the lines of a strip or
+		/// outline join up without gaps
+		/// </summary>
+		/// <param name="p0">The start of the line</param>
+		/// <param name="p1">The end of the line</param>
+		/// <param name="color">The color of the line</param>
+		/// <param name="width">The width of the line in pixels</param>
+		static void DrawLine(const glm::vec2& p0, const glm::vec2& p1, const glm::vec4& color, float width = 1.0f);
+		/// <summary>
+		/// Draw a line between two points. Lines have round ends, so the lines of a strip or
+		/// outline join up without gaps
+		/// </summary>
+		/// <param name="p0">The start of the line</param>
+		/// <param name="p1">The end of the line</param>
+		/// <param name="color">The color of the line</param>
+		/// <param name="width">The width of the line in pixels</param>
+		static void DrawLine(const glm::vec3& p0, const glm::vec3& p1, const glm::vec4& color, float width = 1.0f);
+		/// <summary>
+		/// Draw a line through a list of points, with round joins between each segment
+		/// </summary>
+		/// <param name="points">The points of the line</param>
+		/// <param name="count">The number of points</param>
+		/// <param name="color">The color of the line</param>
+		/// <param name="width">The width of the line in pixels</param>
+		static void DrawLineStrip(const glm::vec3* points, uint32_t count, const glm::vec4& color, float width = 1.0f);
+		/// <summary>
+		/// Draw a line through a list of points, with round joins between each segment
+		/// </summary>
+		/// <param name="points">The points of the line</param>
+		/// <param name="color">The color of the line</param>
+		/// <param name="width">The width of the line in pixels</param>
+		static void DrawLineStrip(const std::vector<glm::vec3>& points, const glm::vec4& color, float width = 1.0f);
+
+		/// <summary>
+		/// Draw a circle, either filled or as a ring. The circle is drawn as a single quad and shaped
+		/// in the shader, so it is smooth at any size and uses no texture slot. Circles and rounded
+		/// rectangles are drawn in the quad batch, so they keep their submission order with quads.
+		/// Without quad instancing, a quad drawn after a shape starts a new batch to stay on top of it
+		/// </summary>
+		/// <param name="position">The center of the circle</param>
+		/// <param name="radius">The radius of the circle</param>
+		/// <param name="color">The color of the circle</param>
+		/// <param name="thickness">The thickness of the ring as a fraction of the radius (1 is a filled circle)</param>
+		/// <param name="fade">How far the edges fade out as a fraction of the radius</param>
+		static void DrawCircle(const glm::vec3& position, float radius, const glm::vec4& color, float thickness = 1.0f, float fade = 0.005f);
+		/// <summary>
+		/// Draw a circle that fills the quad of a transform. A quad that is not square gives an ellipse
+		/// </summary>
+		/// <param name="transform">The transform of the quad the circle fills</param>
+		/// <param name="color">The color of the circle</param>
+		/// <param name="thickness">The thickness of the ring as a fraction of the radius (1 is a filled circle)</param>
+		/// <param name="fade">How far the edges fade out as a fraction of the radius</param>
+		static void DrawCircle(const glm::mat4& transform, const glm::vec4& color, float thickness = 1.0f, float fade = 0.005f);
+		/// <summary>
+		/// Draw a rectangle with rounded corners, either filled or as an outline. Like circles, it is
+		/// drawn as a single quad in the quad batch and shaped in the shader
+		/// </summary>
+		/// <param name="position">The center of the rectangle</param>
+		/// <param name="size">The size of the rectangle</param>
+		/// <param name="cornerRadius">The radius of the corners, in the same units as the size</param>
+		/// <param name="color">The color of the rectangle</param>
+		/// <param name="thickness">The thickness of the outline as a fraction of half the shortest side (1 is filled)</param>
+		/// <param name="fade">How far the edges fade out as a fraction of half the shortest side</param>
+		static void DrawRoundedRect(const glm::vec3& position, const glm::vec2& size, float cornerRadius, const glm::vec4& color, float thickness = 1.0f, float fade = 0.005f);
+		/// <summary>
+		/// Draw a rectangle with rounded corners that fills the quad of a transform
+		/// </summary>
+		/// <param name="transform">The transform of the quad the rectangle fills</param>
+		/// <param name="cornerRadius">The radius of the corners, in the same units as the scale of the transform</param>
+		/// <param name="color">The color of the rectangle</param>
+		/// <param name="thickness">The thickness of the outline as a fraction of half the shortest side (1 is filled)</param>
+		/// <param name="fade">How far the edges fade out as a fraction of half the shortest side</param>
+		static void DrawRoundedRect(const glm::mat4& transform, float cornerRadius, const glm::vec4& color, float thickness = 1.0f, float fade = 0.005f);
 
 		/// <summary>
 		/// Draw a 2D quad with a given transform and a sprite component to get the color and texture information from
@@ -136,9 +326,17 @@ namespace Pinecone
 		/// <param name="transform">The sprites transform</param>
 		/// <param name="sprite">The sprite component</param>
 		static void DrawSprite(const glm::mat4& transform, SpriteComponent& sprite);
+		/// <summary>
+		/// Draw every sprite in a sprite buffer in one draw call. Only the parts of the buffer that
+		/// changed since it was last drawn are uploaded. Anything drawn before this, sorted or not, is
+		/// drawn first, so only draws made after it are sorted with each other
+		/// </summary>
+		/// <param name="buffer">The sprite buffer</param>
+		static void DrawSpriteBuffer(const Ref<SpriteBuffer>& buffer);
 
 		/// <summary>
-		/// Draw a string with a given font, transform, and color
+		/// Draw a string with a given font, transform, and color. With sorted submission the font is
+		/// not kept alive by the renderer, so it has to stay alive until the end of the scene
 		/// </summary>
 		/// <param name="string">The string to render to the screen</param>
 		/// <param name="font">The specified font (use Font::GetDefault for the default font)</param>
@@ -150,10 +348,32 @@ namespace Pinecone
 		{
 			uint32_t DrawCalls = 0;
 			uint32_t QuadCount = 0;
+			uint32_t LineCount = 0;
+			// The number of sprites that were not drawn because the camera could not see them
+			uint32_t CulledCount = 0;
+			// The number of batches that sorted submission saved compared to drawing in submission order
+			uint32_t BatchBreaksRemoved = 0;
 
 			uint32_t GetTotalVertexCount() const { return QuadCount * 4; }
 			uint32_t GetTotalIndexCount() const { return QuadCount * 6; }
 		};
+		struct ContextStatistics
+		{
+			uint32_t QuadCount = 0;
+			uint32_t TextureCount = 0;
+		};
+		/// <summary>
+		/// Get the statistics of a recording context for the current or last scene
+		/// </summary>
+		/// <param name="contextIndex">The index of the recording context</param>
+		/// <returns>The recording context statistics</returns>
+		static ContextStatistics GetContextStats(uint32_t contextIndex);
+		/// <summary>
+		/// Add to the number of culled sprites in the statistics. Called by whatever did the culling,
+		/// as culled sprites never reach the renderer
+		/// </summary>
+		/// <param name="count">The number of sprites that were culled</param>
+		static void AddCulledCount(uint32_t count);
 		/// <summary>
 		/// Reset the 2D renderer statistics
 		/// </summary>
@@ -165,12 +385,47 @@ namespace Pinecone
 		static Statistics GetStats();
 	private:
 		/// <summary>
-		/// Initialize the batch. Reset vertex buffer information and start a new draw
+		/// Initialize the batch of every pipeline. Reset vertex buffer information and start a new draw
 		/// </summary>
 		static void StartBatch();
 		/// <summary>
-		/// Draw the current batch to the screen and start a new batch
+		/// Sort the recorded draw commands and draw them
 		/// </summary>
-		static void NextBatch();
+		static void ExecuteSortedCommands();
+		/// <summary>
+		/// Copy the quads recorded by every recording context into the batch
+		/// </summary>
+		static void MergeRecordingContexts();
+		/// <summary>
+		/// Get the texture slot of a texture in the current batch, adding it if it is not in a slot yet.
+		/// Starts a new batch if every texture slot is in use
+		/// </summary>
+		/// <param name="texture">The texture</param>
+		/// <returns>The texture slot</returns>
+		static float GetTextureIndex(const Texture2D* texture);
+		/// <summary>
+		/// Get the slot of a font atlas in the current text batch, adding it if it is not in a slot yet.
+		/// Starts a new batch if every font atlas slot is in use
+		/// </summary>
+		/// <param name="atlas">The font atlas texture</param>
+		/// <returns>The font atlas slot</returns>
+		static float GetFontAtlasIndex(const Ref<Texture2D>& atlas);
+		/// <summary>
+		/// Draw a quad using a region of a texture. Every DrawQuad overload ends up here
+		/// </summary>
+		/// <param name="transform">The quads transform</param>
+		/// <param name="texture">The texture to render the quad with (null for a colored quad)</param>
+		/// <param name="texRect">The texture coordinates of the bottom left (xy) and top right (zw) corners</param>
+		/// <param name="tilingFactor">How should the texture be tiled</param>
+		/// <param name="tintColor">The tint color</param>
+		static void SubmitQuad(const QuadTransform& transform, const Texture2D* texture, const glm::vec4& texRect, float tilingFactor, const glm::vec4& tintColor);
+		/// <summary>
+		/// Draw the glyphs of a string straight away. DrawString and sorted string commands end up here
+		/// </summary>
+		/// <param name="string">The UTF-8 string</param>
+		/// <param name="font">The font</param>
+		/// <param name="transform">The transform of the string</param>
+		/// <param name="color">The color to render the string with</param>
+		static void SubmitString(std::string_view string, Font* font, const glm::mat4& transform, const glm::vec4& color);
 	};
 }
\ No newline at end of file
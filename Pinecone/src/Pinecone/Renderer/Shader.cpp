@@ -1,12 +1,104 @@
 #include "pcpch.h"
 #include "Shader.h"
 
+#include "Pinecone/Core/MappedFile.h"
+#include "Pinecone/Core/Hash.h"
+
 #include <fstream>
 #include <glad/glad.h>
+#include <GLFW/glfw3.h>
 #include <glm/gtc/type_ptr.hpp>
 
+// From KHR_parallel_shader_compile, which is not part of the core profile
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
 namespace Pinecone
 {
+	// Shaders loaded from files have their linked programs cached here, so they never have to be compiled again
+	static const std::filesystem::path s_ShaderCacheDirectory = "assets/cache/shaders";
+
+	/// <summary>
+	/// The start of a cached program binary file, followed by the program binary itself
+	/// </summary>
+	struct ShaderCacheHeader
+	{
+		// Bump the version whenever the layout of the file changes
+		static const uint32_t CurrentMagic = 0x48534350; // "PCSH"
+		static const uint32_t CurrentVersion = 1;
+
+		uint32_t Magic;
+		uint32_t Version;
+		uint64_t Key; // Identifies the source and the driver the program was compiled with
+		uint32_t BinaryFormat;
+		uint32_t BinarySize;
+	};
+
+	/// <summary>
+	/// Let the driver compile shaders on its own threads if it supports KHR_parallel_shader_compile (or
+	/// the ARB version of it). Only checked once, the first time a shader is created
+	/// </summary>
+	static void EnableParallelCompile()
+	{
+		static bool checked = false;
+		if (checked)
+			return;
+		checked = true;
+
+		const char* functionName = nullptr;
+		if (glfwExtensionSupported("GL_KHR_parallel_shader_compile"))
+			functionName = "glMaxShaderCompilerThreadsKHR";
+		else if (glfwExtensionSupported("GL_ARB_parallel_shader_compile"))
+			functionName = "glMaxShaderCompilerThreadsARB";
+
+		auto maxShaderCompilerThreads = functionName ? (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)glfwGetProcAddress(functionName) : nullptr;
+		if (!maxShaderCompilerThreads)
+		{
+			PC_CORE_INFO("Parallel shader compilation is not supported, shaders are compiled one at a time");
+			return;
+		}
+
+		// Let the driver pick how many threads it uses
+		maxShaderCompilerThreads(0xFFFFFFFF);
+	}
+
+	/// <summary>
+	/// Get the key a program binary is cached with. It changes whenever the source changes or the
+	/// program is loaded by a different driver, whose binaries would not be compatible
+	/// </summary>
+	/// <param name="source">The shader source code</param>
+	/// <returns>The key</returns>
+	static uint64_t GetCacheKey(const std::string& source)
+	{
+		// Everything the program binary depends on. The strings are separated so that moving characters
+		// from one to the next changes the key
+		const uint8_t separator = 0xFF;
+		uint64_t hash = HashBytes(source.data(), source.size());
+		for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+		{
+			const char* string = (const char*)glGetString(name);
+			hash = HashBytes(&separator, sizeof(separator), hash);
+			if (string)
+				hash = HashBytes(string, strlen(string), hash);
+		}
+		return hash;
+	}
+
+	/// <summary>
+	/// Get the file name a program binary is cached with. The name holds a hash of the path of the
+	/// shader file, so shaders with the same file name in different folders do not overwrite each other
+	/// </summary>
+	/// <param name="filepath">The file path to the shader file</param>
+	/// <returns>The file name of the cached program binary</returns>
+	static std::string GetCacheName(const std::filesystem::path& filepath)
+	{
+		std::string path = filepath.lexically_normal().generic_string();
+		uint64_t hash = HashBytes(path.data(), path.size());
+
+		char name[32];
+		snprintf(name, sizeof(name), "-%016llx.pcshader", (unsigned long long)hash);
+		return filepath.stem().string() + name;
+	}
+
 	/// <summary>
 	/// Convert the shader type string read from the value of #type in the shader file to a
 	/// Glad shader type value
@@ -27,11 +119,25 @@ namespace Pinecone
 	}
 
 	Shader::Shader(const std::string& filepath)
+		: m_Name(filepath), m_CreateTime(std::chrono::steady_clock::now())
 	{
 		PC_PROFILE_FUNCTION();
 
 		// Read the shader code form the file
 		std::string source = ReadFile(filepath);
+
+		// Drivers that can not save program binaries have no formats to save them in
+		GLint binaryFormatCount = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormatCount);
+		if (binaryFormatCount > 0 && !source.empty())
+		{
+			m_CacheKey = GetCacheKey(source);
+			m_CachePath = s_ShaderCacheDirectory / GetCacheName(filepath);
+			// Use the cached program if there is one, nothing has to be compiled
+			if (LoadBinary(m_CachePath, m_CacheKey))
+				return;
+		}
+
 		// Then process the code into the shader types and their code
 		auto shaderSources = PreProcess(source);
 		// Compile the processed shaders
@@ -39,6 +145,7 @@ namespace Pinecone
 	}
 
 	Shader::Shader(const std::string& vertexSrc, const std::string& fragmentSrc)
+		: m_Name("Shader"), m_CreateTime(std::chrono::steady_clock::now())
 	{
 		PC_PROFILE_FUNCTION();
 
@@ -54,6 +161,10 @@ namespace Pinecone
 	{
 		PC_PROFILE_FUNCTION();
 
+		// Delete any shaders still waiting for the program to link
+		for (auto id : m_ShaderIDs)
+			glDeleteShader(id);
+
 		// Delete the shader
 		glDeleteProgram(m_RendererID);
 	}
@@ -124,10 +235,10 @@ namespace Pinecone
 	{
 		PC_PROFILE_FUNCTION();
 
+		EnableParallelCompile();
+
 		// Create a new program to attach our shaders to
 		GLuint program = glCreateProgram();
-		// Used to keep track of the created shader ID's
-		std::vector<GLenum> glShaderIDs;
 		for (auto& kv : shaderSources)
 		{
 			// Get the shader type and the source code
@@ -141,79 +252,247 @@ namespace Pinecone
 			const GLchar* sourceCStr = source.c_str();
 			glShaderSource(shader, 1, &sourceCStr, 0);
 
-			// Compile the shader code
+			// Compile the shader code. The compile status is not checked until the program has linked,
+			// asking for it here would wait for the compile to finish
 			glCompileShader(shader);
 
-			// Check to make sure the shader has been successfully compiled
-			GLint isCompiled = 0;
-			glGetShaderiv(shader, GL_COMPILE_STATUS, &isCompiled);
-			if (isCompiled == GL_FALSE)
-			{
-				// If it failed to compile, get the reason from the log message
-				GLint maxLength = 0;
-				glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &maxLength);
-
-				// The maxLength includes the NULL character
-				std::vector<GLchar> infoLog(maxLength);
-				glGetShaderInfoLog(shader, maxLength, &maxLength, &infoLog[0]);
-
-				// Delete the shader
-				glDeleteShader(shader);
-
-				// Print the error
-				PC_CORE_ERROR("{0}", infoLog.data());
-				PC_CORE_ASSERT(false, "Shader compilation failure!");
-				break;
-			}
-
-			// Attach the shader to our program if it compiled successfully
+			// Attach the shader to our program
 			glAttachShader(program, shader);
 			// Keep track of the shader ID we created
-			glShaderIDs.push_back(shader);
+			m_ShaderIDs.push_back(shader);
 		}
 
 		// Store the ID of the program to reference it later in our code
 		m_RendererID = program;
 
+		// Ask for the program to be saveable so it can be cached once it is linked
+		if (!m_CachePath.empty())
+			glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
 		// Link our program
 		glLinkProgram(program);
+		m_Linking = true;
+	}
+
+	void Shader::FinishLink() const
+	{
+		if (!m_Linking)
+			return;
 
-		// Check to make sure our program was successfully linked
+		PC_PROFILE_FUNCTION();
+
+		m_Linking = false;
+		GLuint program = m_RendererID;
+
+		// Check to make sure our program was successfully linked, this waits for the driver to finish
 		GLint isLinked = 0;
 		// Note the different functions here: glGetProgram* instead of glGetShader*.
 		glGetProgramiv(program, GL_LINK_STATUS, (int*)&isLinked);
 		if (isLinked == GL_FALSE)
 		{
+			// A shader that failed to compile also fails the link, its log says why
+			for (auto id : m_ShaderIDs)
+			{
+				GLint isCompiled = 0;
+				glGetShaderiv(id, GL_COMPILE_STATUS, &isCompiled);
+				if (isCompiled == GL_FALSE)
+				{
+					// If it failed to compile, get the reason from the log message
+					GLint maxLength = 0;
+					glGetShaderiv(id, GL_INFO_LOG_LENGTH, &maxLength);
+
+					// The maxLength includes the NULL character
+					std::vector<GLchar> infoLog(maxLength + 1);
+					glGetShaderInfoLog(id, maxLength, &maxLength, &infoLog[0]);
+
+					// Print the error
+					PC_CORE_ERROR("{0}: {1}", m_Name, infoLog.data());
+					PC_CORE_ASSERT(false, "Shader compilation failure!");
+				}
+			}
+
 			// If it failed to link, get the reason from the log message
 			GLint maxLength = 0;
 			glGetProgramiv(program, GL_INFO_LOG_LENGTH, &maxLength);
 
 			// The maxLength includes the NULL character
-			std::vector<GLchar> infoLog(maxLength);
+			std::vector<GLchar> infoLog(maxLength + 1);
 			glGetProgramInfoLog(program, maxLength, &maxLength, &infoLog[0]);
 
-			// We don't need the program anymore.
+			// We don't need the program anymore. Binding and uploading to program 0 does nothing
 			glDeleteProgram(program);
+			m_RendererID = 0;
 
 			// Delete the shaders as we also don't need them anymore
-			for (auto id : glShaderIDs)
+			for (auto id : m_ShaderIDs)
 				glDeleteShader(id);
+			m_ShaderIDs.clear();
 
 			// Print the error
-			PC_CORE_ERROR("{0}", infoLog.data());
+			PC_CORE_ERROR("{0}: {1}", m_Name, infoLog.data());
 			PC_CORE_ASSERT(false, "Shader link failure!");
 			return;
 		}
 
-		// Detach the shaders
-		for (auto id : glShaderIDs)
+		// Detach and delete the shaders, the program keeps what it needs
+		for (auto id : m_ShaderIDs)
+		{
 			glDetachShader(program, id);
+			glDeleteShader(id);
+		}
+		m_ShaderIDs.clear();
+
+		if (!m_CachePath.empty())
+			SaveBinary();
+		Reflect();
+
+		std::chrono::duration<float, std::milli> duration = std::chrono::steady_clock::now() - m_CreateTime;
+		PC_CORE_INFO("Shader {0} compiled in {1:.2f}ms", m_Name, duration.count());
+	}
+
+	bool Shader::LoadBinary(const std::filesystem::path& cachePath, uint64_t key)
+	{
+		PC_PROFILE_FUNCTION();
+
+		MappedFile file(cachePath);
+		if (!file.IsOpen() || file.GetSize() < sizeof(ShaderCacheHeader))
+			return false;
+
+		ShaderCacheHeader header;
+		memcpy(&header, file.GetData(), sizeof(ShaderCacheHeader));
+		if (header.Magic != ShaderCacheHeader::CurrentMagic || header.Version != ShaderCacheHeader::CurrentVersion || header.Key != key)
+		{
+			PC_CORE_INFO("Cached shader {0} is out of date", cachePath.string());
+			return false;
+		}
+		if (file.GetSize() != sizeof(ShaderCacheHeader) + header.BinarySize)
+		{
+			PC_CORE_WARN("Cached shader {0} is corrupt", cachePath.string());
+			return false;
+		}
+
+		GLuint program = glCreateProgram();
+		glProgramBinary(program, header.BinaryFormat, file.GetData() + sizeof(ShaderCacheHeader), header.BinarySize);
+
+		// The driver can still reject a binary, such as after an update that kept the version string
+		GLint isLinked = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &isLinked);
+		if (isLinked == GL_FALSE)
+		{
+			PC_CORE_INFO("Cached shader {0} was rejected by the driver", cachePath.string());
+			glDeleteProgram(program);
+			return false;
+		}
+
+		m_RendererID = program;
+		m_LoadedFromCache = true;
+		Reflect();
+
+		std::chrono::duration<float, std::milli> duration = std::chrono::steady_clock::now() - m_CreateTime;
+		PC_CORE_INFO("Shader {0} loaded from cache in {1:.2f}ms", m_Name, duration.count());
+		return true;
+	}
+
+	void Shader::SaveBinary() const
+	{
+		PC_PROFILE_FUNCTION();
+
+		GLint binarySize = 0;
+		glGetProgramiv(m_RendererID, GL_PROGRAM_BINARY_LENGTH, &binarySize);
+		if (binarySize <= 0)
+			return;
+
+		std::vector<uint8_t> binary(binarySize);
+		GLenum binaryFormat = 0;
+		glGetProgramBinary(m_RendererID, binarySize, &binarySize, &binaryFormat, binary.data());
+
+		ShaderCacheHeader header;
+		header.Magic = ShaderCacheHeader::CurrentMagic;
+		header.Version = ShaderCacheHeader::CurrentVersion;
+		header.Key = m_CacheKey;
+		header.BinaryFormat = binaryFormat;
+		header.BinarySize = (uint32_t)binarySize;
+
+		std::error_code error;
+		std::filesystem::create_directories(m_CachePath.parent_path(), error);
+
+		std::ofstream out(m_CachePath, std::ios::out | std::ios::binary);
+		if (!out)
+		{
+			PC_CORE_WARN("Could not write cached shader {0}", m_CachePath.string());
+			return;
+		}
+
+		out.write((const char*)&header, sizeof(ShaderCacheHeader));
+		out.write((const char*)binary.data(), header.BinarySize);
+	}
+
+	void Shader::Reflect() const
+	{
+		PC_PROFILE_FUNCTION();
+
+		m_Uniforms.clear();
+		m_UniformBlocks.clear();
+		m_UniformLocations.clear();
+
+		GLint uniformCount = 0, maxNameLength = 0;
+		glGetProgramInterfaceiv(m_RendererID, GL_UNIFORM, GL_ACTIVE_RESOURCES, &uniformCount);
+		glGetProgramInterfaceiv(m_RendererID, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxNameLength);
+		std::vector<GLchar> name(std::max(maxNameLength, 1));
+
+		for (GLint i = 0; i < uniformCount; i++)
+		{
+			const GLenum properties[] = { GL_BLOCK_INDEX, GL_LOCATION, GL_TYPE, GL_ARRAY_SIZE };
+			GLint values[4];
+			glGetProgramResourceiv(m_RendererID, GL_UNIFORM, i, 4, properties, 4, nullptr, values);
+
+			// Variables in uniform blocks are set through their uniform buffer, they have no location
+			if (values[0] != -1)
+				continue;
+
+			glGetProgramResourceName(m_RendererID, GL_UNIFORM, i, (GLsizei)name.size(), nullptr, name.data());
+
+			ShaderUniform& uniform = m_Uniforms.emplace_back();
+			uniform.Name = name.data();
+			uniform.Location = values[1];
+			uniform.Type = (GLenum)values[2];
+			uniform.Count = (uint32_t)values[3];
+
+			auto [it, inserted] = m_UniformLocations.try_emplace(UniformName::HashString(uniform.Name.c_str()), uniform.Location);
+			PC_CORE_ASSERT(inserted, "Two uniforms have the same name hash!");
+
+			// Arrays are reported as their first element, also let them be found without the [0]
+			size_t bracket = uniform.Name.find('[');
+			if (bracket != std::string::npos)
+				m_UniformLocations.try_emplace(UniformName::HashString(uniform.Name.substr(0, bracket).c_str()), uniform.Location);
+		}
+
+		GLint blockCount = 0;
+		glGetProgramInterfaceiv(m_RendererID, GL_UNIFORM_BLOCK, GL_ACTIVE_RESOURCES, &blockCount);
+		glGetProgramInterfaceiv(m_RendererID, GL_UNIFORM_BLOCK, GL_MAX_NAME_LENGTH, &maxNameLength);
+		name.resize(std::max(maxNameLength, 1));
+
+		for (GLint i = 0; i < blockCount; i++)
+		{
+			const GLenum properties[] = { GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE };
+			GLint values[2];
+			glGetProgramResourceiv(m_RendererID, GL_UNIFORM_BLOCK, i, 2, properties, 2, nullptr, values);
+			glGetProgramResourceName(m_RendererID, GL_UNIFORM_BLOCK, i, (GLsizei)name.size(), nullptr, name.data());
+
+			ShaderUniformBlock& block = m_UniformBlocks.emplace_back();
+			block.Name = name.data();
+			block.Binding = (uint32_t)values[0];
+			block.Size = (uint32_t)values[1];
+		}
 	}
 
 	void Shader::Bind() const
 	{
 		PC_PROFILE_FUNCTION();
 
+		// Make sure the program is done linking
+		FinishLink();
+
 		// Use our shader program
 		glUseProgram(m_RendererID);
 	}
@@ -226,76 +505,117 @@ namespace Pinecone
 		glUseProgram(0);
 	}
 
-	void Shader::UploadUniformInt(const std::string& name, int value)
+	int Shader::GetUniformLocation(UniformName name) const
+	{
+		// The locations are only known once the program is linked
+		FinishLink();
+
+		auto it = m_UniformLocations.find(name.Hash);
+		return it != m_UniformLocations.end() ? it->second : -1;
+	}
+
+	void Shader::UploadUniformInt(UniformName name, int value)
+	{
+		UploadUniformInt(GetUniformLocation(name), value);
+	}
+
+	void Shader::UploadUniformInt(int location, int value)
 	{
 		PC_PROFILE_FUNCTION();
 
-		// Get the location of the variable and set its value
-		GLint location = glGetUniformLocation(m_RendererID, name.c_str());
-		glUniform1i(location, value);
+		// Set the value straight on the program, it does not have to be bound
+		glProgramUniform1i(m_RendererID, location, value);
 	}
 
-	void Shader::UploadUniformIntArray(const std::string& name, int* values, uint32_t count)
+	void Shader::UploadUniformIntArray(UniformName name, int* values, uint32_t count)
+	{
+		UploadUniformIntArray(GetUniformLocation(name), values, count);
+	}
+
+	void Shader::UploadUniformIntArray(int location, int* values, uint32_t count)
 	{
 		PC_PROFILE_FUNCTION();
 
-		// Get the location of the variable and set its value
-		GLint location = glGetUniformLocation(m_RendererID, name.c_str());
-		glUniform1iv(location, count, values);
+		// Set the value straight on the program, it does not have to be bound
+		glProgramUniform1iv(m_RendererID, location, count, values);
 	}
 
-	void Shader::UploadUniformFloat(const std::string& name, float value)
+	void Shader::UploadUniformFloat(UniformName name, float value)
+	{
+		UploadUniformFloat(GetUniformLocation(name), value);
+	}
+
+	void Shader::UploadUniformFloat(int location, float value)
 	{
 		PC_PROFILE_FUNCTION();
 
-		// Get the location of the variable and set its value
-		GLint location = glGetUniformLocation(m_RendererID, name.c_str());
-		glUniform1f(location, value);
+		// Set the value straight on the program, it does not have to be bound
+		glProgramUniform1f(m_RendererID, location, value);
+	}
+
+	void Shader::UploadUniformFloat2(UniformName name, const glm::vec2& value)
+	{
+		UploadUniformFloat2(GetUniformLocation(name), value);
 	}
 
-	void Shader::UploadUniformFloat2(const std::string& name, const glm::vec2& value)
+	void Shader::UploadUniformFloat2(int location, const glm::vec2& value)
 	{
 		PC_PROFILE_FUNCTION();
 
-		// Get the location of the variable and set its value
-		GLint location = glGetUniformLocation(m_RendererID, name.c_str());
-		glUniform2f(location, value.x, value.y);
+		// Set the value straight on the program, it does not have to be bound
+		glProgramUniform2f(m_RendererID, location, value.x, value.y);
 	}
 
-	void Shader::UploadUniformFloat3(const std::string& name, const glm::vec3& value)
+	void Shader::UploadUniformFloat3(UniformName name, const glm::vec3& value)
+	{
+		UploadUniformFloat3(GetUniformLocation(name), value);
+	}
+
+	void Shader::UploadUniformFloat3(int location, const glm::vec3& value)
 	{
 		PC_PROFILE_FUNCTION();
 
-		// Get the location of the variable and set its value
-		GLint location = glGetUniformLocation(m_RendererID, name.c_str());
-		glUniform3f(location, value.x, value.y, value.z);
+		// Set the value straight on the program, it does not have to be bound
+		glProgramUniform3f(m_RendererID, location, value.x, value.y, value.z);
 	}
 
-	void Shader::UploadUniformFloat4(const std::string& name, const glm::vec4& value)
+	void Shader::UploadUniformFloat4(UniformName name, const glm::vec4& value)
+	{
+		UploadUniformFloat4(GetUniformLocation(name), value);
+	}
+
+	void Shader::UploadUniformFloat4(int location, const glm::vec4& value)
 	{
 		PC_PROFILE_FUNCTION();
 
-		// Get the location of the variable and set its value
-		GLint location = glGetUniformLocation(m_RendererID, name.c_str());
-		glUniform4f(location, value.x, value.y, value.z, value.w);
+		// Set the value straight on the program, it does not have to be bound
+		glProgramUniform4f(m_RendererID, location, value.x, value.y, value.z, value.w);
+	}
+
+	void Shader::UploadUniformMat3(UniformName name, const glm::mat3& matrix)
+	{
+		UploadUniformMat3(GetUniformLocation(name), matrix);
 	}
 
-	void Shader::UploadUniformMat3(const std::string& name, const glm::mat3& matrix)
+	void Shader::UploadUniformMat3(int location, const glm::mat3& matrix)
 	{
 		PC_PROFILE_FUNCTION();
 
-		// Get the location of the variable and set its value
-		GLint location = glGetUniformLocation(m_RendererID, name.c_str());
-		glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(matrix));
+		// Set the value straight on the program, it does not have to be bound
+		glProgramUniformMatrix3fv(m_RendererID, location, 1, GL_FALSE, glm::value_ptr(matrix));
+	}
+
+	void Shader::UploadUniformMat4(UniformName name, const glm::mat4& matrix)
+	{
+		UploadUniformMat4(GetUniformLocation(name), matrix);
 	}
 
-	void Shader::UploadUniformMat4(const std::string& name, const glm::mat4& matrix)
+	void Shader::UploadUniformMat4(int location, const glm::mat4& matrix)
 	{
 		PC_PROFILE_FUNCTION();
 
-		// Get the location of the variable and set its value
-		GLint location = glGetUniformLocation(m_RendererID, name.c_str());
-		glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(matrix));
+		// Set the value straight on the program, it does not have to be bound
+		glProgramUniformMatrix4fv(m_RendererID, location, 1, GL_FALSE, glm::value_ptr(matrix));
 	}
 
 	Ref<Shader> Shader::Create(const std::string& filepath)
@@ -2,15 +2,68 @@
 
 #include <glm/glm.hpp>
 
+#include <filesystem>
+
 typedef uint32_t GLenum;
 
 namespace Pinecone
 {
+	/// <summary>
+	/// The name of a variable in a shader, hashed so the variable can be found without asking the
+	/// driver. Names that are uploaded every frame can be hashed once by declaring them static constexpr
+	/// </summary>
+	struct UniformName
+	{
+		uint32_t Hash;
+
+		constexpr UniformName(const char* name) : Hash(HashString(name)) {}
+		UniformName(const std::string& name) : Hash(HashString(name.c_str())) {}
+
+		/// <summary>
+		/// Hash a variable name with 32 bit FNV-1a
+		/// </summary>
+		/// <param name="name">The variable name</param>
+		/// <returns>The hash of the name</returns>
+		static constexpr uint32_t HashString(const char* name)
+		{
+			uint32_t hash = 2166136261u;
+			for (; *name; name++)
+			{
+				hash ^= (uint8_t)*name;
+				hash *= 16777619u;
+			}
+			return hash;
+		}
+	};
+
+	/// <summary>
+	/// An active variable in a shader that is not in a uniform block
+	/// </summary>
+	struct ShaderUniform
+	{
+		std::string Name; // Arrays are named after their first element, such as u_Textures[0]
+		int Location;
+		GLenum Type;
+		uint32_t Count; // The number of elements, 1 if the variable is not an array
+	};
+
+	/// <summary>
+	/// An active uniform block in a shader
+	/// </summary>
+	struct ShaderUniformBlock
+	{
+		std::string Name;
+		uint32_t Binding;
+		uint32_t Size; // The size of the block in bytes
+	};
+
 	class Shader
 	{
 	public:
 		/// <summary>
-		/// The Shader constructor to load a shader from a file.
+		/// The Shader constructor to load a shader from a file. The linked program is cached in
+		/// assets/cache/shaders, later runs load it from there instead of compiling the source
+		/// again for as long as the source and the graphics driver stay the same
 		/// </summary>
 		/// <param name="filepath">The filepath to the shader file</param>
 		Shader(const std::string& filepath);
@@ -26,65 +79,143 @@ namespace Pinecone
 		~Shader();
 
 		/// <summary>
-		/// Bind the shader to be used
+		/// Bind the shader to be used. The shader is compiled in the background when the driver
+		/// supports it, the first bind waits for it to finish
 		/// </summary>
 		void Bind() const;
 		/// <summary>
 		/// Unbind the shader
 		/// </summary>
 		void Unbind() const;
+		/// <summary>
+		/// Wait for the shader to finish compiling and linking. Binding the shader waits on its own,
+		/// this is for waiting at a known time instead, such as while loading
+		/// </summary>
+		void WaitUntilLinked() const { FinishLink(); }
+		/// <summary>
+		/// Check if the linked program was loaded from the shader cache instead of being compiled
+		/// </summary>
+		/// <returns>True if the program was loaded from the cache</returns>
+		bool IsLoadedFromCache() const { return m_LoadedFromCache; }
+
+		/// <summary>
+		/// Get the location of a variable in the shader. Looking the location up once and uploading
+		/// to it directly skips hashing the name on every upload
+		/// </summary>
+		/// <param name="name">The name of the variable in the shader, or its precomputed hash</param>
+		/// <returns>The location of the variable, -1 if the shader has no active variable with that name</returns>
+		int GetUniformLocation(UniformName name) const;
+		/// <summary>
+		/// Get every active variable in the shader that is not in a uniform block
+		/// </summary>
+		/// <returns>The variables</returns>
+		const std::vector<ShaderUniform>& GetUniforms() const { FinishLink(); return m_Uniforms; }
+		/// <summary>
+		/// Get every active uniform block in the shader
+		/// </summary>
+		/// <returns>The uniform blocks</returns>
+		const std::vector<ShaderUniformBlock>& GetUniformBlocks() const { FinishLink(); return m_UniformBlocks; }
 
 		/// <summary>
 		/// Upload an int value to a variable in the shader
 		/// </summary>
-		/// <param name="name">The name of the variable in the shader</param>
+		/// <param name="name">The name of the variable in the shader, or its precomputed hash</param>
+		/// <param name="value">The int value to set the variable to</param>
+		void UploadUniformInt(UniformName name, int value);
+		/// <summary>
+		/// Upload an int value to a variable in the shader at a location from GetUniformLocation
+		/// </summary>
+		/// <param name="location">The location of the variable in the shader</param>
 		/// <param name="value">The int value to set the variable to</param>
-		void UploadUniformInt(const std::string& name, int value);
+		void UploadUniformInt(int location, int value);
 		/// <summary>
 		/// Upload an int array to a variable in the shader
 		/// </summary>
-		/// <param name="name">The name of the variable in the shader</param>
+		/// <param name="name">The name of the variable in the shader, or its precomputed hash</param>
 		/// <param name="value">The int array value to set the variable to</param>
 		/// <param name="count">The size of the int array</param>
-		void UploadUniformIntArray(const std::string& name, int* values, uint32_t count);
+		void UploadUniformIntArray(UniformName name, int* values, uint32_t count);
+		/// <summary>
+		/// Upload an int array to a variable in the shader at a location from GetUniformLocation
+		/// </summary>
+		/// <param name="location">The location of the variable in the shader</param>
+		/// <param name="value">The int array value to set the variable to</param>
+		/// <param name="count">The size of the int array</param>
+		void UploadUniformIntArray(int location, int* values, uint32_t count);
 
 		/// <summary>
 		/// Upload a float value to a variable in the shader
 		/// </summary>
-		/// <param name="name">The name of the variable in the shader</param>
+		/// <param name="name">The name of the variable in the shader, or its precomputed hash</param>
+		/// <param name="value">The float value to set the variable to</param>
+		void UploadUniformFloat(UniformName name, float value);
+		/// <summary>
+		/// Upload a float value to a variable in the shader at a location from GetUniformLocation
+		/// </summary>
+		/// <param name="location">The location of the variable in the shader</param>
 		/// <param name="value">The float value to set the variable to</param>
-		void UploadUniformFloat(const std::string& name, float value);
+		void UploadUniformFloat(int location, float value);
 		/// <summary>
 		/// Upload a 2D vector value to a variable in the shader
 		/// </summary>
-		/// <param name="name">The name of the variable in the shader</param>
+		/// <param name="name">The name of the variable in the shader, or its precomputed hash</param>
 		/// <param name="value">The 2D vector value to set the variable to</param>
-		void UploadUniformFloat2(const std::string& name, const glm::vec2& value);
+		void UploadUniformFloat2(UniformName name, const glm::vec2& value);
+		/// <summary>
+		/// Upload a 2D vector value to a variable in the shader at a location from GetUniformLocation
+		/// </summary>
+		/// <param name="location">The location of the variable in the shader</param>
+		/// <param name="value">The 2D vector value to set the variable to</param>
+		void UploadUniformFloat2(int location, const glm::vec2& value);
 		/// <summary>
 		/// Upload a 3D vector value to a variable in the shader
 		/// </summary>
-		/// <param name="name">The name of the variable in the shader</param>
+		/// <param name="name">The name of the variable in the shader, or its precomputed hash</param>
 		/// <param name="value">The 3D vector value to set the variable to</param>
-		void UploadUniformFloat3(const std::string& name, const glm::vec3& value);
+		void UploadUniformFloat3(UniformName name, const glm::vec3& value);
+		/// <summary>
+		/// Upload a 3D vector value to a variable in the shader at a location from GetUniformLocation
+		/// </summary>
+		/// <param name="location">The location of the variable in the shader</param>
+		/// <param name="value">The 3D vector value to set the variable to</param>
+		void UploadUniformFloat3(int location, const glm::vec3& value);
 		/// <summary>
 		/// Upload a 4D vector value to a variable in the shader
 		/// </summary>
-		/// <param name="name">The name of the variable in the shader</param>
+		/// <param name="name">The name of the variable in the shader, or its precomputed hash</param>
 		/// <param name="value">The 4D vector value to set the variable to</param>
-		void UploadUniformFloat4(const std::string& name, const glm::vec4& value);
+		void UploadUniformFloat4(UniformName name, const glm::vec4& value);
+		/// <summary>
+		/// Upload a 4D vector value to a variable in the shader at a location from GetUniformLocation
+		/// </summary>
+		/// <param name="location">The location of the variable in the shader</param>
+		/// <param name="value">The 4D vector value to set the variable to</param>
+		void UploadUniformFloat4(int location, const glm::vec4& value);
 
 		/// <summary>
 		/// Upload a 3x3 matrix to a variable in the shader
 		/// </summary>
-		/// <param name="name">The name of the variable in the shader</param>
+		/// <param name="name">The name of the variable in the shader, or its precomputed hash</param>
+		/// <param name="matrix">The 3x3 matri value to set the variable to</param>
+		void UploadUniformMat3(UniformName name, const glm::mat3& matrix);
+		/// <summary>
+		/// Upload a 3x3 matrix to a variable in the shader at a location from GetUniformLocation
+		/// </summary>
+		/// <param name="location">The location of the variable in the shader</param>
 		/// <param name="matrix">The 3x3 matri value to set the variable to</param>
-		void UploadUniformMat3(const std::string& name, const glm::mat3& matrix);
+		void UploadUniformMat3(int location, const glm::mat3& matrix);
 		/// <summary>
 		/// Upload a 4x4 matrix to a variable in the shader
 		/// </summary>
-		/// <param name="name">The name of the variable in the shader</param>
+		/// <param name="name">The name of the variable in the shader, or its precomputed hash</param>
+		/// <param name="matrix">The 4x4 matri value to set the variable to</param>
+		void UploadUniformMat4(UniformName name, const glm::mat4& matrix);
+		/// <summary>
+		/// Upload a 4x4 matrix to a variable in the shader at a location from GetUniformLocation
+		/// </summary>
+		/// <param name="location">The location of the variable in the shader</param>
 		/// <param name="matrix">The 4x4 matri value to set the variable to</param>
-		void UploadUniformMat4(const std::string& name, const glm::mat4& matrix);
+		void UploadUniformMat4(int location, const glm::mat4& matrix);
 
 		/// <summary>
 		/// Create a smart shared pointer to a new Shader
@@ -107,11 +238,50 @@ namespace Pinecone
 		/// <returns>The Glad shader type and its respective code</returns>
 		std::unordered_map<GLenum, std::string> PreProcess(const std::string& source);
 		/// <summary>
-		/// Compile the shaders to be used with OpenGL
+		/// Start compiling and linking the shaders to be used with OpenGL. Nothing waits for the
+		/// driver here, so several shaders can compile at the same time. The result is checked
+		/// by FinishLink
 		/// </summary>
 		/// <param name="shaderSources">The shader types and code</param>
 		void Compile(const std::unordered_map<GLenum, std::string>& shaderSources);
+		/// <summary>
+		/// Wait for the program to finish linking, report any errors and write the program
+		/// to the cache. Does nothing once the program is linked
+		/// </summary>
+		void FinishLink() const;
+		/// <summary>
+		/// Create the program from a cached program binary
+		/// </summary>
+		/// <param name="cachePath">The file path to the cached program binary</param>
+		/// <param name="key">The key the program binary must have been cached with</param>
+		/// <returns>True if the program was created, false if the cache is missing, out of date or rejected by the driver</returns>
+		bool LoadBinary(const std::filesystem::path& cachePath, uint64_t key);
+		/// <summary>
+		/// Write the linked program to the cache
+		/// </summary>
+		void SaveBinary() const;
+		/// <summary>
+		/// Find every active variable and uniform block in the linked program
+		/// </summary>
+		void Reflect() const;
 	private:
-		uint32_t m_RendererID;
+		// Set to 0 by FinishLink if the program fails to link
+		mutable uint32_t m_RendererID = 0;
+		std::string m_Name;
+
+		// Where the linked program is cached, empty if it is not
+		std::filesystem::path m_CachePath;
+		uint64_t m_CacheKey = 0;
+		bool m_LoadedFromCache = false;
+
+		// The program is still compiling and linking, the shaders are deleted once it is done
+		mutable bool m_Linking = false;
+		mutable std::vector<uint32_t> m_ShaderIDs;
+		std::chrono::steady_clock::time_point m_CreateTime;
+
+		// Filled in by Reflect once the program is linked
+		mutable std::vector<ShaderUniform> m_Uniforms;
+		mutable std::vector<ShaderUniformBlock> m_UniformBlocks;
+		mutable std::unordered_map<uint32_t, int> m_UniformLocations; // Name hash to location
 	};
 }
\ No newline at end of file
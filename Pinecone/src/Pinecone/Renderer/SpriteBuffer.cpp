@@ -0,0 +1,220 @@
+#include "pcpch.h"
+#include "SpriteBuffer.h"
+
+#include "Pinecone/Asset/AssetManager.h"
+
+#include <glm/gtc/packing.hpp>
+
+namespace Pinecone
+{
+	// Dirty slots closer together than this are uploaded as one range, re-uploading a few clean slots
+	// is cheaper than another call into the driver
+	static const uint32_t s_MaxRangeGap = 16;
+
+	SpriteBuffer::SpriteBuffer(uint32_t capacity)
+		: m_Capacity(std::max(capacity, 1u))
+	{
+		PC_PROFILE_FUNCTION();
+
+		CreateBuffers();
+	}
+
+	void SpriteBuffer::CreateBuffers()
+	{
+		m_VertexArray = VertexArray::Create();
+
+		m_VertexBuffer = VertexBuffer::Create(m_Capacity * sizeof(SpriteInstance));
+		m_VertexBuffer->SetLayout({
+			{ ShaderDataType::Float4, "a_TransformRow0" },
+			{ ShaderDataType::Float3, "a_TransformRow1" },
+			{ ShaderDataType::Int,    "a_Color"         },
+			{ ShaderDataType::Float4, "a_TexRect"       },
+			{ ShaderDataType::Int,    "a_TexIndex"      },
+			{ ShaderDataType::Float,  "a_TilingFactor"  },
+			{ ShaderDataType::Int,    "a_Shape"         }
+		});
+		m_VertexArray->AddVertexBuffer(m_VertexBuffer, true);
+	}
+
+	uint32_t SpriteBuffer::Allocate()
+	{
+		if (!m_FreeSlots.empty())
+		{
+			uint32_t slot = m_FreeSlots.back();
+			m_FreeSlots.pop_back();
+			return slot;
+		}
+
+		uint32_t slot = (uint32_t)m_Instances.size();
+		m_Instances.push_back({});
+		m_SlotTextures.push_back(-1);
+		m_SlotDirty.push_back(false);
+		MarkDirty(slot);
+
+		// Grow the GPU buffer, everything has to be uploaded again to the new buffer
+		if (m_Instances.size() > m_Capacity)
+		{
+			m_Capacity *= 2;
+			CreateBuffers();
+			for (uint32_t i = 0; i < (uint32_t)m_Instances.size(); i++)
+				MarkDirty(i);
+		}
+		return slot;
+	}
+
+	void SpriteBuffer::Free(uint32_t slot)
+	{
+		PC_CORE_ASSERT(slot < m_Instances.size(), "Sprite slot out of range!");
+
+		ClearSlot(slot);
+		m_FreeSlots.push_back(slot);
+	}
+
+	void SpriteBuffer::ClearSlot(uint32_t slot)
+	{
+		ReleaseTexture(m_SlotTextures[slot]);
+		m_SlotTextures[slot] = -1;
+
+		// A zero sized quad covers no pixels, so the empty slot costs nothing but its vertex shader
+		m_Instances[slot] = {};
+		MarkDirty(slot);
+	}
+
+	bool SpriteBuffer::SetSprite(uint32_t slot, const glm::mat4& transform, const SpriteComponent& sprite)
+	{
+		PC_CORE_ASSERT(slot < m_Instances.size(), "Sprite slot out of range!");
+
+		// Work out the texture and region of it to draw, the same way Renderer2D::DrawSprite does
+		Ref<Texture2D> texture;
+		glm::vec4 texRect = { 0.0f, 0.0f, 1.0f, 1.0f };
+		float tilingFactor = 1.0f;
+		if (sprite.SubTexture)
+		{
+			texture = sprite.SubTexture->GetTexture();
+			glm::vec2 min = sprite.SubTexture->GetMin();
+			glm::vec2 max = sprite.SubTexture->GetMax();
+			if (sprite.FlipAxies.x)
+				std::swap(min.x, max.x);
+			if (sprite.FlipAxies.y)
+				std::swap(min.y, max.y);
+			texRect = { min.x, min.y, max.x, max.y };
+		}
+		else if (sprite.Texture)
+		{
+			texture = AssetManager::GetTexture(sprite.Texture);
+			texRect = { 0.0f, 0.0f, sprite.FlipAxies.x ? -1.0f : 1.0f, sprite.FlipAxies.y ? -1.0f : 1.0f };
+			tilingFactor = sprite.TilingFactor;
+		}
+
+		// Add the new texture before releasing the old one, so a sprite keeping its texture never
+		// drops it from the table
+		int32_t textureIndex = texture ? AddTexture(texture) : -1;
+		if (texture && textureIndex < 0)
+		{
+			ClearSlot(slot);
+			return false;
+		}
+		ReleaseTexture(m_SlotTextures[slot]);
+		m_SlotTextures[slot] = textureIndex;
+
+		SpriteInstance& instance = m_Instances[slot];
+		instance.TransformRow0 = { transform[0][0], transform[1][0], transform[3][0], transform[3][2] };
+		instance.TransformRow1 = { transform[0][1], transform[1][1], transform[3][1] };
+		instance.Color = glm::packUnorm4x8(sprite.Color);
+		instance.TexRect = texRect;
+		instance.TexIndex = textureIndex + 1;
+		instance.TilingFactor = tilingFactor;
+
+		MarkDirty(slot);
+		return true;
+	}
+
+	void SpriteBuffer::Upload()
+	{
+		m_UploadedBytes = 0;
+		if (m_DirtySlots.empty())
+			return;
+
+		PC_PROFILE_FUNCTION();
+
+		std::sort(m_DirtySlots.begin(), m_DirtySlots.end());
+
+		// Upload runs of dirty slots, joining runs that are only a few clean slots apart
+		size_t i = 0;
+		while (i < m_DirtySlots.size())
+		{
+			uint32_t first = m_DirtySlots[i];
+			uint32_t last = first;
+			while (++i < m_DirtySlots.size() && m_DirtySlots[i] - last <= s_MaxRangeGap)
+				last = m_DirtySlots[i];
+
+			uint32_t size = (last - first + 1) * sizeof(SpriteInstance);
+			m_VertexBuffer->SetData(&m_Instances[first], size, first * sizeof(SpriteInstance));
+			m_UploadedBytes += size;
+		}
+
+		for (uint32_t slot : m_DirtySlots)
+			m_SlotDirty[slot] = false;
+		m_DirtySlots.clear();
+	}
+
+	int32_t SpriteBuffer::AddTexture(const Ref<Texture2D>& texture)
+	{
+		auto it = m_TextureLookup.find(texture->GetRendererID());
+		if (it != m_TextureLookup.end())
+		{
+			m_TextureUseCounts[it->second]++;
+			return it->second;
+		}
+
+		// Reuse a texture slot nothing uses anymore before adding a new one
+		int32_t index = -1;
+		for (int32_t i = 0; i < (int32_t)m_Textures.size(); i++)
+		{
+			if (!m_Textures[i])
+			{
+				index = i;
+				break;
+			}
+		}
+		if (index < 0)
+		{
+			if (m_Textures.size() >= MaxTextures)
+				return -1;
+			index = (int32_t)m_Textures.size();
+			m_Textures.emplace_back();
+			m_TextureUseCounts.push_back(0);
+		}
+
+		m_Textures[index] = texture;
+		m_TextureUseCounts[index] = 1;
+		m_TextureLookup[texture->GetRendererID()] = index;
+		return index;
+	}
+
+	void SpriteBuffer::ReleaseTexture(int32_t textureIndex)
+	{
+		// Colored sprites use the white texture, which is not in the table
+		if (textureIndex < 0)
+			return;
+
+		if (--m_TextureUseCounts[textureIndex] == 0)
+		{
+			m_TextureLookup.erase(m_Textures[textureIndex]->GetRendererID());
+			m_Textures[textureIndex] = nullptr;
+		}
+	}
+
+	void SpriteBuffer::MarkDirty(uint32_t slot)
+	{
+		if (m_SlotDirty[slot])
+			return;
+		m_SlotDirty[slot] = true;
+		m_DirtySlots.push_back(slot);
+	}
+
+	Ref<SpriteBuffer> SpriteBuffer::Create(uint32_t capacity)
+	{
+		return CreateRef<SpriteBuffer>(capacity);
+	}
+}
\ No newline at end of file
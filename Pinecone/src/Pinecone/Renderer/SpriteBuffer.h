@@ -0,0 +1,125 @@
+#pragma once
+
+#include "Pinecone/Renderer/VertexArray.h"
+#include "Pinecone/Renderer/Texture2D.h"
+
+#include "Pinecone/Scene/Components.h"
+
+#include <glm/glm.hpp>
+
+namespace Pinecone
+{
+	/// <summary>
+	/// A buffer of sprites that stays on the GPU between frames. Every sprite owns a slot in the buffer
+	/// and only the slots that were changed since the last upload are written, as a few coalesced
+	/// ranges. Draw it with Renderer2D::DrawSpriteBuffer, which draws every sprite in one call using
+	/// the instanced quad pipeline. A buffer can use up to 31 different textures
+	/// </summary>
+	class SpriteBuffer
+	{
+	public:
+		static const uint32_t MaxTextures = 31; // Texture slot 0 is the white texture
+
+		/// <summary>
+		/// The SpriteBuffer constructor
+		/// </summary>
+		/// <param name="capacity">The number of sprites to make room for, the buffer grows when it is full</param>
+		SpriteBuffer(uint32_t capacity);
+
+		/// <summary>
+		/// Get a free slot for a sprite. The slot draws nothing until a sprite is set in it
+		/// </summary>
+		/// <returns>The slot</returns>
+		uint32_t Allocate();
+		/// <summary>
+		/// Stop drawing the sprite in a slot and let the slot be used again
+		/// </summary>
+		/// <param name="slot">The slot</param>
+		void Free(uint32_t slot);
+		/// <summary>
+		/// Set the sprite drawn in a slot
+		/// </summary>
+		/// <param name="slot">The slot</param>
+		/// <param name="transform">The transform of the sprite</param>
+		/// <param name="sprite">The sprite</param>
+		/// <returns>False if the sprites texture could not be added because every texture slot is in use,
+		/// the slot is left empty in that case</returns>
+		bool SetSprite(uint32_t slot, const glm::mat4& transform, const SpriteComponent& sprite);
+
+		/// <summary>
+		/// Upload the slots that changed since the last upload
+		/// </summary>
+		void Upload();
+
+		/// <summary>
+		/// Get the number of slots that have to be drawn, the highest slot in use plus one
+		/// </summary>
+		/// <returns>The number of slots</returns>
+		uint32_t GetSlotCount() const { return (uint32_t)m_Instances.size(); }
+		/// <summary>
+		/// Get the number of slots with a sprite in them
+		/// </summary>
+		/// <returns>The number of sprites</returns>
+		uint32_t GetSpriteCount() const { return (uint32_t)(m_Instances.size() - m_FreeSlots.size()); }
+		/// <summary>
+		/// Get the number of bytes written by the last upload
+		/// </summary>
+		/// <returns>The number of bytes uploaded</returns>
+		uint32_t GetUploadedBytes() const { return m_UploadedBytes; }
+
+		/// <summary>
+		/// Get the vertex array holding the sprite instances
+		/// </summary>
+		/// <returns>The vertex array</returns>
+		const Ref<VertexArray>& GetVertexArray() const { return m_VertexArray; }
+		/// <summary>
+		/// Get the textures used by the sprites. Texture i is bound to texture slot i + 1, empty textures
+		/// are unused slots
+		/// </summary>
+		/// <returns>The textures</returns>
+		const std::vector<Ref<Texture2D>>& GetTextures() const { return m_Textures; }
+
+		/// <summary>
+		/// Create a smart shared pointer to a new SpriteBuffer
+		/// </summary>
+		/// <param name="capacity">The number of sprites to make room for</param>
+		/// <returns>A shared pointer to a new SpriteBuffer</returns>
+		static Ref<SpriteBuffer> Create(uint32_t capacity = 1024);
+	private:
+		// The same layout as the instanced quads of the Renderer2D_QuadInstanced shader
+		struct SpriteInstance
+		{
+			glm::vec4 TransformRow0; // The first row of the 2D affine transform, w is the depth
+			glm::vec3 TransformRow1; // The second row of the 2D affine transform
+			uint32_t Color;          // RGBA8 packed color
+			glm::vec4 TexRect;       // Texture coordinates of the bottom left (xy) and top right (zw) corners
+			int TexIndex;
+			float TilingFactor;
+			int Shape;               // Always 0, sprites are plain quads
+		};
+
+		void CreateBuffers();
+		void ClearSlot(uint32_t slot);
+		int32_t AddTexture(const Ref<Texture2D>& texture);
+		void ReleaseTexture(int32_t textureIndex);
+		void MarkDirty(uint32_t slot);
+	private:
+		uint32_t m_Capacity;
+		Ref<VertexArray> m_VertexArray;
+		Ref<VertexBuffer> m_VertexBuffer;
+
+		// A copy of the GPU data, the dirty ranges are uploaded from here
+		std::vector<SpriteInstance> m_Instances;
+		// The index of the texture each slot uses, -1 for the white texture or an empty slot
+		std::vector<int32_t> m_SlotTextures;
+		std::vector<uint32_t> m_FreeSlots;
+		std::vector<uint32_t> m_DirtySlots;
+		std::vector<bool> m_SlotDirty;
+		uint32_t m_UploadedBytes = 0;
+
+		std::vector<Ref<Texture2D>> m_Textures;
+		// How many slots use each texture, a texture is dropped when nothing uses it
+		std::vector<uint32_t> m_TextureUseCounts;
+		std::unordered_map<uint32_t, int32_t> m_TextureLookup;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+#include "pcpch.h"
+#include "SubTexture2D.h"
+
+namespace Pinecone
+{
+	SubTexture2D::SubTexture2D(const Ref<Texture2D>& texture, const glm::vec2& min, const glm::vec2& max)
+		: m_Texture(texture), m_Min(min), m_Max(max)
+	{
+	}
+
+	Ref<SubTexture2D> SubTexture2D::Create(const Ref<Texture2D>& texture, const glm::vec2& min, const glm::vec2& max)
+	{
+		return CreateRef<SubTexture2D>(texture, min, max);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Pinecone/Renderer/Texture2D.h"
+
+#include <glm/glm.hpp>
+
+namespace Pinecone
+{
+	/// <summary>
+	/// A rectangular region of a Texture2D, such as a single image packed into a TextureAtlas page.
+	/// Drawing a sub texture only uses the texture slot of the texture it is a part of, so many sub
+	/// textures of the same texture can be drawn in a single batch.
+	/// </summary>
+	class SubTexture2D
+	{
+	public:
+		/// <summary>
+		/// The SubTexture2D constructor that takes in the texture and the texture coordinates of the region
+		/// </summary>
+		/// <param name="texture">The texture the region is a part of</param>
+		/// <param name="min">The bottom left texture coordinate of the region</param>
+		/// <param name="max">The top right texture coordinate of the region</param>
+		SubTexture2D(const Ref<Texture2D>& texture, const glm::vec2& min, const glm::vec2& max);
+
+		/// <summary>
+		/// Get the texture the region is a part of
+		/// </summary>
+		/// <returns>The texture</returns>
+		const Ref<Texture2D>& GetTexture() const { return m_Texture; }
+		/// <summary>
+		/// Get the bottom left texture coordinate of the region
+		/// </summary>
+		/// <returns>The bottom left texture coordinate</returns>
+		const glm::vec2& GetMin() const { return m_Min; }
+		/// <summary>
+		/// Get the top right texture coordinate of the region
+		/// </summary>
+		/// <returns>The top right texture coordinate</returns>
+		const glm::vec2& GetMax() const { return m_Max; }
+
+		/// <summary>
+		/// Get the width of the region (in pixels)
+		/// </summary>
+		/// <returns>The region width</returns>
+		uint32_t GetWidth() const { return (uint32_t)((m_Max.x - m_Min.x) * m_Texture->GetWidth() + 0.5f); }
+		/// <summary>
+		/// Get the height of the region (in pixels)
+		/// </summary>
+		/// <returns>The region height</returns>
+		uint32_t GetHeight() const { return (uint32_t)((m_Max.y - m_Min.y) * m_Texture->GetHeight() + 0.5f); }
+
+		/// <summary>
+		/// Create a smart shared pointer to a new SubTexture2D
+		/// </summary>
+		/// <param name="texture">The texture the region is a part of</param>
+		/// <param name="min">The bottom left texture coordinate of the region</param>
+		/// <param name="max">The top right texture coordinate of the region</param>
+		/// <returns>A shared pointer to a new SubTexture2D</returns>
+		static Ref<SubTexture2D> Create(const Ref<Texture2D>& texture, const glm::vec2& min, const glm::vec2& max);
+	private:
+		Ref<Texture2D> m_Texture;
+		glm::vec2 m_Min, m_Max;
+	};
+}
\ No newline at end of file
@@ -14,7 +14,12 @@ namespace Pinecone
 	enum class TextureFilter
 	{
 		NEAREST,
-		LINEAR
+		// Blends the four closest pixels of the closest mip level
+		LINEAR,
+		// Blends between the two closest mip levels as well, so there is no visible seam where the level changes
+		TRILINEAR,
+		// Trilinear, and takes extra samples along the direction the texture is stretched in when it is seen at an angle
+		ANISOTROPIC
 	};
 
 	struct TextureSpecification
@@ -22,8 +27,14 @@ namespace Pinecone
 		uint32_t Width = 1;
 		uint32_t Height = 1;
 		ImageFormat Format = ImageFormat::RGBA8;
+		// Allocate every mip level down to 1x1. Textures loaded from image files have their mips made when
+		// they are cooked, the mips of other textures are made on the GPU whenever their pixels are set
 		bool GenerateMips = true;
+		// Block compress textures loaded from image files when they are cooked
+		bool Compress = false;
 		TextureFilter Filter = TextureFilter::LINEAR;
+		// The most samples TextureFilter::ANISOTROPIC takes, limited to what the driver supports
+		float MaxAnisotropy = 16.0f;
 
 		TextureSpecification() = default;
 		TextureSpecification(TextureFilter filter) : Filter(filter) {}
@@ -1,11 +1,25 @@
 #include "pcpch.h"
 #include "Texture2D.h"
 
+#include "Pinecone/Renderer/TextureStreamer.h"
+#include "Pinecone/Renderer/TextureCooker.h"
+#include "Pinecone/Core/MappedFile.h"
+
 #include <glad/glad.h>
 #include <stb_image.h>
 
 namespace Pinecone
 {
+	// The color of textures that are still being loaded in the background
+	static const uint8_t s_PlaceholderColor[4] = { 128, 128, 128, 255 };
+
+	// Image files are cooked here the first time they are loaded, so they never have to be decoded again
+	static const std::filesystem::path s_TextureCacheDirectory = "assets/cache/textures";
+
+	// From EXT_texture_compression_s3tc, which every desktop driver supports but is not part of the core profile
+	#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+	#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+
 	namespace Utils {
 
 		static GLenum PineconeImageFormatToGLDataFormat(ImageFormat format)
@@ -32,6 +46,67 @@ namespace Pinecone
 			return 0;
 		}
 
+		static GLenum PineconeTextureFilterToGLMinFilter(TextureFilter filter, bool mipmapped)
+		{
+			switch (filter)
+			{
+			case TextureFilter::NEAREST:		return mipmapped ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST;
+			case TextureFilter::LINEAR:			return mipmapped ? GL_LINEAR_MIPMAP_NEAREST : GL_LINEAR;
+			case TextureFilter::TRILINEAR:
+			case TextureFilter::ANISOTROPIC:	return mipmapped ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR;
+			}
+
+			PC_CORE_ASSERT(false);
+			return 0;
+		}
+
+		static GLenum PineconeTextureFilterToGLMagFilter(TextureFilter filter)
+		{
+			return filter == TextureFilter::NEAREST ? GL_NEAREST : GL_LINEAR;
+		}
+
+		static uint32_t GetMipCount(const TextureSpecification& specification, uint32_t width, uint32_t height)
+		{
+			return specification.GenerateMips ? TextureCooker::GetMipCount(width, height) : 1;
+		}
+
+		/// <summary>
+		/// Make block compressed pixels that are all the placeholder color
+		/// </summary>
+		/// <param name="format">The block compressed format, BC1 or BC3</param>
+		/// <param name="size">The size of the pixels in bytes</param>
+		/// <returns>The blocks</returns>
+		static std::vector<uint8_t> MakePlaceholderBlocks(CookedTextureFormat format, size_t size)
+		{
+			// Both end colors are the placeholder color as RGB565 and every index picks the first one.
+			// BC3 blocks start with an alpha block whose end values are the placeholder alpha
+			const uint16_t color = (uint16_t)(((s_PlaceholderColor[0] >> 3) << 11) | ((s_PlaceholderColor[1] >> 2) << 5) | (s_PlaceholderColor[2] >> 3));
+			const uint8_t colorBlock[8] = { (uint8_t)color, (uint8_t)(color >> 8), (uint8_t)color, (uint8_t)(color >> 8) };
+			const uint8_t alphaBlock[8] = { s_PlaceholderColor[3], s_PlaceholderColor[3] };
+
+			std::vector<uint8_t> blocks;
+			blocks.reserve(size);
+			while (blocks.size() < size)
+			{
+				if (format == CookedTextureFormat::BC3)
+					blocks.insert(blocks.end(), alphaBlock, alphaBlock + 8);
+				blocks.insert(blocks.end(), colorBlock, colorBlock + 8);
+			}
+			return blocks;
+		}
+
+		static float GetMaxSupportedAnisotropy()
+		{
+			// Anisotropic filtering is core since OpenGL 4.6, but every 4.5 driver has it as an extension
+			static float maxAnisotropy = 0.0f;
+			if (maxAnisotropy == 0.0f)
+			{
+				glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &maxAnisotropy);
+				maxAnisotropy = std::max(maxAnisotropy, 1.0f);
+			}
+			return maxAnisotropy;
+		}
+
 	}
 
 	Texture2D::Texture2D(const TextureSpecification& specification)
@@ -42,18 +117,14 @@ namespace Pinecone
 		m_InternalFormat = Utils::PineconeImageFormatToGLInternalFormat(m_Specification.Format);
 		m_DataFormat = Utils::PineconeImageFormatToGLDataFormat(m_Specification.Format);
 
+		m_MipCount = Utils::GetMipCount(m_Specification, m_Width, m_Height);
+
 		// Create a new 2D texture based on data from our specification
 		glCreateTextures(GL_TEXTURE_2D, 1, &m_RendererID);
-		glTextureStorage2D(m_RendererID, 1, m_InternalFormat, m_Width, m_Height);
-
-		GLenum filter = m_Specification.Filter == TextureFilter::NEAREST ? GL_NEAREST : GL_LINEAR;
+		glTextureStorage2D(m_RendererID, m_MipCount, m_InternalFormat, m_Width, m_Height);
 
 		// Configure the parameters for the texture
-		glTextureParameteri(m_RendererID, GL_TEXTURE_MIN_FILTER, filter);
-		glTextureParameteri(m_RendererID, GL_TEXTURE_MAG_FILTER, filter);
-
-		glTextureParameteri(m_RendererID, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTextureParameteri(m_RendererID, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		SetSamplerParameters();
 	}
 
 	Texture2D::Texture2D(const std::string& filepath)
@@ -73,6 +144,14 @@ namespace Pinecone
 
 	}
 
+	Texture2D::Texture2D(const TextureSpecification& specification, const CookedTextureHeader& header)
+		: m_Specification(specification)
+	{
+		PC_PROFILE_FUNCTION();
+
+		CreateStorage(header);
+	}
+
 	Texture2D::~Texture2D()
 	{
 		PC_PROFILE_FUNCTION();
@@ -91,6 +170,27 @@ namespace Pinecone
 		PC_CORE_ASSERT(size == m_Width * m_Height * bpp, "Data must be entire texture!");
 		// Set the data of the texture
 		glTextureSubImage2D(m_RendererID, 0, 0, 0, m_Width, m_Height, m_DataFormat, GL_UNSIGNED_BYTE, data);
+
+		// Make the smaller mip levels from the new pixels
+		if (m_MipCount > 1)
+			glGenerateTextureMipmap(m_RendererID);
+	}
+
+	void Texture2D::SetSubData(const void* data, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+	{
+		PC_PROFILE_FUNCTION();
+
+		// Make sure the region fits inside of the texture
+		PC_CORE_ASSERT(x + width <= m_Width && y + height <= m_Height, "Region must be inside the texture!");
+		// Rows of RGB data are not always 4 byte aligned, so tell OpenGL they are tightly packed
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		// Set the data of the region of the texture
+		glTextureSubImage2D(m_RendererID, 0, x, y, width, height, m_DataFormat, GL_UNSIGNED_BYTE, data);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+		// Make the smaller mip levels from the new pixels
+		if (m_MipCount > 1)
+			glGenerateTextureMipmap(m_RendererID);
 	}
 
 	void Texture2D::Bind(uint32_t slot) const
@@ -116,10 +216,99 @@ namespace Pinecone
 		return CreateRef<Texture2D>(specification, filepath);
 	}
 
+	Ref<Texture2D> Texture2D::CreateAsync(const std::string& filepath)
+	{
+		return CreateAsync(TextureSpecification(), filepath);
+	}
+
+	Ref<Texture2D> Texture2D::CreateAsync(const TextureSpecification& specification, const std::string& filepath)
+	{
+		PC_PROFILE_FUNCTION();
+
+		// Cooked textures are used as they are, other images are loaded from their cooked texture in the cache
+		const bool cooked = std::filesystem::path(filepath).extension() == ".pctex";
+		TextureCookSettings settings;
+		settings.GenerateMips = specification.GenerateMips;
+		settings.Compress = specification.Compress;
+		uint64_t key = cooked ? 0 : TextureCooker::GetKey(filepath, settings);
+		std::filesystem::path cachePath = cooked ? std::filesystem::path(filepath) : s_TextureCacheDirectory / TextureCooker::GetCacheName(filepath, settings);
+
+		// Only headers are read here. If the image has not been cooked yet, or has changed since, the header
+		// it will be cooked with is worked out from the header of the image file, so the storage made now
+		// already has the size and format the cooked texture will have
+		CookedTextureHeader header;
+		bool found = false;
+		if (cooked || key)
+		{
+			MappedFile file(cachePath);
+			found = TextureCooker::ReadHeader(file, cachePath, key, header);
+		}
+		if (!found && key)
+			found = TextureCooker::GetHeader(filepath, settings, key, header);
+
+		if (!found)
+		{
+			PC_CORE_ERROR("Failed to load texture: {}", filepath);
+			header.Width = 1;
+			header.Height = 1;
+			header.Format = CookedTextureFormat::RGBA8;
+			header.MipCount = 1;
+		}
+
+		Ref<Texture2D> texture = CreateRef<Texture2D>(specification, header);
+		texture->m_FilePath = filepath;
+
+		// The storage already has its final size, so the texture keeps its renderer ID once it is loaded.
+		// The levels are streamed from the smallest to the largest, until the smallest one is uploaded it
+		// is the only level sampled and holds the placeholder color
+		const uint32_t lastLevel = texture->m_MipCount - 1;
+		glTextureParameteri(texture->m_RendererID, GL_TEXTURE_BASE_LEVEL, lastLevel);
+		if (header.Format == CookedTextureFormat::BC1 || header.Format == CookedTextureFormat::BC3)
+		{
+			uint32_t levelWidth = std::max(header.Width >> lastLevel, 1u);
+			uint32_t levelHeight = std::max(header.Height >> lastLevel, 1u);
+			size_t levelSize = TextureCooker::GetLevelSize(header.Format, levelWidth, levelHeight);
+			std::vector<uint8_t> blocks = Utils::MakePlaceholderBlocks(header.Format, levelSize);
+			glCompressedTextureSubImage2D(texture->m_RendererID, lastLevel, 0, 0, levelWidth, levelHeight, texture->m_InternalFormat, (GLsizei)levelSize, blocks.data());
+		}
+		else
+		{
+			glClearTexImage(texture->m_RendererID, lastLevel, texture->m_DataFormat, GL_UNSIGNED_BYTE, s_PlaceholderColor);
+		}
+
+		if (found)
+			TextureStreamer::Load(texture, header.Format, cachePath, cooked ? std::string() : filepath, settings, key);
+
+		return texture;
+	}
+
 	void Texture2D::CreateFromFile(const std::string& filepath)
 	{
 		PC_PROFILE_FUNCTION();
 
+		// Cooked textures are used as they are
+		if (std::filesystem::path(filepath).extension() == ".pctex")
+		{
+			if (!LoadCooked(filepath, 0))
+				PC_CORE_ERROR("Failed to load texture: {}", filepath);
+			return;
+		}
+
+		// Other images are cooked the first time they are loaded and after they change, if the cooked
+		// texture can not be written they are decoded every time instead
+		TextureCookSettings settings;
+		settings.GenerateMips = m_Specification.GenerateMips;
+		settings.Compress = m_Specification.Compress;
+		uint64_t key = TextureCooker::GetKey(filepath, settings);
+		if (key)
+		{
+			std::filesystem::path cachePath = s_TextureCacheDirectory / TextureCooker::GetCacheName(filepath, settings);
+			if (LoadCooked(cachePath, key))
+				return;
+			if (TextureCooker::Cook(filepath, cachePath, settings, key) && LoadCooked(cachePath, key))
+				return;
+		}
+
 		int width, height, channels;
 		// Make sure the first pixel read from the texture is on the bottom left
 		// Not doing this will make our textures appear to be upside down
@@ -155,25 +344,102 @@ namespace Pinecone
 			// Make sure the format is supported
 			PC_CORE_ASSERT(internalFormat & dataFormat, "Format not supported!");
 
+			m_MipCount = Utils::GetMipCount(m_Specification, m_Width, m_Height);
+
 			// Create a 2D texture with the width, height, and the format from the loaded texture
 			glCreateTextures(GL_TEXTURE_2D, 1, &m_RendererID);
-			glTextureStorage2D(m_RendererID, 1, internalFormat, m_Width, m_Height);
-
-
-			GLenum filter = m_Specification.Filter == TextureFilter::NEAREST ? GL_NEAREST : GL_LINEAR;
+			glTextureStorage2D(m_RendererID, m_MipCount, internalFormat, m_Width, m_Height);
 
 			// Configure the parameters for the texture
-			glTextureParameteri(m_RendererID, GL_TEXTURE_MIN_FILTER, filter);
-			glTextureParameteri(m_RendererID, GL_TEXTURE_MAG_FILTER, filter);
-
-			glTextureParameteri(m_RendererID, GL_TEXTURE_WRAP_S, GL_REPEAT);
-			glTextureParameteri(m_RendererID, GL_TEXTURE_WRAP_T, GL_REPEAT);
+			SetSamplerParameters();
 
 			// Set the data of the texture
 			glTextureSubImage2D(m_RendererID, 0, 0, 0, m_Width, m_Height, dataFormat, GL_UNSIGNED_BYTE, data);
 
+			// The image could not be cooked, so its mips are made on the GPU instead
+			if (m_MipCount > 1)
+				glGenerateTextureMipmap(m_RendererID);
+
 			// Free the stb image data
 			stbi_image_free(data);
 		}
 	}
+
+	bool Texture2D::LoadCooked(const std::filesystem::path& filepath, uint64_t key)
+	{
+		PC_PROFILE_FUNCTION();
+
+		MappedFile file(filepath);
+		CookedTextureHeader header;
+		if (!TextureCooker::ReadHeader(file, filepath, key, header))
+			return false;
+
+		const bool compressed = header.Format == CookedTextureFormat::BC1 || header.Format == CookedTextureFormat::BC3;
+
+		m_IsLoaded = true;
+		CreateStorage(header);
+
+		// The levels are tightly packed, so rows of RGB data are not always 4 byte aligned
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		const uint8_t* data = file.GetData() + sizeof(CookedTextureHeader);
+		for (uint32_t level = 0; level < header.MipCount; level++)
+		{
+			uint32_t levelWidth = std::max(header.Width >> level, 1u);
+			uint32_t levelHeight = std::max(header.Height >> level, 1u);
+			size_t levelSize = TextureCooker::GetLevelSize(header.Format, levelWidth, levelHeight);
+
+			// Upload straight from the mapped file, there is nothing left to decode
+			if (compressed)
+				glCompressedTextureSubImage2D(m_RendererID, level, 0, 0, levelWidth, levelHeight, m_InternalFormat, (GLsizei)levelSize, data);
+			else
+				glTextureSubImage2D(m_RendererID, level, 0, 0, levelWidth, levelHeight, m_DataFormat, GL_UNSIGNED_BYTE, data);
+			data += levelSize;
+		}
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+		return true;
+	}
+
+	void Texture2D::CreateStorage(const CookedTextureHeader& header)
+	{
+		const bool hasAlpha = header.Format == CookedTextureFormat::RGBA8 || header.Format == CookedTextureFormat::BC3;
+
+		m_Width = header.Width;
+		m_Height = header.Height;
+		m_Specification.Width = m_Width;
+		m_Specification.Height = m_Height;
+		m_Specification.Format = hasAlpha ? ImageFormat::RGBA8 : ImageFormat::RGB8;
+		m_DataFormat = hasAlpha ? GL_RGBA : GL_RGB;
+		switch (header.Format)
+		{
+		case CookedTextureFormat::RGB8:		m_InternalFormat = GL_RGB8; break;
+		case CookedTextureFormat::RGBA8:	m_InternalFormat = GL_RGBA8; break;
+		case CookedTextureFormat::BC1:		m_InternalFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT; break;
+		case CookedTextureFormat::BC3:		m_InternalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; break;
+		}
+
+		m_MipCount = header.MipCount;
+
+		glCreateTextures(GL_TEXTURE_2D, 1, &m_RendererID);
+		glTextureStorage2D(m_RendererID, m_MipCount, m_InternalFormat, m_Width, m_Height);
+
+		SetSamplerParameters();
+	}
+
+	void Texture2D::SetSamplerParameters()
+	{
+		const bool mipmapped = m_MipCount > 1;
+		glTextureParameteri(m_RendererID, GL_TEXTURE_MIN_FILTER, Utils::PineconeTextureFilterToGLMinFilter(m_Specification.Filter, mipmapped));
+		glTextureParameteri(m_RendererID, GL_TEXTURE_MAG_FILTER, Utils::PineconeTextureFilterToGLMagFilter(m_Specification.Filter));
+
+		// Extra samples only help when there are mip levels to take them from
+		if (m_Specification.Filter == TextureFilter::ANISOTROPIC && mipmapped)
+		{
+			float anisotropy = std::clamp(m_Specification.MaxAnisotropy, 1.0f, Utils::GetMaxSupportedAnisotropy());
+			glTextureParameterf(m_RendererID, GL_TEXTURE_MAX_ANISOTROPY, anisotropy);
+		}
+
+		glTextureParameteri(m_RendererID, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTextureParameteri(m_RendererID, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	}
 }
\ No newline at end of file
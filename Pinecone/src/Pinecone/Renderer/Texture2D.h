@@ -1,10 +1,14 @@
 #pragma once
 #include "Texture.h"
 
+#include <filesystem>
+
 typedef unsigned int GLenum;
 
 namespace Pinecone
 {
+	struct CookedTextureHeader;
+
 	class Texture2D : public Texture
 	{
 	public:
@@ -24,6 +28,12 @@ namespace Pinecone
 		/// <param name="specification">The texture specification</param>
 		Texture2D(const TextureSpecification& specification, const std::string& filepath);
 		/// <summary>
+		/// The Texture2D constructor for creating the storage of a cooked texture without setting its pixels
+		/// </summary>
+		/// <param name="specification">The texture specification, its size and format are taken from the header</param>
+		/// <param name="header">The header of the cooked texture</param>
+		Texture2D(const TextureSpecification& specification, const CookedTextureHeader& header);
+		/// <summary>
 		/// The Texture deconstructor
 		/// </summary>
 		~Texture2D() override;
@@ -35,6 +45,17 @@ namespace Pinecone
 		/// <param name="size">The total size of the pixel data</param>
 		void SetData(void* data, uint32_t size) override;
 		/// <summary>
+		/// Set the pixels of a region of the texture. The pixel data must be in the same
+		/// format as the texture and tightly packed. Textures with mips have all of their
+		/// mips made again, so it is cheaper to update one large region than many small ones
+		/// </summary>
+		/// <param name="data">The pixel data</param>
+		/// <param name="x">The x offset of the region (in pixels)</param>
+		/// <param name="y">The y offset of the region (in pixels)</param>
+		/// <param name="width">The width of the region (in pixels)</param>
+		/// <param name="height">The height of the region (in pixels)</param>
+		void SetSubData(const void* data, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+		/// <summary>
 		/// Bind the texture to a texture slot
 		/// </summary>
 		/// <param name="slot">The texture slot to bind to</param>
@@ -51,6 +72,11 @@ namespace Pinecone
 		/// <returns>The texture height</returns>
 		uint32_t GetHeight() const override { return m_Height; }
 		/// <summary>
+		/// Get the number of mip levels the texture has
+		/// </summary>
+		/// <returns>The mip level count, 1 if the texture has no mips</returns>
+		uint32_t GetMipCount() const { return m_MipCount; }
+		/// <summary>
 		/// The ID for the texture created by OpenGL
 		/// </summary>
 		/// <returns>The texture ID</returns>
@@ -103,16 +129,54 @@ namespace Pinecone
 		/// <param name="filepath">The file path to the texture file</param>
 		/// <returns>A shared pointer to a new Texture2D</returns>
 		static Ref<Texture2D> Create(const TextureSpecification& specification, const std::string& filepath);
+		/// <summary>
+		/// Create a smart shared pointer to a new Texture2D that is loaded in the background. Only the
+		/// header of the cooked texture, or of the image if it has not been cooked yet, is read right away.
+		/// The image is cooked on a worker thread if needed and the TextureStreamer uploads the mip levels
+		/// from the cooked texture, until then the texture is a placeholder color and IsLoaded returns false
+		/// </summary>
+		/// <param name="filepath">The file path to the texture file</param>
+		/// <returns>A shared pointer to a new Texture2D</returns>
+		static Ref<Texture2D> CreateAsync(const std::string& filepath);
+		/// <summary>
+		/// Create a smart shared pointer to a new Texture2D that is loaded in the background. Only the
+		/// header of the cooked texture, or of the image if it has not been cooked yet, is read right away.
+		/// The image is cooked on a worker thread if needed and the TextureStreamer uploads the mip levels
+		/// from the cooked texture, until then the texture is a placeholder color and IsLoaded returns false
+		/// </summary>
+		/// <param name="specification">The texture specification</param>
+		/// <param name="filepath">The file path to the texture file</param>
+		/// <returns>A shared pointer to a new Texture2D</returns>
+		static Ref<Texture2D> CreateAsync(const TextureSpecification& specification, const std::string& filepath);
 	private:
 		void CreateFromFile(const std::string& filepath);
+		/// <summary>
+		/// Create the texture from a cooked texture file, uploading every mip level straight from the mapped file
+		/// </summary>
+		/// <param name="filepath">The file path to the cooked texture</param>
+		/// <param name="key">The key the cooked texture must have been cooked with, 0 to accept any key</param>
+		/// <returns>True if the texture was created, false if the file is missing, out of date or corrupt</returns>
+		bool LoadCooked(const std::filesystem::path& filepath, uint64_t key);
+		/// <summary>
+		/// Create the texture storage with the size, format and mip level count of a cooked texture
+		/// </summary>
+		/// <param name="header">The header of the cooked texture</param>
+		void CreateStorage(const CookedTextureHeader& header);
+		/// <summary>
+		/// Set the filter and wrap parameters from the texture specification and the mip level count
+		/// </summary>
+		void SetSamplerParameters();
 	private:
 		uint32_t m_RendererID;
 		uint32_t m_Width, m_Height;
+		uint32_t m_MipCount = 1;
 		std::string m_FilePath;
 
 		TextureSpecification m_Specification;
 
 		bool m_IsLoaded = false;
 		GLenum m_InternalFormat, m_DataFormat;
+
+		friend class TextureStreamer;
 	};
 }
\ No newline at end of file
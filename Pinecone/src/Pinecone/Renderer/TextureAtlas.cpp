@@ -0,0 +1,246 @@
+#include "pcpch.h"
+#include "TextureAtlas.h"
+
+#include <stb_image.h>
+
+namespace Pinecone
+{
+	/// <summary>
+	/// Find the height a rectangle would be placed at if its left edge starts at a skyline node
+	/// </summary>
+	/// <param name="skyline">The skyline of the page</param>
+	/// <param name="index">The index of the node the rectangle starts at</param>
+	/// <param name="width">The width of the rectangle</param>
+	/// <param name="height">The height of the rectangle</param>
+	/// <param name="pageSize">The width and height of the page</param>
+	/// <param name="y">The y position the rectangle would be placed at</param>
+	/// <returns>True if the rectangle fits</returns>
+	template<typename Node>
+	static bool FitSkyline(const std::vector<Node>& skyline, size_t index, uint32_t width, uint32_t height, uint32_t pageSize, uint32_t& y)
+	{
+		if (skyline[index].X + width > pageSize)
+			return false;
+
+		// The rectangle has to sit on top of the highest node it spans over
+		int64_t widthLeft = width;
+		y = skyline[index].Y;
+		for (size_t i = index; widthLeft > 0; i++)
+		{
+			y = std::max(y, skyline[i].Y);
+			if (y + height > pageSize)
+				return false;
+			widthLeft -= skyline[i].Width;
+		}
+		return true;
+	}
+
+	TextureAtlas::TextureAtlas(const TextureAtlasSpecification& specification)
+		: m_Specification(specification)
+	{
+	}
+
+	Ref<SubTexture2D> TextureAtlas::Add(const std::string& filepath)
+	{
+		PC_PROFILE_FUNCTION();
+
+		// Don't load the same file twice
+		if (Ref<SubTexture2D> subTexture = Get(filepath))
+			return subTexture;
+
+		int width, height, channels;
+		// Flip the image the same way Texture2D does so the first row is the bottom row
+		stbi_set_flip_vertically_on_load(1);
+		// Always load 4 channels as the atlas pages are RGBA8
+		stbi_uc* data = stbi_load(filepath.c_str(), &width, &height, &channels, 4);
+		if (!data)
+		{
+			PC_CORE_ERROR("Failed to load texture atlas image: {}", filepath);
+			return nullptr;
+		}
+
+		Ref<SubTexture2D> subTexture = Add(filepath, data, (uint32_t)width, (uint32_t)height);
+
+		// Free the stb image data
+		stbi_image_free(data);
+		return subTexture;
+	}
+
+	Ref<SubTexture2D> TextureAtlas::Add(const std::string& name, const void* pixels, uint32_t width, uint32_t height)
+	{
+		PC_PROFILE_FUNCTION();
+
+		if (Ref<SubTexture2D> subTexture = Get(name))
+			return subTexture;
+
+		PC_CORE_ASSERT(width > 0 && height > 0, "Texture atlas images cannot be empty!");
+
+		const uint32_t padding = m_Specification.Padding;
+		const uint32_t paddedWidth = width + padding * 2;
+		const uint32_t paddedHeight = height + padding * 2;
+
+		// Images that are too large to ever fit in a page get a texture of their own
+		if (paddedWidth > m_Specification.PageSize || paddedHeight > m_Specification.PageSize)
+		{
+			PC_CORE_WARN("Image '{}' ({}x{}) is too large for a texture atlas page, it will not be batched with other images", name, width, height);
+
+			TextureSpecification spec;
+			spec.Width = width;
+			spec.Height = height;
+			spec.Format = ImageFormat::RGBA8;
+			spec.GenerateMips = false;
+			spec.Filter = m_Specification.Filter;
+
+			Ref<Texture2D> texture = Texture2D::Create(spec);
+			texture->SetData((void*)pixels, width * height * 4);
+
+			Ref<SubTexture2D> subTexture = SubTexture2D::Create(texture, { 0.0f, 0.0f }, { 1.0f, 1.0f });
+			m_SubTextures[name] = subTexture;
+			return subTexture;
+		}
+
+		// Pack the image into the first page that has room for it, otherwise make a new page
+		uint32_t x = 0, y = 0;
+		Page* page = nullptr;
+		for (Page& p : m_Pages)
+		{
+			if (Pack(p, paddedWidth, paddedHeight, x, y))
+			{
+				page = &p;
+				break;
+			}
+		}
+		if (!page)
+		{
+			page = &CreatePage();
+			bool packed = Pack(*page, paddedWidth, paddedHeight, x, y);
+			PC_CORE_ASSERT(packed, "Failed to pack image into an empty texture atlas page!");
+		}
+
+		// Copy the image into a padded image where the padding repeats the images edge pixels
+		const uint32_t* source = (const uint32_t*)pixels;
+		std::vector<uint32_t> padded((size_t)paddedWidth * paddedHeight);
+		for (uint32_t py = 0; py < paddedHeight; py++)
+		{
+			uint32_t sy = (uint32_t)std::clamp((int64_t)py - padding, (int64_t)0, (int64_t)height - 1);
+			for (uint32_t px = 0; px < paddedWidth; px++)
+			{
+				uint32_t sx = (uint32_t)std::clamp((int64_t)px - padding, (int64_t)0, (int64_t)width - 1);
+				padded[(size_t)py * paddedWidth + px] = source[(size_t)sy * width + sx];
+			}
+		}
+		page->Texture->SetSubData(padded.data(), x, y, paddedWidth, paddedHeight);
+
+		// The sub texture only covers the image itself, not the padding
+		float pageSize = (float)m_Specification.PageSize;
+		glm::vec2 min = { (x + padding) / pageSize, (y + padding) / pageSize };
+		glm::vec2 max = { (x + padding + width) / pageSize, (y + padding + height) / pageSize };
+
+		Ref<SubTexture2D> subTexture = SubTexture2D::Create(page->Texture, min, max);
+		m_SubTextures[name] = subTexture;
+		return subTexture;
+	}
+
+	Ref<SubTexture2D> TextureAtlas::Get(const std::string& name) const
+	{
+		auto it = m_SubTextures.find(name);
+		if (it != m_SubTextures.end())
+			return it->second;
+		return nullptr;
+	}
+
+	TextureAtlas::Page& TextureAtlas::CreatePage()
+	{
+		PC_PROFILE_FUNCTION();
+
+		TextureSpecification spec;
+		spec.Width = m_Specification.PageSize;
+		spec.Height = m_Specification.PageSize;
+		spec.Format = ImageFormat::RGBA8;
+		spec.GenerateMips = false;
+		spec.Filter = m_Specification.Filter;
+
+		Page& page = m_Pages.emplace_back();
+		page.Texture = Texture2D::Create(spec);
+
+		// Clear the page so the unused space is transparent
+		std::vector<uint32_t> clear((size_t)spec.Width * spec.Height, 0);
+		page.Texture->SetData(clear.data(), spec.Width * spec.Height * 4);
+
+		// An empty page has a flat skyline along the bottom
+		page.Skyline.push_back({ 0, 0, m_Specification.PageSize });
+		return page;
+	}
+
+	bool TextureAtlas::Pack(Page& page, uint32_t width, uint32_t height, uint32_t& x, uint32_t& y)
+	{
+		std::vector<SkylineNode>& skyline = page.Skyline;
+		const uint32_t pageSize = m_Specification.PageSize;
+
+		// Find the node that places the rectangle the lowest, using the narrowest node to break ties
+		size_t bestIndex = skyline.size();
+		uint32_t bestY = UINT32_MAX, bestWidth = UINT32_MAX;
+		for (size_t i = 0; i < skyline.size(); i++)
+		{
+			uint32_t fitY;
+			if (!FitSkyline(skyline, i, width, height, pageSize, fitY))
+				continue;
+
+			if (fitY < bestY || (fitY == bestY && skyline[i].Width < bestWidth))
+			{
+				bestIndex = i;
+				bestY = fitY;
+				bestWidth = skyline[i].Width;
+			}
+		}
+
+		if (bestIndex == skyline.size())
+			return false;
+
+		x = skyline[bestIndex].X;
+		y = bestY;
+
+		// Add the top edge of the rectangle to the skyline
+		skyline.insert(skyline.begin() + bestIndex, { x, y + height, width });
+
+		// Remove or shrink the nodes that are now underneath the rectangle
+		for (size_t i = bestIndex + 1; i < skyline.size();)
+		{
+			const SkylineNode& previous = skyline[i - 1];
+			SkylineNode& node = skyline[i];
+
+			uint32_t previousEnd = previous.X + previous.Width;
+			if (node.X >= previousEnd)
+				break;
+
+			uint32_t shrink = previousEnd - node.X;
+			if (node.Width <= shrink)
+			{
+				skyline.erase(skyline.begin() + i);
+				continue;
+			}
+
+			node.X += shrink;
+			node.Width -= shrink;
+			break;
+		}
+
+		// Merge neighbouring nodes that are at the same height
+		for (size_t i = 0; i + 1 < skyline.size();)
+		{
+			if (skyline[i].Y == skyline[i + 1].Y)
+			{
+				skyline[i].Width += skyline[i + 1].Width;
+				skyline.erase(skyline.begin() + i + 1);
+			}
+			else
+				i++;
+		}
+
+		return true;
+	}
+
+	Ref<TextureAtlas> TextureAtlas::Create(const TextureAtlasSpecification& specification)
+	{
+		return CreateRef<TextureAtlas>(specification);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "Pinecone/Renderer/Texture2D.h"
+#include "Pinecone/Renderer/SubTexture2D.h"
+
+namespace Pinecone
+{
+	struct TextureAtlasSpecification
+	{
+		// The width and height of each atlas page (in pixels)
+		uint32_t PageSize = 2048;
+		// The number of pixels around each image that are filled with the images edge pixels.
+		// This stops neighbouring images from bleeding into each other when filtering
+		uint32_t Padding = 1;
+		TextureFilter Filter = TextureFilter::LINEAR;
+
+		TextureAtlasSpecification() = default;
+		TextureAtlasSpecification(TextureFilter filter) : Filter(filter) {}
+	};
+
+	/// <summary>
+	/// Packs many small images into a few large textures (pages) so that they can be drawn
+	/// together without running out of texture slots. Images can be added at any time, each
+	/// one is packed into the first page with room for it using a skyline packer and uploaded
+	/// straight away.
+	/// </summary>
+	/// <remarks>
+	/// Sub textures from an atlas do not repeat, so they should be drawn with a tiling factor of 1
+	/// </remarks>
+	class TextureAtlas
+	{
+	public:
+		/// <summary>
+		/// The TextureAtlas constructor
+		/// </summary>
+		/// <param name="specification">The atlas specification</param>
+		TextureAtlas(const TextureAtlasSpecification& specification = TextureAtlasSpecification());
+
+		/// <summary>
+		/// Load an image file and add it to the atlas. Adding the same file twice returns the
+		/// sub texture that was created the first time.
+		/// </summary>
+		/// <param name="filepath">The file path to the image file</param>
+		/// <returns>The region of the atlas the image was packed into, or null if the file could not be loaded</returns>
+		Ref<SubTexture2D> Add(const std::string& filepath);
+		/// <summary>
+		/// Add RGBA8 pixel data to the atlas with a name to find it by. The first row of pixels is the bottom row.
+		/// </summary>
+		/// <param name="name">The name of the image</param>
+		/// <param name="pixels">The RGBA8 pixel data</param>
+		/// <param name="width">The width of the image (in pixels)</param>
+		/// <param name="height">The height of the image (in pixels)</param>
+		/// <returns>The region of the atlas the image was packed into</returns>
+		Ref<SubTexture2D> Add(const std::string& name, const void* pixels, uint32_t width, uint32_t height);
+
+		/// <summary>
+		/// Get a sub texture that was previously added to the atlas
+		/// </summary>
+		/// <param name="name">The file path or name the image was added with</param>
+		/// <returns>The sub texture, or null if there is no image with that name</returns>
+		Ref<SubTexture2D> Get(const std::string& name) const;
+
+		/// <summary>
+		/// Get the number of pages in the atlas
+		/// </summary>
+		/// <returns>The page count</returns>
+		uint32_t GetPageCount() const { return (uint32_t)m_Pages.size(); }
+		/// <summary>
+		/// Get the texture of a page in the atlas
+		/// </summary>
+		/// <param name="index">The page index</param>
+		/// <returns>The page texture</returns>
+		const Ref<Texture2D>& GetPage(uint32_t index) const { return m_Pages[index].Texture; }
+
+		/// <summary>
+		/// Get the atlas specification
+		/// </summary>
+		/// <returns>The atlas specification</returns>
+		const TextureAtlasSpecification& GetSpecification() const { return m_Specification; }
+
+		/// <summary>
+		/// Create a smart shared pointer to a new TextureAtlas
+		/// </summary>
+		/// <param name="specification">The atlas specification</param>
+		/// <returns>A shared pointer to a new TextureAtlas</returns>
+		static Ref<TextureAtlas> Create(const TextureAtlasSpecification& specification = TextureAtlasSpecification());
+	private:
+		// A horizontal segment of the top edge of the packed area of a page
+		struct SkylineNode
+		{
+			uint32_t X, Y, Width;
+		};
+
+		struct Page
+		{
+			Ref<Texture2D> Texture;
+			std::vector<SkylineNode> Skyline;
+		};
+
+		/// <summary>
+		/// Create a new empty page
+		/// </summary>
+		/// <returns>The new page</returns>
+		Page& CreatePage();
+		/// <summary>
+		/// Find a spot for a rectangle in a page using the skyline bottom left heuristic and reserve it
+		/// </summary>
+		/// <param name="page">The page to pack into</param>
+		/// <param name="width">The width of the rectangle</param>
+		/// <param name="height">The height of the rectangle</param>
+		/// <param name="x">The x position the rectangle was packed at</param>
+		/// <param name="y">The y position the rectangle was packed at</param>
+		/// <returns>True if the rectangle fits in the page</returns>
+		bool Pack(Page& page, uint32_t width, uint32_t height, uint32_t& x, uint32_t& y);
+	private:
+		TextureAtlasSpecification m_Specification;
+
+		std::vector<Page> m_Pages;
+		std::unordered_map<std::string, Ref<SubTexture2D>> m_SubTextures;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,447 @@
+#include "pcpch.h"
+#include "TextureCooker.h"
+
+#include "Pinecone/Core/JobSystem.h"
+#include "Pinecone/Core/Hash.h"
+#include "Pinecone/Core/MappedFile.h"
+
+#include <stb_image.h>
+
+// x86-64 always has SSE2, other targets fall back to scalar code
+#if defined(_M_X64) || defined(__SSE2__)
+	#define PC_TEXTURECOOKER_SSE2
+	#include <emmintrin.h>
+#endif
+
+namespace Pinecone
+{
+	/// <summary>
+	/// Make the next mip level of an image by averaging each 2x2 square of pixels. An odd row or column
+	/// at the edge is averaged with itself. Rows are split across the JobSystem workers, and RGBA rows
+	/// average two pixels at a time with SSE2 where it is available
+	/// </summary>
+	static std::vector<uint8_t> Downsample(const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height, uint32_t channels)
+	{
+		const uint32_t levelWidth = std::max(width / 2, 1u);
+		const uint32_t levelHeight = std::max(height / 2, 1u);
+		std::vector<uint8_t> level((size_t)levelWidth * levelHeight * channels);
+
+		JobSystem::ParallelFor(levelHeight, 0, [&pixels, &level, width, height, channels, levelWidth](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t y = begin; y < end; y++)
+				{
+					const uint8_t* row0 = &pixels[(size_t)std::min(y * 2, height - 1) * width * channels];
+					const uint8_t* row1 = &pixels[(size_t)std::min(y * 2 + 1, height - 1) * width * channels];
+					uint8_t* destination = &level[(size_t)y * levelWidth * channels];
+
+					uint32_t x = 0;
+#ifdef PC_TEXTURECOOKER_SSE2
+					if (channels == 4)
+					{
+						const __m128i zero = _mm_setzero_si128();
+						const __m128i round = _mm_set1_epi16(2);
+						// Four source pixels of each row make two destination pixels, as long as none of them is clamped
+						for (; x + 1 < levelWidth && x * 2 + 3 < width; x += 2)
+						{
+							const __m128i top = _mm_loadu_si128((const __m128i*)(row0 + x * 8));
+							const __m128i bottom = _mm_loadu_si128((const __m128i*)(row1 + x * 8));
+							// Widen to 16 bits and add the rows, the low half holds the first two pixels and the high half the last two
+							const __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+							const __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+							// Add the neighbouring pixels together
+							__m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(low, high), _mm_unpackhi_epi64(low, high));
+							sum = _mm_srli_epi16(_mm_add_epi16(sum, round), 2);
+							_mm_storel_epi64((__m128i*)(destination + x * 4), _mm_packus_epi16(sum, sum));
+						}
+					}
+#endif
+					for (; x < levelWidth; x++)
+					{
+						const uint32_t x0 = std::min(x * 2, width - 1) * channels;
+						const uint32_t x1 = std::min(x * 2 + 1, width - 1) * channels;
+						for (uint32_t c = 0; c < channels; c++)
+							destination[x * channels + c] = (uint8_t)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+					}
+				}
+			});
+
+		return level;
+	}
+
+	static uint16_t PackRGB565(const float color[3])
+	{
+		uint32_t r = (uint32_t)std::clamp(color[0] * (31.0f / 255.0f) + 0.5f, 0.0f, 31.0f);
+		uint32_t g = (uint32_t)std::clamp(color[1] * (63.0f / 255.0f) + 0.5f, 0.0f, 63.0f);
+		uint32_t b = (uint32_t)std::clamp(color[2] * (31.0f / 255.0f) + 0.5f, 0.0f, 31.0f);
+		return (uint16_t)((r << 11) | (g << 5) | b);
+	}
+
+	static void UnpackRGB565(uint16_t packed, float color[3])
+	{
+		uint32_t r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+		color[0] = (float)((r << 3) | (r >> 2));
+		color[1] = (float)((g << 2) | (g >> 4));
+		color[2] = (float)((b << 3) | (b >> 2));
+	}
+
+	/// <summary>
+	/// Compress the colors of a 4x4 block of RGBA pixels into 8 bytes. The two end colors are picked along
+	/// the axis the colors of the block vary the most along, every pixel then gets the closest of the four
+	/// colors on the line between them
+	/// </summary>
+	static void CompressColorBlock(const uint8_t pixels[16][4], uint8_t* out)
+	{
+		float mean[3] = { 0.0f, 0.0f, 0.0f };
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			for (uint32_t c = 0; c < 3; c++)
+				mean[c] += pixels[i][c] / 16.0f;
+		}
+
+		float covariance[6] = {}; // rr, rg, rb, gg, gb, bb
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			float r = pixels[i][0] - mean[0], g = pixels[i][1] - mean[1], b = pixels[i][2] - mean[2];
+			covariance[0] += r * r; covariance[1] += r * g; covariance[2] += r * b;
+			covariance[3] += g * g; covariance[4] += g * b; covariance[5] += b * b;
+		}
+
+		// A few rounds of power iteration are enough to find the main axis of 16 colors
+		float axis[3] = { 1.0f, 1.0f, 1.0f };
+		for (uint32_t iteration = 0; iteration < 4; iteration++)
+		{
+			float next[3] = {
+				covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+				covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+				covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2]
+			};
+			float length = std::max({ std::abs(next[0]), std::abs(next[1]), std::abs(next[2]) });
+			if (length < 1e-6f)
+				break;
+			for (uint32_t c = 0; c < 3; c++)
+				axis[c] = next[c] / length;
+		}
+
+		float minProjection = std::numeric_limits<float>::max(), maxProjection = std::numeric_limits<float>::lowest();
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			float projection = (pixels[i][0] - mean[0]) * axis[0] + (pixels[i][1] - mean[1]) * axis[1] + (pixels[i][2] - mean[2]) * axis[2];
+			minProjection = std::min(minProjection, projection);
+			maxProjection = std::max(maxProjection, projection);
+		}
+
+		// Pull the end colors in slightly, the colors between them are used more often than the ends
+		const float axisLengthSquared = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+		const float inset = (maxProjection - minProjection) / 16.0f;
+		float endpoints[2][3];
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			endpoints[0][c] = mean[c] + axis[c] * (maxProjection - inset) / std::max(axisLengthSquared, 1e-6f);
+			endpoints[1][c] = mean[c] + axis[c] * (minProjection + inset) / std::max(axisLengthSquared, 1e-6f);
+		}
+
+		uint16_t color0 = PackRGB565(endpoints[0]);
+		uint16_t color1 = PackRGB565(endpoints[1]);
+		// The first color has to be the larger one, otherwise the block is decoded with only three colors
+		if (color0 < color1)
+			std::swap(color0, color1);
+
+		uint32_t indices = 0;
+		if (color0 != color1)
+		{
+			float palette[4][3];
+			UnpackRGB565(color0, palette[0]);
+			UnpackRGB565(color1, palette[1]);
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+				palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+			}
+
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				uint32_t best = 0;
+				float bestDistance = std::numeric_limits<float>::max();
+				for (uint32_t p = 0; p < 4; p++)
+				{
+					float r = pixels[i][0] - palette[p][0], g = pixels[i][1] - palette[p][1], b = pixels[i][2] - palette[p][2];
+					float distance = r * r + g * g + b * b;
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						best = p;
+					}
+				}
+				indices |= best << (i * 2);
+			}
+		}
+
+		out[0] = (uint8_t)(color0 & 0xFF);
+		out[1] = (uint8_t)(color0 >> 8);
+		out[2] = (uint8_t)(color1 & 0xFF);
+		out[3] = (uint8_t)(color1 >> 8);
+		for (uint32_t i = 0; i < 4; i++)
+			out[4 + i] = (uint8_t)(indices >> (i * 8));
+	}
+
+	/// <summary>
+	/// Compress the alpha of a 4x4 block of RGBA pixels into 8 bytes, using the smallest and largest
+	/// alpha of the block and the six values between them
+	/// </summary>
+	static void CompressAlphaBlock(const uint8_t pixels[16][4], uint8_t* out)
+	{
+		uint8_t alpha0 = 0, alpha1 = 255;
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			alpha0 = std::max(alpha0, pixels[i][3]);
+			alpha1 = std::min(alpha1, pixels[i][3]);
+		}
+
+		uint64_t indices = 0;
+		if (alpha0 != alpha1)
+		{
+			// Index 0 and 1 are the end values, 2 to 7 are spread evenly from the first to the second
+			uint8_t palette[8] = { alpha0, alpha1 };
+			for (uint32_t p = 2; p < 8; p++)
+				palette[p] = (uint8_t)(((8 - p) * alpha0 + (p - 1) * alpha1 + 3) / 7);
+
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				uint64_t best = 0;
+				int bestDistance = std::numeric_limits<int>::max();
+				for (uint32_t p = 0; p < 8; p++)
+				{
+					int distance = std::abs((int)pixels[i][3] - (int)palette[p]);
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						best = p;
+					}
+				}
+				indices |= best << (i * 3);
+			}
+		}
+
+		out[0] = alpha0;
+		out[1] = alpha1;
+		for (uint32_t i = 0; i < 6; i++)
+			out[2 + i] = (uint8_t)(indices >> (i * 8));
+	}
+
+	/// <summary>
+	/// Block compress one mip level. Blocks past the edge of a level smaller than 4 pixels repeat the edge pixels
+	/// </summary>
+	static std::vector<uint8_t> CompressLevel(const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height, uint32_t channels, CookedTextureFormat format)
+	{
+		const uint32_t blocksX = (width + 3) / 4;
+		const uint32_t blocksY = (height + 3) / 4;
+		const uint32_t blockSize = format == CookedTextureFormat::BC3 ? 16 : 8;
+		std::vector<uint8_t> blocks((size_t)blocksX * blocksY * blockSize);
+
+		JobSystem::ParallelFor(blocksY, 0, [&](uint32_t begin, uint32_t end)
+			{
+				uint8_t block[16][4];
+				for (uint32_t blockY = begin; blockY < end; blockY++)
+				{
+					for (uint32_t blockX = 0; blockX < blocksX; blockX++)
+					{
+						for (uint32_t i = 0; i < 16; i++)
+						{
+							uint32_t x = std::min(blockX * 4 + i % 4, width - 1);
+							uint32_t y = std::min(blockY * 4 + i / 4, height - 1);
+							const uint8_t* pixel = &pixels[((size_t)y * width + x) * channels];
+							block[i][0] = pixel[0];
+							block[i][1] = pixel[1];
+							block[i][2] = pixel[2];
+							block[i][3] = channels == 4 ? pixel[3] : 255;
+						}
+
+						uint8_t* out = &blocks[((size_t)blockY * blocksX + blockX) * blockSize];
+						if (format == CookedTextureFormat::BC3)
+						{
+							CompressAlphaBlock(block, out);
+							out += 8;
+						}
+						CompressColorBlock(block, out);
+					}
+				}
+			});
+
+		return blocks;
+	}
+
+	bool TextureCooker::Cook(const std::filesystem::path& source, const std::filesystem::path& destination, const TextureCookSettings& settings, uint64_t key)
+	{
+		PC_PROFILE_FUNCTION();
+
+		std::string sourceString = source.string();
+
+		CookedTextureHeader header;
+		if (!GetHeader(source, settings, key, header))
+		{
+			PC_CORE_ERROR("Failed to load texture: {}", sourceString);
+			return false;
+		}
+		const bool compress = header.Format == CookedTextureFormat::BC1 || header.Format == CookedTextureFormat::BC3;
+		const uint32_t channels = header.Format == CookedTextureFormat::RGB8 || header.Format == CookedTextureFormat::BC1 ? 3 : 4;
+		if (settings.Compress && !compress)
+			PC_CORE_WARN("Texture {} is not a multiple of 4 pixels in size, it is cooked without compression", sourceString);
+
+		// Make sure the first row is the bottom of the image, this is the only time it is flipped
+		stbi_set_flip_vertically_on_load_thread(1);
+		int width, height, fileChannels;
+		stbi_uc* decoded = stbi_load(sourceString.c_str(), &width, &height, &fileChannels, channels);
+		if (!decoded)
+		{
+			PC_CORE_ERROR("Failed to load texture: {}", sourceString);
+			return false;
+		}
+
+		std::vector<uint8_t> pixels(decoded, decoded + (size_t)width * height * channels);
+		stbi_image_free(decoded);
+
+		std::error_code error;
+		std::filesystem::create_directories(destination.parent_path(), error);
+
+		std::ofstream out(destination, std::ios::out | std::ios::binary);
+		if (!out)
+		{
+			PC_CORE_WARN("Could not write cooked texture {}", destination.string());
+			return false;
+		}
+
+		out.write((const char*)&header, sizeof(CookedTextureHeader));
+
+		uint32_t levelWidth = width, levelHeight = height;
+		for (uint32_t level = 0; level < header.MipCount; level++)
+		{
+			if (compress)
+			{
+				std::vector<uint8_t> blocks = CompressLevel(pixels, levelWidth, levelHeight, channels, header.Format);
+				out.write((const char*)blocks.data(), blocks.size());
+			}
+			else
+			{
+				out.write((const char*)pixels.data(), pixels.size());
+			}
+
+			if (level + 1 < header.MipCount)
+			{
+				pixels = Downsample(pixels, levelWidth, levelHeight, channels);
+				levelWidth = std::max(levelWidth / 2, 1u);
+				levelHeight = std::max(levelHeight / 2, 1u);
+			}
+		}
+
+		return (bool)out;
+	}
+
+	uint64_t TextureCooker::GetKey(const std::filesystem::path& source, const TextureCookSettings& settings)
+	{
+		std::error_code error;
+		const uint64_t size = (uint64_t)std::filesystem::file_size(source, error);
+		if (error)
+			return 0;
+		const uint64_t writeTime = (uint64_t)std::filesystem::last_write_time(source, error).time_since_epoch().count();
+
+		// Everything the cooked texture depends on
+		std::string path = source.generic_string();
+		uint64_t hash = HashBytes(path.data(), path.size());
+		hash = HashBytes(&size, sizeof(size), hash);
+		hash = HashBytes(&writeTime, sizeof(writeTime), hash);
+		const uint8_t flags[2] = { settings.GenerateMips, settings.Compress };
+		hash = HashBytes(flags, sizeof(flags), hash);
+
+		// 0 means there is no source file
+		return hash ? hash : 1;
+	}
+
+	std::filesystem::path TextureCooker::GetCacheName(const std::filesystem::path& source, const TextureCookSettings& settings)
+	{
+		// Unlike the key this does not change when the source file is modified, so cooking it again
+		// replaces the out of date texture instead of leaving it behind
+		std::string path = source.lexically_normal().generic_string();
+		uint64_t hash = HashBytes(path.data(), path.size());
+		const uint8_t flags[2] = { settings.GenerateMips, settings.Compress };
+		hash = HashBytes(flags, sizeof(flags), hash);
+
+		char name[32];
+		snprintf(name, sizeof(name), "-%016llx.pctex", (unsigned long long)hash);
+		return source.stem().string() + name;
+	}
+
+	bool TextureCooker::GetHeader(const std::filesystem::path& source, const TextureCookSettings& settings, uint64_t key, CookedTextureHeader& header)
+	{
+		int width, height, fileChannels;
+		if (!stbi_info(source.string().c_str(), &width, &height, &fileChannels))
+			return false;
+
+		// Images with three channels are kept as RGB, everything else is expanded to RGBA
+		const bool hasAlpha = fileChannels != 3;
+		const bool compress = settings.Compress && width % 4 == 0 && height % 4 == 0;
+
+		header.Magic = CookedTextureHeader::CurrentMagic;
+		header.Version = CookedTextureHeader::CurrentVersion;
+		header.Key = key;
+		header.Width = width;
+		header.Height = height;
+		if (compress)
+			header.Format = hasAlpha ? CookedTextureFormat::BC3 : CookedTextureFormat::BC1;
+		else
+			header.Format = hasAlpha ? CookedTextureFormat::RGBA8 : CookedTextureFormat::RGB8;
+		header.MipCount = settings.GenerateMips ? GetMipCount(width, height) : 1;
+		header.Flags = 0;
+		header.Reserved = 0;
+		return true;
+	}
+
+	bool TextureCooker::ReadHeader(const MappedFile& file, const std::filesystem::path& filepath, uint64_t key, CookedTextureHeader& header)
+	{
+		if (!file.IsOpen() || file.GetSize() < sizeof(CookedTextureHeader))
+			return false;
+
+		memcpy(&header, file.GetData(), sizeof(CookedTextureHeader));
+		if (header.Magic != CookedTextureHeader::CurrentMagic || header.Version != CookedTextureHeader::CurrentVersion || (key && header.Key != key))
+		{
+			PC_CORE_INFO("Cooked texture {} is out of date", filepath.string());
+			return false;
+		}
+
+		size_t size = sizeof(CookedTextureHeader);
+		for (uint32_t level = 0; level < header.MipCount; level++)
+			size += GetLevelSize(header.Format, std::max(header.Width >> level, 1u), std::max(header.Height >> level, 1u));
+		if (header.MipCount == 0 || file.GetSize() != size)
+		{
+			PC_CORE_WARN("Cooked texture {} is corrupt", filepath.string());
+			return false;
+		}
+
+		return true;
+	}
+
+	uint32_t TextureCooker::GetMipCount(uint32_t width, uint32_t height)
+	{
+		uint32_t count = 1;
+		while (width > 1 || height > 1)
+		{
+			width = std::max(width / 2, 1u);
+			height = std::max(height / 2, 1u);
+			count++;
+		}
+		return count;
+	}
+
+	size_t TextureCooker::GetLevelSize(CookedTextureFormat format, uint32_t width, uint32_t height)
+	{
+		switch (format)
+		{
+		case CookedTextureFormat::RGB8:		return (size_t)width * height * 3;
+		case CookedTextureFormat::RGBA8:	return (size_t)width * height * 4;
+		case CookedTextureFormat::BC1:		return (size_t)((width + 3) / 4) * ((height + 3) / 4) * 8;
+		case CookedTextureFormat::BC3:		return (size_t)((width + 3) / 4) * ((height + 3) / 4) * 16;
+		}
+
+		PC_CORE_ASSERT(false);
+		return 0;
+	}
+}
\ No newline at end of file
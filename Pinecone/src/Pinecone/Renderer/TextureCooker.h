@@ -0,0 +1,122 @@
+#pragma once
+
+#include <filesystem>
+
+namespace Pinecone
+{
+	class MappedFile;
+
+	/// <summary>
+	/// The pixel format of a cooked texture
+	/// </summary>
+	enum class CookedTextureFormat : uint32_t
+	{
+		RGB8 = 0,
+		RGBA8,
+		BC1, // 4x4 blocks of 8 bytes, RGB without alpha
+		BC3  // 4x4 blocks of 16 bytes, RGB with interpolated alpha
+	};
+
+	/// <summary>
+	/// The start of a cooked texture (.pctex) file. It is followed by every mip level from the largest to
+	/// the smallest, tightly packed with no padding between rows or levels. The rows are already flipped
+	/// so that the first row is the bottom of the image, the order OpenGL expects
+	/// </summary>
+	struct CookedTextureHeader
+	{
+		// Bump the version whenever the layout of the file changes
+		static const uint32_t CurrentMagic = 0x58544350; // "PCTX"
+		static const uint32_t CurrentVersion = 1;
+
+		uint32_t Magic;
+		uint32_t Version;
+		uint64_t Key; // Identifies the source file and settings the texture was cooked from
+		uint32_t Width;
+		uint32_t Height;
+		CookedTextureFormat Format;
+		uint32_t MipCount;
+		uint32_t Flags; // No flags are defined yet, always 0
+		uint32_t Reserved;
+	};
+
+	/// <summary>
+	/// How a texture is cooked
+	/// </summary>
+	struct TextureCookSettings
+	{
+		// Store every mip level down to 1x1
+		bool GenerateMips = true;
+		// Block compress the pixels, BC1 for images without alpha and BC3 for images with alpha.
+		// Only images with a width and height that are multiples of 4 are compressed
+		bool Compress = false;
+	};
+
+	/// <summary>
+	/// Turns image files into cooked textures which can be uploaded straight from a memory mapped file,
+	/// with no decoding, flipping or mip generation left to do at load time
+	/// </summary>
+	class TextureCooker
+	{
+	public:
+		/// <summary>
+		/// Decode an image file and write it as a cooked texture
+		/// </summary>
+		/// <param name="source">The file path to the image file</param>
+		/// <param name="destination">The file path to write the cooked texture to</param>
+		/// <param name="settings">How the texture is cooked</param>
+		/// <param name="key">The key stored in the header, used to tell if the cooked texture is out of date</param>
+		/// <returns>True if the cooked texture was written</returns>
+		static bool Cook(const std::filesystem::path& source, const std::filesystem::path& destination, const TextureCookSettings& settings, uint64_t key = 0);
+		/// <summary>
+		/// Get the key a texture is cooked with. It changes whenever the source file is modified or
+		/// the settings change, without having to read the source file
+		/// </summary>
+		/// <param name="source">The file path to the image file</param>
+		/// <param name="settings">How the texture is cooked</param>
+		/// <returns>The key, 0 if the source file does not exist</returns>
+		static uint64_t GetKey(const std::filesystem::path& source, const TextureCookSettings& settings);
+		/// <summary>
+		/// Get the file name to cook a texture to in a cache directory. The name holds a hash of the path
+		/// of the source file and of the settings, so textures with the same file name in different folders,
+		/// or one texture cooked with different settings, do not overwrite each other
+		/// </summary>
+		/// <param name="source">The file path to the image file</param>
+		/// <param name="settings">How the texture is cooked</param>
+		/// <returns>The file name of the cooked texture</returns>
+		static std::filesystem::path GetCacheName(const std::filesystem::path& source, const TextureCookSettings& settings);
+		/// <summary>
+		/// Get the header a texture will be cooked with, reading only the header of the image file
+		/// </summary>
+		/// <param name="source">The file path to the image file</param>
+		/// <param name="settings">How the texture is cooked</param>
+		/// <param name="key">The key stored in the header</param>
+		/// <param name="header">The header, set if the image file could be read</param>
+		/// <returns>True if the image file could be read</returns>
+		static bool GetHeader(const std::filesystem::path& source, const TextureCookSettings& settings, uint64_t key, CookedTextureHeader& header);
+		/// <summary>
+		/// Read the header of a cooked texture and check that it is up to date and holds every mip level
+		/// </summary>
+		/// <param name="file">The mapped cooked texture</param>
+		/// <param name="filepath">The file path to the cooked texture</param>
+		/// <param name="key">The key the cooked texture must have been cooked with, 0 to accept any key</param>
+		/// <param name="header">The header, set if the cooked texture can be used</param>
+		/// <returns>True if the cooked texture can be used, false if the file is missing, out of date or corrupt</returns>
+		static bool ReadHeader(const MappedFile& file, const std::filesystem::path& filepath, uint64_t key, CookedTextureHeader& header);
+
+		/// <summary>
+		/// Get the number of mip levels of a full mip chain, down to 1x1
+		/// </summary>
+		/// <param name="width">The width of the largest level</param>
+		/// <param name="height">The height of the largest level</param>
+		/// <returns>The number of mip levels</returns>
+		static uint32_t GetMipCount(uint32_t width, uint32_t height);
+		/// <summary>
+		/// Get the size of one mip level in a cooked texture
+		/// </summary>
+		/// <param name="format">The format of the texture</param>
+		/// <param name="width">The width of the level</param>
+		/// <param name="height">The height of the level</param>
+		/// <returns>The size of the level in bytes</returns>
+		static size_t GetLevelSize(CookedTextureFormat format, uint32_t width, uint32_t height);
+	};
+}
\ No newline at end of file
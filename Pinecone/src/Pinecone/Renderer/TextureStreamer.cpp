@@ -0,0 +1,390 @@
+#include "pcpch.h"
+#include "TextureStreamer.h"
+
+#include "Pinecone/Core/JobSystem.h"
+#include "Pinecone/Core/MappedFile.h"
+
+#include <deque>
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+namespace Pinecone
+{
+	/// <summary>
+	/// The mip levels of a texture loaded on a worker thread, waiting to be uploaded. They are either read
+	/// from a mapped cooked texture, or are the largest level decoded from an image that could not be cooked
+	/// </summary>
+	struct StreamedImage
+	{
+		// The texture is not kept alive by its upload, if it is destroyed first the levels are dropped
+		std::weak_ptr<Texture2D> Texture;
+		CookedTextureFormat Format = CookedTextureFormat::RGBA8;
+		Ref<MappedFile> File;
+		stbi_uc* Pixels = nullptr;
+		// The levels are uploaded from the smallest to the largest, so the texture sharpens as they arrive
+		uint32_t MipCount = 1;
+		uint32_t Level = 0;
+		const uint8_t* LevelData = nullptr;
+		uint32_t RowsUploaded = 0;
+	};
+
+	struct TextureStreamerData
+	{
+		static const uint32_t SegmentCount = 3;
+
+		// Filled by the workers, moved over to the upload queue by the main thread
+		std::mutex LoadedMutex;
+		std::vector<StreamedImage> Loaded;
+		bool Running = false;
+		std::atomic<uint32_t> PendingCount = 0;
+
+		// Only touched by the main thread
+		std::deque<StreamedImage> Uploads;
+		uint32_t UploadedBytes = 0;
+
+		// The pixel buffer ring, every segment holds the pixels of one frame and is fenced
+		// until the texture uploads reading from it have finished
+		uint32_t UploadBudget = 0;
+		uint32_t BufferID = 0;
+		uint8_t* MappedData = nullptr;
+		GLsync SegmentFences[SegmentCount] = {};
+		uint32_t SegmentIndex = 0;
+	};
+
+	static TextureStreamerData s_Data;
+
+	static bool IsCompressed(CookedTextureFormat format)
+	{
+		return format == CookedTextureFormat::BC1 || format == CookedTextureFormat::BC3;
+	}
+
+	/// <summary>
+	/// Map a cooked texture and check that it fits the storage of the texture it is loaded into
+	/// </summary>
+	/// <param name="filepath">The file path to the cooked texture</param>
+	/// <param name="key">The key the cooked texture must have been cooked with, 0 to accept any key</param>
+	/// <param name="storage">The size, format and mip level count of the texture storage</param>
+	/// <returns>The mapped cooked texture, null if it can not be used</returns>
+	static Ref<MappedFile> MapCookedTexture(const std::filesystem::path& filepath, uint64_t key, const CookedTextureHeader& storage)
+	{
+		Ref<MappedFile> file = CreateRef<MappedFile>(filepath);
+		CookedTextureHeader header;
+		if (!TextureCooker::ReadHeader(*file, filepath, key, header))
+			return nullptr;
+
+		if (header.Width != storage.Width || header.Height != storage.Height || header.Format != storage.Format || header.MipCount != storage.MipCount)
+		{
+			PC_CORE_WARN("Cooked texture {} does not match the texture it is loaded into", filepath.string());
+			return nullptr;
+		}
+
+		return file;
+	}
+
+	/// <summary>
+	/// Hand a loaded image over to the main thread, or free it if the TextureStreamer has been shut down
+	/// </summary>
+	/// <param name="image">The loaded image, without a file or pixels if it failed to load</param>
+	static void PushLoaded(StreamedImage&& image)
+	{
+		std::lock_guard<std::mutex> lock(s_Data.LoadedMutex);
+		if ((image.File || image.Pixels) && s_Data.Running)
+		{
+			s_Data.Loaded.push_back(std::move(image));
+			return;
+		}
+
+		stbi_image_free(image.Pixels);
+		if (s_Data.Running)
+			s_Data.PendingCount--;
+	}
+
+	void TextureStreamer::Init(uint32_t uploadBudget)
+	{
+		PC_PROFILE_FUNCTION();
+
+		s_Data.UploadBudget = uploadBudget;
+		CreateBuffer();
+
+		std::lock_guard<std::mutex> lock(s_Data.LoadedMutex);
+		s_Data.Running = true;
+	}
+
+	void TextureStreamer::Shutdown()
+	{
+		PC_PROFILE_FUNCTION();
+
+		{
+			// Workers that finish loading from now on free their images themselves
+			std::lock_guard<std::mutex> lock(s_Data.LoadedMutex);
+			s_Data.Running = false;
+			for (StreamedImage& image : s_Data.Loaded)
+				stbi_image_free(image.Pixels);
+			s_Data.Loaded.clear();
+		}
+
+		for (StreamedImage& image : s_Data.Uploads)
+			stbi_image_free(image.Pixels);
+		s_Data.Uploads.clear();
+		s_Data.PendingCount = 0;
+
+		DestroyBuffer();
+	}
+
+	void TextureStreamer::Update()
+	{
+		PC_PROFILE_FUNCTION();
+
+		s_Data.UploadedBytes = 0;
+
+		{
+			std::lock_guard<std::mutex> lock(s_Data.LoadedMutex);
+			for (StreamedImage& image : s_Data.Loaded)
+				s_Data.Uploads.push_back(std::move(image));
+			s_Data.Loaded.clear();
+		}
+
+		if (s_Data.Uploads.empty() || !s_Data.MappedData)
+			return;
+
+		// If the GPU has not finished copying out of this segment yet, try again next frame
+		// instead of stalling the main thread
+		GLsync& fence = s_Data.SegmentFences[s_Data.SegmentIndex];
+		if (fence)
+		{
+			GLenum result = glClientWaitSync(fence, 0, 0);
+			if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+				return;
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+
+		const uint32_t segmentOffset = s_Data.SegmentIndex * s_Data.UploadBudget;
+		uint8_t* segment = s_Data.MappedData + segmentOffset;
+		uint32_t used = 0;
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, s_Data.BufferID);
+		// Rows of RGB data are not always 4 byte aligned, so tell OpenGL they are tightly packed
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		while (!s_Data.Uploads.empty())
+		{
+			StreamedImage& image = s_Data.Uploads.front();
+			Ref<Texture2D> texture = image.Texture.lock();
+
+			if (texture)
+			{
+				// Block compressed levels are uploaded one row of 4x4 blocks at a time
+				const uint32_t width = std::max(texture->m_Width >> image.Level, 1u);
+				const uint32_t height = std::max(texture->m_Height >> image.Level, 1u);
+				const uint32_t rowHeight = IsCompressed(image.Format) ? 4 : 1;
+				const uint32_t rowCount = (height + rowHeight - 1) / rowHeight;
+				const uint32_t rowSize = (uint32_t)TextureCooker::GetLevelSize(image.Format, width, 1);
+				const uint8_t* rowData = image.LevelData + (size_t)image.RowsUploaded * rowSize;
+
+				uint32_t rows = std::min(rowCount - image.RowsUploaded, (s_Data.UploadBudget - used) / rowSize);
+				if (rows == 0)
+				{
+					// The budget of this frame is used up
+					if (used > 0)
+						break;
+
+					// A single row is larger than the whole budget, so upload the rest of the level
+					// straight from memory instead of through the pixel buffer
+					rows = rowCount - image.RowsUploaded;
+					glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+					UploadRows(*texture, image.Level, image.Format, image.RowsUploaded * rowHeight, rows * rowHeight, rows * rowSize, rowData);
+					glBindBuffer(GL_PIXEL_UNPACK_BUFFER, s_Data.BufferID);
+				}
+				else
+				{
+					memcpy(segment + used, rowData, (size_t)rows * rowSize);
+					// With a pixel buffer bound the data pointer is an offset into the buffer
+					UploadRows(*texture, image.Level, image.Format, image.RowsUploaded * rowHeight, rows * rowHeight, rows * rowSize,
+						(const void*)(uintptr_t)(segmentOffset + used));
+					used += rows * rowSize;
+				}
+
+				s_Data.UploadedBytes += rows * rowSize;
+				image.RowsUploaded += rows;
+				if (image.RowsUploaded < rowCount)
+					continue;
+
+				if (image.Level > 0)
+				{
+					// Sample the finished level while the larger ones are still on the way
+					glTextureParameteri(texture->m_RendererID, GL_TEXTURE_BASE_LEVEL, image.Level);
+					image.Level--;
+					image.LevelData -= TextureCooker::GetLevelSize(image.Format, std::max(texture->m_Width >> image.Level, 1u), std::max(texture->m_Height >> image.Level, 1u));
+					image.RowsUploaded = 0;
+					continue;
+				}
+
+				// Decoded images only have their largest level, the mips are made once from the whole
+				// image rather than after every band of rows
+				if (image.MipCount < texture->m_MipCount)
+					glGenerateTextureMipmap(texture->m_RendererID);
+				glTextureParameteri(texture->m_RendererID, GL_TEXTURE_BASE_LEVEL, 0);
+				texture->m_IsLoaded = true;
+			}
+
+			stbi_image_free(image.Pixels);
+			s_Data.Uploads.pop_front();
+			s_Data.PendingCount--;
+		}
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		if (used > 0)
+		{
+			fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			s_Data.SegmentIndex = (s_Data.SegmentIndex + 1) % TextureStreamerData::SegmentCount;
+		}
+	}
+
+	void TextureStreamer::Load(const Ref<Texture2D>& texture, CookedTextureFormat format, const std::filesystem::path& cookedPath,
+		const std::string& source, const TextureCookSettings& settings, uint64_t key)
+	{
+		PC_PROFILE_FUNCTION();
+
+		s_Data.PendingCount++;
+
+		// The cooked texture has to have the same layout as the storage the texture was made with
+		CookedTextureHeader storage = {};
+		storage.Width = texture->m_Width;
+		storage.Height = texture->m_Height;
+		storage.Format = format;
+		storage.MipCount = texture->m_MipCount;
+		std::weak_ptr<Texture2D> weakTexture = texture;
+
+		JobSystem::Schedule([weakTexture, storage, cookedPath, source, settings, key]()
+			{
+				PC_PROFILE_SCOPE("TextureStreamer Load");
+
+				StreamedImage image;
+				image.Texture = weakTexture;
+				image.Format = storage.Format;
+
+				image.File = MapCookedTexture(cookedPath, key, storage);
+				if (!image.File && !source.empty() && TextureCooker::Cook(source, cookedPath, settings, key))
+					image.File = MapCookedTexture(cookedPath, key, storage);
+
+				if (image.File)
+				{
+					image.MipCount = storage.MipCount;
+					image.Level = storage.MipCount - 1;
+					image.LevelData = image.File->GetData() + sizeof(CookedTextureHeader);
+					for (uint32_t level = 0; level < image.Level; level++)
+						image.LevelData += TextureCooker::GetLevelSize(storage.Format, std::max(storage.Width >> level, 1u), std::max(storage.Height >> level, 1u));
+
+					// Read every page of the file here, so the main thread does not wait on the disk while it copies the levels
+					const uint8_t* data = image.File->GetData();
+					volatile uint8_t touched = 0;
+					for (size_t offset = 0; offset < image.File->GetSize(); offset += 4096)
+						touched += data[offset];
+				}
+				else if (!source.empty() && !IsCompressed(storage.Format))
+				{
+					// The cooked texture could not be written, so decode the largest level from the image itself.
+					// The flip flag is per thread so that workers do not race the main thread setting it
+					stbi_set_flip_vertically_on_load_thread(1);
+
+					const int channels = storage.Format == CookedTextureFormat::RGB8 ? 3 : 4;
+					int width, height, fileChannels;
+					image.Pixels = stbi_load(source.c_str(), &width, &height, &fileChannels, channels);
+					if (image.Pixels && ((uint32_t)width != storage.Width || (uint32_t)height != storage.Height))
+					{
+						stbi_image_free(image.Pixels);
+						image.Pixels = nullptr;
+					}
+					image.LevelData = image.Pixels;
+				}
+
+				if (!image.File && !image.Pixels)
+					PC_CORE_ERROR("Failed to load texture: {}", source.empty() ? cookedPath.string() : source);
+
+				PushLoaded(std::move(image));
+			});
+	}
+
+	void TextureStreamer::SetUploadBudget(uint32_t uploadBudget)
+	{
+		PC_PROFILE_FUNCTION();
+
+		if (uploadBudget == s_Data.UploadBudget)
+			return;
+
+		DestroyBuffer();
+		s_Data.UploadBudget = uploadBudget;
+		CreateBuffer();
+	}
+
+	uint32_t TextureStreamer::GetUploadBudget()
+	{
+		return s_Data.UploadBudget;
+	}
+
+	uint32_t TextureStreamer::GetPendingCount()
+	{
+		return s_Data.PendingCount;
+	}
+
+	uint32_t TextureStreamer::GetUploadedBytes()
+	{
+		return s_Data.UploadedBytes;
+	}
+
+	void TextureStreamer::UploadRows(Texture2D& texture, uint32_t level, CookedTextureFormat format, uint32_t y, uint32_t height, uint32_t size, const void* data)
+	{
+		// The last row of blocks of a compressed level can reach past the bottom of the level
+		const uint32_t width = std::max(texture.m_Width >> level, 1u);
+		height = std::min(height, std::max(texture.m_Height >> level, 1u) - y);
+
+		if (IsCompressed(format))
+			glCompressedTextureSubImage2D(texture.m_RendererID, level, 0, y, width, height, texture.m_InternalFormat, size, data);
+		else
+			glTextureSubImage2D(texture.m_RendererID, level, 0, y, width, height, texture.m_DataFormat, GL_UNSIGNED_BYTE, data);
+	}
+
+	void TextureStreamer::CreateBuffer()
+	{
+		PC_PROFILE_FUNCTION();
+
+		PC_CORE_ASSERT(s_Data.UploadBudget > 0, "Upload budget must be larger than 0!");
+
+		glCreateBuffers(1, &s_Data.BufferID);
+
+		// Coherent mapping means our writes become visible to the GPU without having to flush them
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		GLsizeiptr totalSize = (GLsizeiptr)s_Data.UploadBudget * TextureStreamerData::SegmentCount;
+		glNamedBufferStorage(s_Data.BufferID, totalSize, nullptr, flags);
+		s_Data.MappedData = (uint8_t*)glMapNamedBufferRange(s_Data.BufferID, 0, totalSize, flags);
+		PC_CORE_ASSERT(s_Data.MappedData, "Failed to map texture upload buffer!");
+
+		s_Data.SegmentIndex = 0;
+	}
+
+	void TextureStreamer::DestroyBuffer()
+	{
+		PC_PROFILE_FUNCTION();
+
+		if (!s_Data.BufferID)
+			return;
+
+		// The buffer is only deleted once the GPU is done with it, so the pending copies out of it
+		// still finish, the fences are not needed anymore
+		for (GLsync& fence : s_Data.SegmentFences)
+		{
+			if (fence)
+				glDeleteSync(fence);
+			fence = nullptr;
+		}
+
+		glUnmapNamedBuffer(s_Data.BufferID);
+		glDeleteBuffers(1, &s_Data.BufferID);
+		s_Data.BufferID = 0;
+		s_Data.MappedData = nullptr;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Pinecone/Renderer/Texture2D.h"
+#include "Pinecone/Renderer/TextureCooker.h"
+
+namespace Pinecone
+{
+	/// <summary>
+	/// Loads textures in the background for Texture2D::CreateAsync. The mip levels are read from memory
+	/// mapped cooked textures, images that have not been cooked yet are cooked by the JobSystem workers
+	/// first. The levels are copied to the GPU on the main thread through a persistently mapped pixel
+	/// buffer ring, a limited number of bytes each frame so that loading many textures never stalls a
+	/// frame. Levels larger than the budget are uploaded a few rows at a time over several frames
+	/// </summary>
+	class TextureStreamer
+	{
+	public:
+		/// <summary>
+		/// Initialize the TextureStreamer
+		/// </summary>
+		/// <param name="uploadBudget">The most bytes of pixels to upload each frame</param>
+		static void Init(uint32_t uploadBudget = 8 * 1024 * 1024);
+		/// <summary>
+		/// Shutdown the TextureStreamer, dropping the textures that have not been uploaded yet
+		/// </summary>
+		static void Shutdown();
+
+		/// <summary>
+		/// Upload the loaded textures, up to the upload budget. Call this once per frame
+		/// </summary>
+		static void Update();
+
+		/// <summary>
+		/// Start loading the mip levels of a texture made by Texture2D::CreateAsync from a cooked texture.
+		/// If the cooked texture is missing or out of date the image is cooked again, if it can not be
+		/// cooked an uncompressed texture is decoded from the image instead and has its mips made on the GPU
+		/// </summary>
+		/// <param name="texture">The texture, its storage must already match the cooked texture</param>
+		/// <param name="format">The format of the cooked texture</param>
+		/// <param name="cookedPath">The file path to the cooked texture</param>
+		/// <param name="source">The file path to the image file the texture is cooked from, empty if there is none</param>
+		/// <param name="settings">How the texture is cooked</param>
+		/// <param name="key">The key the cooked texture must have been cooked with, 0 to accept any key</param>
+		static void Load(const Ref<Texture2D>& texture, CookedTextureFormat format, const std::filesystem::path& cookedPath,
+			const std::string& source, const TextureCookSettings& settings, uint64_t key);
+
+		/// <summary>
+		/// Set the most bytes of pixels to upload each frame
+		/// </summary>
+		/// <param name="uploadBudget">The upload budget in bytes</param>
+		static void SetUploadBudget(uint32_t uploadBudget);
+		/// <summary>
+		/// Get the most bytes of pixels uploaded each frame
+		/// </summary>
+		/// <returns>The upload budget in bytes</returns>
+		static uint32_t GetUploadBudget();
+
+		/// <summary>
+		/// Get the number of textures that are still being decoded or uploaded
+		/// </summary>
+		/// <returns>The number of textures left to load</returns>
+		static uint32_t GetPendingCount();
+		/// <summary>
+		/// Get the number of bytes uploaded by the last update
+		/// </summary>
+		/// <returns>The number of bytes uploaded</returns>
+		static uint32_t GetUploadedBytes();
+	private:
+		/// <summary>
+		/// Upload rows of one mip level of a texture
+		/// </summary>
+		/// <param name="texture">The texture</param>
+		/// <param name="level">The mip level</param>
+		/// <param name="format">The format of the pixels</param>
+		/// <param name="y">The first row (in pixels)</param>
+		/// <param name="height">The number of rows (in pixels), clamped to the bottom of the level</param>
+		/// <param name="size">The size of the pixels in bytes</param>
+		/// <param name="data">The pixels, or an offset into the bound pixel buffer</param>
+		static void UploadRows(Texture2D& texture, uint32_t level, CookedTextureFormat format, uint32_t y, uint32_t height, uint32_t size, const void* data);
+		/// <summary>
+		/// Create the pixel buffer ring with one segment of the upload budget per frame in flight
+		/// </summary>
+		static void CreateBuffer();
+		/// <summary>
+		/// Unmap and delete the pixel buffer ring
+		/// </summary>
+		static void DestroyBuffer();
+	};
+}
\ No newline at end of file
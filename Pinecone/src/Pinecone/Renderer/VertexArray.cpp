@@ -67,7 +67,7 @@ namespace Pinecone
 		glBindVertexArray(0);
 	}
 
-	void VertexArray::AddVertexBuffer(const Ref<VertexBuffer>& vertexBuffer)
+	void VertexArray::AddVertexBuffer(const Ref<VertexBuffer>& vertexBuffer, bool instanced)
 	{
 		PC_PROFILE_FUNCTION();
 
@@ -79,6 +79,9 @@ namespace Pinecone
 		glBindVertexArray(m_RendererID);
 		vertexBuffer->Bind();
 
+		// Instanced vertex data only advances to the next element once per instance
+		GLuint divisor = instanced ? 1 : 0;
+
 		// Get the buffer layout and pass the layout data to OpenGL
 		const auto& layout = vertexBuffer->GetLayout();
 		for (const auto& element : layout)
@@ -97,6 +100,7 @@ namespace Pinecone
 					element.Normalized ? GL_TRUE : GL_FALSE,
 					layout.GetStride(),
 					(const void*)element.Offset);
+				glVertexAttribDivisor(m_VertexBufferIndex, divisor);
 				m_VertexBufferIndex++;
 				break;
 			}
@@ -112,6 +116,7 @@ namespace Pinecone
 					ShaderDataTypeToOpenGLBaseType(element.Type),
 					layout.GetStride(),
 					(const void*)element.Offset);
+				glVertexAttribDivisor(m_VertexBufferIndex, divisor);
 				m_VertexBufferIndex++;
 				break;
 			}
@@ -33,7 +33,8 @@ namespace Pinecone
 		/// the vertex data has a buffer layout.
 		/// </summary>
 		/// <param name="vertexBuffer">The vertex data to add</param>
-		void AddVertexBuffer(const Ref<VertexBuffer>& vertexBuffer);
+		/// <param name="instanced">If the vertex data advances once per instance instead of once per vertex</param>
+		void AddVertexBuffer(const Ref<VertexBuffer>& vertexBuffer, bool instanced = false);
 		/// <summary>
 		/// Set the index data for the vertex array
 		/// </summary>
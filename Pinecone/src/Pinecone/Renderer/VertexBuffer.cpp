@@ -29,10 +29,39 @@ namespace Pinecone
 		glBufferData(GL_ARRAY_BUFFER, size, vertices, GL_STATIC_DRAW);
 	}
 
+	VertexBuffer::VertexBuffer(uint32_t size, uint32_t segmentCount)
+		: m_SegmentSize(size), m_SegmentFences(segmentCount, nullptr)
+	{
+		PC_PROFILE_FUNCTION();
+
+		PC_CORE_ASSERT(segmentCount > 0, "A ring buffer needs at least one segment!");
+
+		// Create a new array buffer with immutable storage big enough for every segment
+		glCreateBuffers(1, &m_RendererID);
+		glBindBuffer(GL_ARRAY_BUFFER, m_RendererID);
+
+		// Coherent mapping means our writes become visible to the GPU without having to flush them
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		GLsizeiptr totalSize = (GLsizeiptr)size * segmentCount;
+		glNamedBufferStorage(m_RendererID, totalSize, nullptr, flags);
+		// Map the whole buffer once, it stays mapped until the vertex buffer is deleted
+		m_MappedData = (uint8_t*)glMapNamedBufferRange(m_RendererID, 0, totalSize, flags);
+		PC_CORE_ASSERT(m_MappedData, "Failed to map persistent vertex buffer!");
+	}
+
 	VertexBuffer::~VertexBuffer()
 	{
 		PC_PROFILE_FUNCTION();
 
+		// Release any fences still guarding the ring segments and unmap the buffer
+		for (GLsync fence : m_SegmentFences)
+		{
+			if (fence)
+				glDeleteSync(fence);
+		}
+		if (m_MappedData)
+			glUnmapNamedBuffer(m_RendererID);
+
 		// Delete the vertex buffer
 		glDeleteBuffers(1, &m_RendererID);
 	}
@@ -53,13 +82,51 @@ namespace Pinecone
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 	}
 
-	void VertexBuffer::SetData(const void* data, uint32_t size)
+	void VertexBuffer::SetData(const void* data, uint32_t size, uint32_t offset)
 	{
 		PC_PROFILE_FUNCTION();
 
 		// Bind the vertex buffer then set its data 
 		glBindBuffer(GL_ARRAY_BUFFER, m_RendererID);
-		glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
+		glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+	}
+
+	void* VertexBuffer::MapSegment()
+	{
+		PC_PROFILE_FUNCTION();
+
+		PC_CORE_ASSERT(m_MappedData, "Vertex buffer is not persistently mapped!");
+
+		// If the GPU has been given draw commands that read from this segment, wait until they
+		// have finished before handing the memory back to be written over
+		GLsync& fence = m_SegmentFences[m_SegmentIndex];
+		if (fence)
+		{
+			GLenum result = glClientWaitSync(fence, 0, 0);
+			while (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+			{
+				PC_CORE_ASSERT(result != GL_WAIT_FAILED, "Failed to wait on vertex buffer fence!");
+				if (result == GL_WAIT_FAILED)
+					break;
+				// Only flush once we actually have to block, then wait in 1ms steps
+				result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+			}
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+
+		return m_MappedData + GetSegmentOffset();
+	}
+
+	void VertexBuffer::CommitSegment()
+	{
+		PC_PROFILE_FUNCTION();
+
+		PC_CORE_ASSERT(m_MappedData, "Vertex buffer is not persistently mapped!");
+
+		// Fence the segment we just drew from and move on to the next segment in the ring
+		m_SegmentFences[m_SegmentIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		m_SegmentIndex = (m_SegmentIndex + 1) % (uint32_t)m_SegmentFences.size();
 	}
 
 	Ref<VertexBuffer> VertexBuffer::Create(uint32_t size)
@@ -70,4 +137,8 @@ namespace Pinecone
 	{
 		return CreateRef<VertexBuffer>(vertices, size);
 	}
+	Ref<VertexBuffer> VertexBuffer::CreatePersistent(uint32_t size, uint32_t segmentCount)
+	{
+		return CreateRef<VertexBuffer>(size, segmentCount);
+	}
 }
\ No newline at end of file
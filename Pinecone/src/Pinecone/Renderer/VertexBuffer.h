@@ -2,6 +2,8 @@
 
 #include "Pinecone/Renderer/Buffer.h"
 
+typedef struct __GLsync* GLsync;
+
 namespace Pinecone
 {
 	class VertexBuffer
@@ -24,6 +26,15 @@ namespace Pinecone
 		/// <param name="size">The size of the vertex data</param>
 		VertexBuffer(float* vertices, uint32_t size);
 		/// <summary>
+		/// The VertexBuffer constructor for a persistently mapped ring buffer. The buffer is
+		/// allocated as immutable storage of size * segmentCount bytes and stays mapped for its
+		/// whole lifetime. Each segment is written to directly by the CPU and fenced once the GPU
+		/// has been told to draw from it, so the CPU never writes to memory that is still in use.
+		/// </summary>
+		/// <param name="size">The size of a single segment of vertex data</param>
+		/// <param name="segmentCount">The number of segments in the ring (3 for triple buffering)</param>
+		VertexBuffer(uint32_t size, uint32_t segmentCount);
+		/// <summary>
 		/// The VertexBuffer deconstructor
 		/// </summary>
 		~VertexBuffer();
@@ -44,7 +55,31 @@ namespace Pinecone
 		/// </summary>
 		/// <param name="data">The vertex data</param>
 		/// <param name="size">The size of the vertex data</param>
-		void SetData(const void* data, uint32_t size) ;
+		/// <param name="offset">Where in the vertex buffer to start writing the data (in bytes)</param>
+		void SetData(const void* data, uint32_t size, uint32_t offset = 0);
+
+		/// <summary>
+		/// Get a pointer to the current segment of a persistently mapped ring buffer. If the GPU
+		/// may still be reading from this segment, this waits on its fence first.
+		/// </summary>
+		/// <returns>A write only pointer to the start of the current segment</returns>
+		void* MapSegment();
+		/// <summary>
+		/// Fence the current segment of a persistently mapped ring buffer and move on to the next.
+		/// Must be called after the draw commands that read from the segment have been issued.
+		/// </summary>
+		void CommitSegment();
+		/// <summary>
+		/// Get the offset (in bytes) of the current segment from the start of the buffer.
+		/// Divide this by the vertex size to get the base vertex to draw with.
+		/// </summary>
+		/// <returns>The offset of the current segment</returns>
+		uint32_t GetSegmentOffset() const { return m_SegmentIndex * m_SegmentSize; }
+		/// <summary>
+		/// Is the vertex buffer a persistently mapped ring buffer?
+		/// </summary>
+		/// <returns>True if the vertex buffer is persistently mapped</returns>
+		bool IsPersistent() const { return m_MappedData != nullptr; }
 
 		/// <summary>
 		/// Returns the layout of the vertex data
@@ -71,8 +106,21 @@ namespace Pinecone
 		/// <param name="size">The size of the vertex data</param>
 		/// <returns>A shared pointer to a new VertexBuffer</returns>
 		static Ref<VertexBuffer> Create(float* vertices, uint32_t size);
+		/// <summary>
+		/// Creates a smart shared pointer to a new persistently mapped ring VertexBuffer
+		/// </summary>
+		/// <param name="size">The size of a single segment of vertex data</param>
+		/// <param name="segmentCount">The number of segments in the ring</param>
+		/// <returns>A shared pointer to a new VertexBuffer</returns>
+		static Ref<VertexBuffer> CreatePersistent(uint32_t size, uint32_t segmentCount = 3);
 	private:
 		uint32_t m_RendererID;
 		BufferLayout m_Layout;
+
+		// Persistent ring buffer data, unused for regular vertex buffers
+		uint8_t* m_MappedData = nullptr;
+		uint32_t m_SegmentSize = 0;
+		uint32_t m_SegmentIndex = 0;
+		std::vector<GLsync> m_SegmentFences;
 	};
 }
\ No newline at end of file
@@ -1,8 +1,10 @@
 #pragma once
 
 #include "Pinecone/Core/UUID.h"
+#include "Pinecone/Asset/AssetHandle.h"
 #include "Pinecone/Scene/SceneCamera.h"
 #include "Pinecone/Renderer/Texture2D.h"
+#include "Pinecone/Renderer/SubTexture2D.h"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -10,6 +12,8 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/quaternion.hpp>
 
+#include <entt.hpp>
+
 namespace Pinecone
 {
 	struct IDComponent
@@ -36,6 +40,10 @@ namespace Pinecone
 		operator const std::string& () const { return Tag; }
 	};
 
+	// The transform matrix is cached and only built again after the transform changes. Change the fields with
+	// the setters or patch the component (GameObject::PatchComponent), which also lets the scene know so it moves
+	// the game object and its children. After changing the fields directly, call MarkDirty. The setters add the
+	// game object to the scenes list of changed transforms, so they must not be called from two threads at once
 	struct TransformComponent
 	{
 		glm::vec3 Translation = { 0.0f, 0.0f, 0.0f };
@@ -48,20 +56,89 @@ namespace Pinecone
 			: Translation(translation)
 		{}
 
-		glm::mat4 GetTransform() const
+		void SetTranslation(const glm::vec3& translation) { Translation = translation; MarkDirty(); }
+		void SetRotation(const glm::vec3& rotation) { Rotation = rotation; MarkDirty(); }
+		void SetScale(const glm::vec3& scale) { Scale = scale; MarkDirty(); }
+
+		// Rebuild the matrix the next time it is needed and let the scene know the transform changed,
+		// for when the fields were changed directly
+		void MarkDirty()
+		{
+			m_Dirty = true;
+			if (m_ChangedTransforms && !m_Queued)
+			{
+				m_Queued = true;
+				m_ChangedTransforms->push_back(m_Entity);
+			}
+		}
+		bool IsDirty() const { return m_Dirty; }
+
+		// The transform relative to the parent of the game object
+		const glm::mat4& GetTransform() const
+		{
+			if (m_Dirty)
+				UpdateTransform();
+			return m_Transform;
+		}
+		// The transform in the world, including the transforms of every parent of the game object.
+		// Game objects with a parent get it from the scenes transform update pass
+		const glm::mat4& GetWorldTransform() const
+		{
+			return m_HasParent ? m_WorldTransform : GetTransform();
+		}
+
+		void UpdateTransform() const
 		{
 			glm::mat4 rotation = glm::toMat4(glm::quat(Rotation));
 
-			return glm::translate(glm::mat4(1.0f), Translation)
+			m_Transform = glm::translate(glm::mat4(1.0f), Translation)
 				* rotation
 				* glm::scale(glm::mat4(1.0f), Scale);
+			m_Dirty = false;
 		}
+	private:
+		mutable glm::mat4 m_Transform = glm::mat4(1.0f);
+		mutable bool m_Dirty = true;
+		// Set while the game object is in the scenes list of changed transforms, so it is only added once
+		bool m_Queued = false;
+		// The scenes list of changed transforms and the game object, set by the scene when the component is added
+		std::vector<entt::entity>* m_ChangedTransforms = nullptr;
+		entt::entity m_Entity = entt::null;
+
+		glm::mat4 m_WorldTransform = glm::mat4(1.0f);
+		bool m_HasParent = false;
+
+		friend class Scene;
+	};
+
+	// Links a game object to its parent and children. Managed by the scene, use GameObject::SetParent
+	// to change it. Only game objects that have been part of a hierarchy have this component
+	struct RelationshipComponent
+	{
+		entt::entity Parent = entt::null;
+		entt::entity FirstChild = entt::null;
+		entt::entity PrevSibling = entt::null;
+		entt::entity NextSibling = entt::null;
+		uint32_t ChildCount = 0;
+		// The number of parents above the game object, 0 for a root
+		uint32_t Depth = 0;
+
+		RelationshipComponent() = default;
+		RelationshipComponent(const RelationshipComponent&) = default;
+	private:
+		// The position of the game object in the scenes flattened hierarchy
+		uint32_t m_Index = 0;
+
+		friend class Scene;
 	};
 
 	struct SpriteComponent
 	{
 		glm::vec4 Color{ 1.0f, 1.0f, 1.0f, 1.0f };
-		Ref<Texture2D> Texture;
+		// A texture owned by the AssetManager, the sprite does not hold a reference to it
+		TextureHandle Texture;
+		// A region of a texture atlas to draw instead of the texture. Sprites that share an atlas page draw together
+		Ref<SubTexture2D> SubTexture;
 		float TilingFactor = 1.0f;
 		glm::vec2 FlipAxies = { 0.0f, 0.0f };
 
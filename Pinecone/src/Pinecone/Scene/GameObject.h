@@ -52,6 +52,21 @@ namespace Pinecone
 			return m_Scene->m_Registry.get<T>(m_EntityHandle);
 		}
 
+		/// <summary>
+		/// Change a component with a function. Unlike changing the reference returned by GetComponent,
+		/// this lets the scene know that the component changed. Transforms should be changed this way or
+		/// with their setters, and sprites this way while the scene keeps its sprites on the GPU
+		/// </summary>
+		/// <typeparam name="T">The component type</typeparam>
+		/// <param name="func">A function that takes a reference to the component and changes it</param>
+		/// <returns>A reference to the component</returns>
+		template<typename T, typename Func>
+		T& PatchComponent(Func&& func)
+		{
+			PC_CORE_ASSERT(HasComponent<T>(), "GameObject does not have component!");
+			return m_Scene->m_Registry.patch<T>(m_EntityHandle, std::forward<Func>(func));
+		}
+
 		/// <summary>
 		/// Check if the game object has a component
 		/// </summary>
@@ -98,6 +113,22 @@ namespace Pinecone
 		/// <returns>Returns the game objects name (tag)</returns>
 		const std::string& GetName() { return GetComponent<TagComponent>().Tag; }
 
+		/// <summary>
+		/// Make the game object a child of another, so it moves with its parent
+		/// </summary>
+		/// <param name="parent">The new parent, or a null game object to make this a root again</param>
+		void SetParent(GameObject parent) { m_Scene->SetParent(*this, parent); }
+		/// <summary>
+		/// Gets the parent of the game object
+		/// </summary>
+		/// <returns>The parent, a null game object if there is none</returns>
+		GameObject GetParent() { return m_Scene->GetParent(*this); }
+		/// <summary>
+		/// Gets the children of the game object
+		/// </summary>
+		/// <returns>The child game objects</returns>
+		std::vector<GameObject> GetChildren() { return m_Scene->GetChildren(*this); }
+
 		/// <summary>
 		/// Checks if the GameObject is the same as another. Does this by checking if the entity handle and the
 		/// scene it was created in of both objects are the same.
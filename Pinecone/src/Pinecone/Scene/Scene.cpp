@@ -1,6 +1,7 @@
 #include "pcpch.h"
 #include "Scene.h"
 
+#include "Pinecone/Core/JobSystem.h"
 #include "Pinecone/Renderer/Renderer2D.h"
 #include "Pinecone/Scene/GameObject.h"
 #include "Pinecone/Scene/Components.h"
@@ -8,6 +9,121 @@
 
 namespace Pinecone
 {
+	/// <summary>
+	/// The visible region of a camera in world space, as the 6 planes of its view frustum. Each plane
+	/// is normalized and points inwards, so a positive distance is on the visible side
+	/// </summary>
+	struct CameraFrustum
+	{
+		std::array<glm::vec4, 6> Planes;
+	};
+
+	/// <summary>
+	/// Get the frustum of a camera from its view projection matrix
+	/// </summary>
+	/// <param name="viewProjection">The projection of the camera multiplied by the inverse of its transform</param>
+	/// <returns>The camera frustum</returns>
+	static CameraFrustum ExtractFrustum(const glm::mat4& viewProjection)
+	{
+		// A point is visible when every clip space coordinate is within -w and w, each of those
+		// 6 tests is a plane made from the rows of the view projection matrix
+		const glm::vec4 row0 = { viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0] };
+		const glm::vec4 row1 = { viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1] };
+		const glm::vec4 row2 = { viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2] };
+		const glm::vec4 row3 = { viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3] };
+
+		CameraFrustum frustum;
+		frustum.Planes = { row3 + row0, row3 - row0, row3 + row1, row3 - row1, row3 + row2, row3 - row2 };
+		for (glm::vec4& plane : frustum.Planes)
+			plane /= glm::length(glm::vec3(plane));
+		return frustum;
+	}
+
+	/// <summary>
+	/// Check if a sphere is at least partly inside a camera frustum
+	/// </summary>
+	/// <param name="frustum">The camera frustum</param>
+	/// <param name="center">The center of the sphere</param>
+	/// <param name="radius">The radius of the sphere</param>
+	/// <returns>False if the sphere is completely outside of the frustum</returns>
+	static bool IsSphereVisible(const CameraFrustum& frustum, const glm::vec3& center, float radius)
+	{
+		for (const glm::vec4& plane : frustum.Planes)
+		{
+			if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+				return false;
+		}
+		return true;
+	}
+
+	// The number of transforms each job rebuilds, fewer than this are rebuilt on the calling thread
+	static const uint32_t s_TransformBatchSize = 1024;
+
+	/// <summary>
+	/// Get the bounds of a transform on the x and y axes, the box around its transformed unit quad
+	/// </summary>
+	static void GetTransformBounds(const glm::mat4& matrix, glm::vec2& min, glm::vec2& max)
+	{
+		// The quad is centered on the translation. On each axis its corners are at most half of the
+		// absolute x axis plus half of the absolute y axis of the transform away from the center
+		const glm::vec2 extents = 0.5f * (glm::abs(glm::vec2(matrix[0])) + glm::abs(glm::vec2(matrix[1])));
+		const glm::vec2 center = glm::vec2(matrix[3]);
+		min = center - extents;
+		max = center + extents;
+	}
+
+	/// <summary>
+	/// Get the box on the x and y axes around everything a camera can see
+	/// </summary>
+	/// <param name="viewProjection">The projection of the camera multiplied by the inverse of its transform</param>
+	static void GetViewBounds(const glm::mat4& viewProjection, glm::vec2& min, glm::vec2& max)
+	{
+		const glm::mat4 inverse = glm::inverse(viewProjection);
+		min = glm::vec2(std::numeric_limits<float>::max());
+		max = glm::vec2(std::numeric_limits<float>::lowest());
+		// Transform the 8 corners of clip space back into the world
+		for (uint32_t i = 0; i < 8; i++)
+		{
+			const glm::vec4 corner = inverse * glm::vec4(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, i & 4 ? 1.0f : -1.0f, 1.0f);
+			const glm::vec2 position = glm::vec2(corner) / corner.w;
+			min = glm::min(min, position);
+			max = glm::max(max, position);
+		}
+	}
+
+	/// <summary>
+	/// Get a game object and all of its children, their children and so on. Parents come before their children
+	/// </summary>
+	static void GetSubtree(const entt::registry& registry, entt::entity root, std::vector<entt::entity>& subtree)
+	{
+		subtree.push_back(root);
+		// Walked without recursion, so deep hierarchies can not overflow the stack
+		for (size_t i = subtree.size() - 1; i < subtree.size(); i++)
+		{
+			const auto* relationship = registry.try_get<RelationshipComponent>(subtree[i]);
+			if (!relationship)
+				continue;
+			for (entt::entity child = relationship->FirstChild; child != entt::null; child = registry.get<RelationshipComponent>(child).NextSibling)
+				subtree.push_back(child);
+		}
+	}
+
+	Scene::Scene()
+	{
+		// Keep the spatial index up to date as transforms are added, patched and removed
+		m_Registry.on_construct<TransformComponent>().connect<&Scene::OnTransformChanged>(*this);
+		m_Registry.on_update<TransformComponent>().connect<&Scene::OnTransformChanged>(*this);
+		m_Registry.on_destroy<TransformComponent>().connect<&Scene::OnTransformDestroyed>(*this);
+		// Game objects joining or leaving the hierarchy change its flattened order
+		m_Registry.on_construct<RelationshipComponent>().connect<&Scene::OnRelationshipChanged>(*this);
+		m_Registry.on_destroy<RelationshipComponent>().connect<&Scene::OnRelationshipChanged>(*this);
+
+		// Keep the sprite buffer up to date while rendering is retained
+		m_Registry.on_construct<SpriteComponent>().connect<&Scene::OnSpriteChanged>(*this);
+		m_Registry.on_update<SpriteComponent>().connect<&Scene::OnSpriteChanged>(*this);
+		m_Registry.on_destroy<SpriteComponent>().connect<&Scene::OnSpriteDestroyed>(*this);
+	}
+
 	void Scene::OnUpdate(Timestep ts)
 	{
 		// Update scripts
@@ -30,9 +146,12 @@ namespace Pinecone
 				nsc.Instance->OnUpdate(ts);
 			});
 
+		// Scripts may have moved game objects, only their transforms are built again before rendering
+		UpdateTransforms();
+
 		// Get the main camera
-		Camera* mainCamera = nullptr;
-		glm::mat4* cameraTransform = nullptr;
+		SceneCamera* mainCamera = nullptr;
+		glm::mat4 cameraTransform;
 		auto cameras = m_Registry.view<TransformComponent, CameraComponent>();
 		for (auto go : cameras)
 		{
@@ -48,26 +167,90 @@ namespace Pinecone
 			{
 				// Store the SceneCamera and the game objects transform 
 				mainCamera = &camera.Camera;
-				cameraTransform = &transform.GetTransform();
+				cameraTransform = transform.GetWorldTransform();
 				// Exit the for loop as we found the primary camera
 				break;
 			}
 		}
 
 		// Render the 2D scene
-		if (mainCamera)
+		if (mainCamera && m_SpriteBuffer)
+		{
+			Renderer2D::BeginScene(mainCamera->GetProjection(), cameraTransform);
+
+			// Every sprite is already in the sprite buffer, except those that changed this frame
+			// and those the buffer had no room for
+			UpdateSpriteBuffer();
+			Renderer2D::DrawSpriteBuffer(m_SpriteBuffer);
+			for (entt::entity e : m_ImmediateSprites)
+			{
+				auto [transform, sprite] = m_Registry.get<TransformComponent, SpriteComponent>(e);
+				Renderer2D::DrawSprite(transform.GetWorldTransform(), sprite);
+			}
+
+			Renderer2D::EndScene();
+		}
+		else if (mainCamera)
 		{
 			// Begin our 2D scene drawing with our primary camera and the transform of its game objects position
-			Renderer2D::BeginScene(mainCamera->GetProjection(), *cameraTransform);
+			Renderer2D::BeginScene(mainCamera->GetProjection(), cameraTransform);
+
+			// Only sprites that can be seen by the camera are drawn
+			const glm::mat4 viewProjection = mainCamera->GetProjection() * glm::inverse(cameraTransform);
+			const CameraFrustum frustum = ExtractFrustum(viewProjection);
+			uint32_t drawnCount = 0;
 
 			// Get all game objects that have a sprite and a transform component
 			auto sprites = m_Registry.group<TransformComponent>(entt::get<SpriteComponent>);
-			for (auto e : sprites)
+			auto drawSprite = [&](entt::entity e)
 			{
-				// Get the sprite and transform components of the game object and draw it to the screen
 				auto [transform, sprite] = sprites.get<TransformComponent, SpriteComponent>(e);
-				Renderer2D::DrawSprite(transform.GetTransform(), sprite);
+
+				// The corners of the sprite are half of one of its diagonals away from its center, whatever
+				// its parents did to it
+				const glm::mat4& world = transform.GetWorldTransform();
+				const glm::vec3 xAxis = glm::vec3(world[0]);
+				const glm::vec3 yAxis = glm::vec3(world[1]);
+				const float radius = 0.5f * std::sqrt(std::max(glm::dot(xAxis + yAxis, xAxis + yAxis), glm::dot(xAxis - yAxis, xAxis - yAxis)));
+				if (!IsSphereVisible(frustum, glm::vec3(world[3]), radius))
+					return;
+
+				// Draw the sprite to the screen
+				Renderer2D::DrawSprite(world, sprite);
+				drawnCount++;
+			};
+
+			if (mainCamera->GetProjectionType() == SceneCamera::ProjectionType::Orthographic)
+			{
+				// An orthographic camera sees the same box at every depth, so only the game objects the
+				// spatial index finds in that box have to be looked at
+				glm::vec2 viewMin, viewMax;
+				GetViewBounds(viewProjection, viewMin, viewMax);
+				m_QueryResults.clear();
+				m_SpatialIndex.QueryAABB(viewMin, viewMax, m_QueryResults);
+
+				// The index returns game objects in no particular order, draw them in the order of the group
+				// like the perspective path does, so sprites at the same depth overlap the same way
+				m_DrawOrder.clear();
+				const auto first = sprites.begin();
+				for (auto e : m_QueryResults)
+				{
+					auto it = sprites.find(e);
+					if (it != sprites.end())
+						m_DrawOrder.push_back((uint32_t)(it - first));
+				}
+				std::sort(m_DrawOrder.begin(), m_DrawOrder.end());
+
+				for (uint32_t position : m_DrawOrder)
+					drawSprite(first[position]);
+			}
+			else
+			{
+				// A perspective camera sees further the deeper it looks, so test every sprite
+				for (auto e : sprites)
+					drawSprite(e);
 			}
+			Renderer2D::AddCulledCount((uint32_t)sprites.size() - drawnCount);
 
 			// End our 2D scene drawing
 			Renderer2D::EndScene();
@@ -96,20 +279,98 @@ namespace Pinecone
 
 	void Scene::DestroyGameObject(GameObject gameObject)
 	{
-		// Check to make sure if the game object has a native script component
-		if (gameObject.HasComponent<NativeScriptComponent>())
+		// The children of the game object are destroyed with it
+		std::vector<entt::entity> subtree;
+		GetSubtree(m_Registry, gameObject, subtree);
+		if (m_Registry.all_of<RelationshipComponent>(gameObject))
+			Unlink(gameObject);
+
+		for (entt::entity entity : subtree)
+		{
+			GameObject go = { entity, this };
+			// Check to make sure if the game object has a native script component
+			if (go.HasComponent<NativeScriptComponent>())
+			{
+				// Get the native script component
+				auto nsc = go.GetComponent<NativeScriptComponent>();
+				// Call the OnDestroy function
+				nsc.Instance->OnDestroy();
+				// Then delete it from memory
+				delete nsc.Instance;
+				nsc.Instance = nullptr;
+			}
+			// Remove the game object from our game objects map and the entity registry
+			m_GameObjectMap.erase(go.GetUUID());
+			m_Registry.destroy(entity);
+		}
+	}
+
+	void Scene::SetParent(GameObject child, GameObject parent)
+	{
+		PC_CORE_ASSERT(child, "Can not set the parent of a null game object!");
+
+		// A game object can not be moved under itself or one of its children
+		for (entt::entity e = parent; e != entt::null;)
+		{
+			PC_CORE_ASSERT(e != (entt::entity)child, "A game object can not be the child of itself or one of its children!");
+			const auto* relationship = m_Registry.try_get<RelationshipComponent>(e);
+			e = relationship ? relationship->Parent : entt::null;
+		}
+
+		// A game object that was never in the hierarchy does not join it just to be made a root
+		if (!parent && !m_Registry.all_of<RelationshipComponent>(child))
+			return;
+		if (m_Registry.get_or_emplace<RelationshipComponent>(child).Parent == (entt::entity)parent)
+			return;
+		Unlink(child);
+
+		uint32_t depth = 0;
+		if (parent)
+		{
+			// Add the child to the front of the parents children
+			auto& parentRelationship = m_Registry.get_or_emplace<RelationshipComponent>(parent);
+			auto& relationship = m_Registry.get<RelationshipComponent>(child);
+			relationship.Parent = parent;
+			relationship.NextSibling = parentRelationship.FirstChild;
+			if (parentRelationship.FirstChild != entt::null)
+				m_Registry.get<RelationshipComponent>(parentRelationship.FirstChild).PrevSibling = child;
+			parentRelationship.FirstChild = child;
+			parentRelationship.ChildCount++;
+			depth = parentRelationship.Depth + 1;
+		}
+
+		// The whole subtree moved up or down the hierarchy
+		std::vector<entt::entity> subtree;
+		GetSubtree(m_Registry, child, subtree);
+		m_Registry.get<RelationshipComponent>(child).Depth = depth;
+		for (size_t i = 1; i < subtree.size(); i++)
 		{
-			// Get the native script component
-			auto nsc = gameObject.GetComponent<NativeScriptComponent>();
-			// Call the OnDestroy function
-			nsc.Instance->OnDestroy();
-			// Then delete it from memory
-			delete nsc.Instance;
-			nsc.Instance = nullptr;
+			auto& relationship = m_Registry.get<RelationshipComponent>(subtree[i]);
+			relationship.Depth = m_Registry.get<RelationshipComponent>(relationship.Parent).Depth + 1;
 		}
-		// Remove the game object from our game objects map and the entity registry
-		m_GameObjectMap.erase(gameObject.GetUUID());
-		m_Registry.destroy(gameObject);
+
+		m_HierarchyChanged = true;
+	}
+
+	GameObject Scene::GetParent(GameObject child)
+	{
+		const auto* relationship = m_Registry.try_get<RelationshipComponent>(child);
+		if (!relationship || relationship->Parent == entt::null)
+			return {};
+		return { relationship->Parent, this };
+	}
+
+	std::vector<GameObject> Scene::GetChildren(GameObject parent)
+	{
+		std::vector<GameObject> children;
+		const auto* relationship = m_Registry.try_get<RelationshipComponent>(parent);
+		if (!relationship)
+			return children;
+
+		children.reserve(relationship->ChildCount);
+		for (entt::entity child = relationship->FirstChild; child != entt::null; child = m_Registry.get<RelationshipComponent>(child).NextSibling)
+			children.push_back(GameObject{ child, this });
+		return children;
 	}
 
 	GameObject Scene::GetGameObjectByTag(std::string_view name)
@@ -172,6 +433,304 @@ namespace Pinecone
 		return {};
 	}
 
+	std::vector<GameObject> Scene::QueryAABB(const glm::vec2& min, const glm::vec2& max)
+	{
+		UpdateTransforms();
+
+		m_QueryResults.clear();
+		m_SpatialIndex.QueryAABB(min, max, m_QueryResults);
+		return ToGameObjects(m_QueryResults);
+	}
+
+	std::vector<GameObject> Scene::QueryPoint(const glm::vec2& point)
+	{
+		UpdateTransforms();
+
+		m_QueryResults.clear();
+		m_SpatialIndex.QueryPoint(point, m_QueryResults);
+		return ToGameObjects(m_QueryResults);
+	}
+
+	std::vector<GameObject> Scene::QueryRadius(const glm::vec2& center, float radius)
+	{
+		UpdateTransforms();
+
+		m_QueryResults.clear();
+		m_SpatialIndex.QueryRadius(center, radius, m_QueryResults);
+		return ToGameObjects(m_QueryResults);
+	}
+
+	GameObject Scene::Raycast(const glm::vec2& origin, const glm::vec2& direction, float maxDistance, float* hitDistance)
+	{
+		UpdateTransforms();
+
+		entt::entity hit = m_SpatialIndex.Raycast(origin, direction, maxDistance, hitDistance);
+		if (hit == entt::null)
+			return {};
+		return { hit, this };
+	}
+
+	void Scene::OnTransformChanged(entt::registry& registry, entt::entity entity)
+	{
+		// An added or replaced transform may be a copy of another one, so it is linked to this scene again.
+		// Its setters add it to the list of changed transforms from now on
+		TransformComponent& transform = registry.get<TransformComponent>(entity);
+		transform.m_ChangedTransforms = &m_DirtyTransforms;
+		transform.m_Entity = entity;
+		transform.m_Queued = false;
+		transform.MarkDirty();
+	}
+
+	void Scene::OnTransformDestroyed(entt::registry& registry, entt::entity entity)
+	{
+		m_SpatialIndex.Remove(entity);
+		// A sprite without a transform is not drawn
+		if (m_SpriteBuffer)
+			FreeSpriteSlot(entity);
+	}
+
+	void Scene::UpdateTransforms()
+	{
+		if (m_DirtyTransforms.empty() && !m_HierarchyChanged)
+			return;
+
+		PC_PROFILE_FUNCTION();
+
+		// Parents changed, flatten the hierarchy again. This marks every node in it dirty
+		if (m_HierarchyChanged)
+			BuildHierarchy();
+
+		// A game object may have been patched more than once
+		std::sort(m_DirtyTransforms.begin(), m_DirtyTransforms.end());
+		m_DirtyTransforms.erase(std::unique(m_DirtyTransforms.begin(), m_DirtyTransforms.end()), m_DirtyTransforms.end());
+
+		// Rebuilding a matrix only touches its own transform, so many of them are rebuilt in parallel
+		const entt::registry& registry = m_Registry;
+		JobSystem::ParallelFor((uint32_t)m_DirtyTransforms.size(), s_TransformBatchSize, [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; i++)
+				{
+					if (!registry.valid(m_DirtyTransforms[i]))
+						continue;
+					const auto* transform = registry.try_get<TransformComponent>(m_DirtyTransforms[i]);
+					if (transform && transform->IsDirty())
+						transform->UpdateTransform();
+				}
+			});
+
+		for (entt::entity entity : m_DirtyTransforms)
+		{
+			// The game object may have been destroyed or lost its transform since the transform changed
+			if (!m_Registry.valid(entity) || !m_Registry.all_of<TransformComponent>(entity))
+				continue;
+
+			TransformComponent& transform = m_Registry.get<TransformComponent>(entity);
+			transform.m_Queued = false;
+
+			// Game objects in the hierarchy are moved once their world transform is built
+			if (const auto* relationship = m_Registry.try_get<RelationshipComponent>(entity))
+			{
+				m_NodeDirty[relationship->m_Index] = 1;
+				m_FirstDirtyNode = std::min(m_FirstDirtyNode, relationship->m_Index);
+				continue;
+			}
+
+			glm::vec2 min, max;
+			GetTransformBounds(transform.GetTransform(), min, max);
+			m_SpatialIndex.Update(entity, min, max);
+			if (m_SpriteBuffer)
+				m_DirtySprites.push_back(entity);
+		}
+		m_DirtyTransforms.clear();
+
+		PropagateTransforms();
+	}
+
+	void Scene::OnRelationshipChanged(entt::registry& registry, entt::entity entity)
+	{
+		m_HierarchyChanged = true;
+	}
+
+	void Scene::Unlink(entt::entity child)
+	{
+		auto& relationship = m_Registry.get<RelationshipComponent>(child);
+		if (relationship.Parent == entt::null)
+			return;
+
+		auto& parentRelationship = m_Registry.get<RelationshipComponent>(relationship.Parent);
+		if (relationship.PrevSibling != entt::null)
+			m_Registry.get<RelationshipComponent>(relationship.PrevSibling).NextSibling = relationship.NextSibling;
+		else
+			parentRelationship.FirstChild = relationship.NextSibling;
+		if (relationship.NextSibling != entt::null)
+			m_Registry.get<RelationshipComponent>(relationship.NextSibling).PrevSibling = relationship.PrevSibling;
+		parentRelationship.ChildCount--;
+
+		relationship.Parent = entt::null;
+		relationship.PrevSibling = entt::null;
+		relationship.NextSibling = entt::null;
+		m_HierarchyChanged = true;
+	}
+
+	void Scene::BuildHierarchy()
+	{
+		PC_PROFILE_FUNCTION();
+
+		// Sorting the relationships by depth puts every parent before its children
+		m_Registry.sort<RelationshipComponent>([](const RelationshipComponent& a, const RelationshipComponent& b)
+			{
+				return a.Depth < b.Depth;
+			});
+
+		auto relationships = m_Registry.view<RelationshipComponent>();
+		uint32_t index = 0;
+		for (auto e : relationships)
+			relationships.get<RelationshipComponent>(e).m_Index = index++;
+
+		m_HierarchyNodes.clear();
+		m_HierarchyNodes.reserve(index);
+		for (auto e : relationships)
+		{
+			const auto& relationship = relationships.get<RelationshipComponent>(e);
+			const uint32_t parent = relationship.Parent != entt::null ? m_Registry.get<RelationshipComponent>(relationship.Parent).m_Index : NoParent;
+			m_HierarchyNodes.push_back({ e, parent });
+		}
+
+		// Nodes may have moved, so every world transform has to be built again
+		m_WorldTransforms.resize(index);
+		m_NodeDirty.assign(index, 1);
+		m_FirstDirtyNode = 0;
+		m_HierarchyChanged = false;
+	}
+
+	void Scene::PropagateTransforms()
+	{
+		const uint32_t nodeCount = (uint32_t)m_HierarchyNodes.size();
+		if (m_FirstDirtyNode >= nodeCount)
+			return;
+
+		PC_PROFILE_FUNCTION();
+
+		// Parents come before their children, so a parents world transform is always built before its
+		// children need it. A node is dirty if its own transform or its parents world transform changed
+		for (uint32_t i = m_FirstDirtyNode; i < nodeCount; i++)
+		{
+			const HierarchyNode& node = m_HierarchyNodes[i];
+			if (node.Parent != NoParent && m_NodeDirty[node.Parent])
+				m_NodeDirty[i] = 1;
+			if (!m_NodeDirty[i])
+				continue;
+
+			TransformComponent* transform = m_Registry.try_get<TransformComponent>(node.Entity);
+			const glm::mat4 local = transform ? transform->GetTransform() : glm::mat4(1.0f);
+			m_WorldTransforms[i] = node.Parent != NoParent ? m_WorldTransforms[node.Parent] * local : local;
+			if (!transform)
+				continue;
+
+			transform->m_WorldTransform = m_WorldTransforms[i];
+			transform->m_HasParent = node.Parent != NoParent;
+
+			glm::vec2 min, max;
+			GetTransformBounds(m_WorldTransforms[i], min, max);
+			m_SpatialIndex.Update(node.Entity, min, max);
+			if (m_SpriteBuffer)
+				m_DirtySprites.push_back(node.Entity);
+		}
+
+		std::fill(m_NodeDirty.begin() + m_FirstDirtyNode, m_NodeDirty.end(), 0);
+		m_FirstDirtyNode = nodeCount;
+	}
+
+	void Scene::SetRetainedRendering(bool retained)
+	{
+		if (retained == IsRetainedRendering())
+			return;
+
+		m_SpriteSlots.clear();
+		m_DirtySprites.clear();
+		m_ImmediateSprites.clear();
+		if (!retained)
+		{
+			m_SpriteBuffer = nullptr;
+			return;
+		}
+
+		// Every sprite that already exists has to be added to the new buffer
+		auto sprites = m_Registry.view<TransformComponent, SpriteComponent>();
+		m_SpriteBuffer = SpriteBuffer::Create((uint32_t)sprites.size_hint());
+		for (auto e : sprites)
+			m_DirtySprites.push_back(e);
+	}
+
+	void Scene::OnSpriteChanged(entt::registry& registry, entt::entity entity)
+	{
+		if (m_SpriteBuffer)
+			m_DirtySprites.push_back(entity);
+	}
+
+	void Scene::OnSpriteDestroyed(entt::registry& registry, entt::entity entity)
+	{
+		if (m_SpriteBuffer)
+			FreeSpriteSlot(entity);
+	}
+
+	void Scene::FreeSpriteSlot(entt::entity entity)
+	{
+		m_ImmediateSprites.erase(entity);
+
+		auto it = m_SpriteSlots.find(entity);
+		if (it == m_SpriteSlots.end())
+			return;
+		m_SpriteBuffer->Free(it->second);
+		m_SpriteSlots.erase(it);
+	}
+
+	void Scene::UpdateSpriteBuffer()
+	{
+		if (m_DirtySprites.empty())
+			return;
+
+		PC_PROFILE_FUNCTION();
+
+		// A game object may have been patched more than once
+		std::sort(m_DirtySprites.begin(), m_DirtySprites.end());
+		m_DirtySprites.erase(std::unique(m_DirtySprites.begin(), m_DirtySprites.end()), m_DirtySprites.end());
+
+		for (entt::entity entity : m_DirtySprites)
+		{
+			// The game object may have been destroyed or lost its sprite since it changed, which
+			// already freed its slot
+			if (!m_Registry.valid(entity) || !m_Registry.all_of<TransformComponent, SpriteComponent>(entity))
+				continue;
+
+			auto [it, inserted] = m_SpriteSlots.try_emplace(entity, 0);
+			if (inserted)
+				it->second = m_SpriteBuffer->Allocate();
+
+			auto [transform, sprite] = m_Registry.get<TransformComponent, SpriteComponent>(entity);
+			if (m_SpriteBuffer->SetSprite(it->second, transform.GetWorldTransform(), sprite))
+			{
+				m_ImmediateSprites.erase(entity);
+				continue;
+			}
+
+			// The buffer has no room for the sprites texture, draw it the usual way instead
+			m_SpriteBuffer->Free(it->second);
+			m_SpriteSlots.erase(it);
+			m_ImmediateSprites.insert(entity);
+		}
+		m_DirtySprites.clear();
+	}
+
+	std::vector<GameObject> Scene::ToGameObjects(const std::vector<entt::entity>& entities)
+	{
+		std::vector<GameObject> objects;
+		objects.reserve(entities.size());
+		for (entt::entity entity : entities)
+			objects.push_back(GameObject{ entity, this });
+		return objects;
+	}
+
 	void Scene::OnViewportResize(uint32_t width, uint32_t height)
 	{
 		// Update the viewport width and height
@@ -2,6 +2,8 @@
 
 #include "Pinecone/Core/UUID.h"
 #include "Pinecone/Core/Timestep.h"
+#include "Pinecone/Scene/SpatialIndex.h"
+#include "Pinecone/Renderer/SpriteBuffer.h"
 
 #include <entt.hpp>
 
@@ -15,7 +17,7 @@ namespace Pinecone
 		/// <summary>
 		/// The Scene constructor
 		/// </summary>
-		Scene() = default;
+		Scene();
 		/// <summary>
 		/// The Scene destructor
 		/// </summary>
@@ -40,6 +42,27 @@ namespace Pinecone
 		/// <param name="gameObject">The game object to be destroyed</param>
 		void DestroyGameObject(GameObject gameObject);
 
+		/// <summary>
+		/// Make a game object the child of another, so it moves with its parent. Its transform
+		/// becomes relative to the parent. The children of a game object are destroyed with it
+		/// </summary>
+		/// <param name="child">The game object to move in the hierarchy</param>
+		/// <param name="parent">The new parent, or a null game object to make the child a root again</param>
+		void SetParent(GameObject child, GameObject parent);
+		/// <summary>
+		/// Get the parent of a game object.
+		/// The entity handle of the game object returned is null if it has no parent
+		/// </summary>
+		/// <param name="child">The game object</param>
+		/// <returns>The parent game object</returns>
+		GameObject GetParent(GameObject child);
+		/// <summary>
+		/// Get the children of a game object
+		/// </summary>
+		/// <param name="parent">The game object</param>
+		/// <returns>The child game objects</returns>
+		std::vector<GameObject> GetChildren(GameObject parent);
+
 		/// <summary>
 		/// Get the first game object with the specified tag.
 		/// The entity handle of the game object returned is null if no game objects
@@ -75,12 +98,145 @@ namespace Pinecone
 		/// <returns>The game object with the primary camera component</returns>
 		GameObject GetPrimaryCameraGameObject();
 
+		/// <summary>
+		/// Get every game object whose bounds overlap a box. The bounds of a game object are the
+		/// box around its transformed unit quad on the x and y axes, like a sprite
+		/// </summary>
+		/// <param name="min">The bottom left corner of the box</param>
+		/// <param name="max">The top right corner of the box</param>
+		/// <returns>The found game objects</returns>
+		std::vector<GameObject> QueryAABB(const glm::vec2& min, const glm::vec2& max);
+		/// <summary>
+		/// Get every game object whose bounds contain a point, such as the mouse position in the world
+		/// </summary>
+		/// <param name="point">The point</param>
+		/// <returns>The found game objects</returns>
+		std::vector<GameObject> QueryPoint(const glm::vec2& point);
+		/// <summary>
+		/// Get every game object whose bounds overlap a circle
+		/// </summary>
+		/// <param name="center">The center of the circle</param>
+		/// <param name="radius">The radius of the circle</param>
+		/// <returns>The found game objects</returns>
+		std::vector<GameObject> QueryRadius(const glm::vec2& center, float radius);
+		/// <summary>
+		/// Get the first game object whose bounds are hit by a ray.
+		/// The entity handle of the game object returned is null if nothing was hit
+		/// </summary>
+		/// <param name="origin">The start of the ray</param>
+		/// <param name="direction">The direction of the ray</param>
+		/// <param name="maxDistance">How far along the ray to look</param>
+		/// <param name="hitDistance">Set to the distance along the ray of the hit, if not null</param>
+		/// <returns>The game object that was hit</returns>
+		GameObject Raycast(const glm::vec2& origin, const glm::vec2& direction, float maxDistance, float* hitDistance = nullptr);
+
+		/// <summary>
+		/// Set if the sprites of the scene are kept in a sprite buffer on the GPU instead of being
+		/// submitted every frame. Only sprites that changed are uploaded again, which is much faster
+		/// for scenes where most sprites stay still, but every sprite is drawn as there is no culling.
+		/// Sprite components must be changed with PatchComponent, and transforms with PatchComponent or
+		/// their setters, for the changes to show
+		/// </summary>
+		/// <param name="retained">True to keep the sprites on the GPU</param>
+		void SetRetainedRendering(bool retained);
+		/// <summary>
+		/// Check if the sprites of the scene are kept in a sprite buffer on the GPU
+		/// </summary>
+		/// <returns>True if the sprites are kept on the GPU</returns>
+		bool IsRetainedRendering() const { return m_SpriteBuffer != nullptr; }
+
 		/// <summary>
 		/// To be called when the viewport (window) is resized. This changes the viewport
 		/// for all game objects with camera components
 		/// </summary>
 		void OnViewportResize(uint32_t width, uint32_t height);
 	private:
+		/// <summary>
+		/// Called by the registry when a transform component is added or patched
+		/// </summary>
+		void OnTransformChanged(entt::registry& registry, entt::entity entity);
+		/// <summary>
+		/// Called by the registry when a transform component is removed
+		/// </summary>
+		void OnTransformDestroyed(entt::registry& registry, entt::entity entity);
+		/// <summary>
+		/// The transform update pass. Rebuild the matrices of the transforms that changed since the last
+		/// update and move their game objects in the spatial index and the sprite buffer
+		/// </summary>
+		void UpdateTransforms();
+		/// <summary>
+		/// Called by the registry when a relationship component is added or removed
+		/// </summary>
+		void OnRelationshipChanged(entt::registry& registry, entt::entity entity);
+		/// <summary>
+		/// Remove a game object from the children of its parent
+		/// </summary>
+		void Unlink(entt::entity child);
+		/// <summary>
+		/// Sort the game objects in a hierarchy by depth and flatten the hierarchy into a list
+		/// where every parent comes before its children
+		/// </summary>
+		void BuildHierarchy();
+		/// <summary>
+		/// Build the world transforms of the game objects in the hierarchy whose transform or any
+		/// of whose parents transforms changed
+		/// </summary>
+		void PropagateTransforms();
+		/// <summary>
+		/// Called by the registry when a sprite component is added or patched
+		/// </summary>
+		void OnSpriteChanged(entt::registry& registry, entt::entity entity);
+		/// <summary>
+		/// Called by the registry when a sprite component is removed
+		/// </summary>
+		void OnSpriteDestroyed(entt::registry& registry, entt::entity entity);
+		/// <summary>
+		/// Write the sprites that changed since the last update into the sprite buffer
+		/// </summary>
+		void UpdateSpriteBuffer();
+		/// <summary>
+		/// Remove a game object from the sprite buffer
+		/// </summary>
+		void FreeSpriteSlot(entt::entity entity);
+		/// <summary>
+		/// Convert entity handles into game objects of this scene
+		/// </summary>
+		std::vector<GameObject> ToGameObjects(const std::vector<entt::entity>& entities);
+	private:
+		// The spatial index is declared before the registry so that it outlives it, removing the
+		// components of the registry removes them from the index
+		SpatialIndex m_SpatialIndex;
+		// The transforms that changed since the last transform update pass, added by the transforms themselves
+		std::vector<entt::entity> m_DirtyTransforms;
+		// Reused for spatial index query results
+		std::vector<entt::entity> m_QueryResults;
+		// Reused for the positions in the sprite group of the sprites to draw
+		std::vector<uint32_t> m_DrawOrder;
+
+		// The hierarchy flattened in depth order. The world transforms and dirty flags are stored next to
+		// the nodes, so propagating transforms is one pass over a few arrays
+		struct HierarchyNode
+		{
+			entt::entity Entity;
+			// The index of the parent node, NoParent for a root
+			uint32_t Parent;
+		};
+		static const uint32_t NoParent = std::numeric_limits<uint32_t>::max();
+
+		std::vector<HierarchyNode> m_HierarchyNodes;
+		std::vector<glm::mat4> m_WorldTransforms;
+		std::vector<uint8_t> m_NodeDirty;
+		// The first node with a dirty flag, nodes before it do not have to be looked at
+		uint32_t m_FirstDirtyNode = 0;
+		bool m_HierarchyChanged = false;
+
+		// Only created while rendering is retained
+		Ref<SpriteBuffer> m_SpriteBuffer;
+		std::unordered_map<entt::entity, uint32_t> m_SpriteSlots;
+		std::vector<entt::entity> m_DirtySprites;
+		// Sprites that did not fit in the sprite buffer as it ran out of textures, drawn every frame instead
+		std::unordered_set<entt::entity> m_ImmediateSprites;
+
 		entt::registry m_Registry;
 		std::unordered_map<UUID, entt::entity> m_GameObjectMap;
 
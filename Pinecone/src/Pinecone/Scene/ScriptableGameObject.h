@@ -35,6 +35,18 @@ namespace Pinecone
 			return m_GameObject.GetComponent<T>();
 		}
 
+		/// <summary>
+		/// Change a component with a function, letting the scene know that the component changed
+		/// </summary>
+		/// <typeparam name="T">The component type</typeparam>
+		/// <param name="func">A function that takes a reference to the component and changes it</param>
+		/// <returns>A reference to the component</returns>
+		template<typename T, typename Func>
+		T& PatchComponent(Func&& func)
+		{
+			return m_GameObject.PatchComponent<T>(std::forward<Func>(func));
+		}
+
 		/// <summary>
 		/// Check if the game object has a component
 		/// </summary>
@@ -0,0 +1,331 @@
+#include "pcpch.h"
+#include "SpatialIndex.h"
+
+namespace Pinecone
+{
+	// Entries covering more cells than this are tested by every query instead of being added to every
+	// cell they cover, so one huge entity can not fill the grid
+	static const int32_t s_MaxCellsPerEntry = 64;
+
+	SpatialIndex::SpatialIndex(float cellSize)
+		: m_CellSize(cellSize), m_InverseCellSize(1.0f / cellSize)
+	{
+		PC_CORE_ASSERT(cellSize > 0.0f, "The cell size must be greater than 0!");
+	}
+
+	glm::ivec4 SpatialIndex::GetCellRange(const glm::vec2& min, const glm::vec2& max) const
+	{
+		return {
+			(int32_t)std::floor(min.x * m_InverseCellSize),
+			(int32_t)std::floor(min.y * m_InverseCellSize),
+			(int32_t)std::floor(max.x * m_InverseCellSize),
+			(int32_t)std::floor(max.y * m_InverseCellSize)
+		};
+	}
+
+	void SpatialIndex::Update(entt::entity entity, const glm::vec2& min, const glm::vec2& max)
+	{
+		const glm::ivec4 cells = GetCellRange(min, max);
+
+		auto [it, inserted] = m_EntryLookup.try_emplace(entity, (uint32_t)m_Entries.size());
+		if (inserted)
+		{
+			m_Entries.push_back({ entity, min, max, cells, false, m_QueryStamp });
+			AddToCells(it->second);
+			return;
+		}
+
+		Entry& entry = m_Entries[it->second];
+		entry.Min = min;
+		entry.Max = max;
+
+		// Most moves stay within the same cells, then only the bounds have to change
+		if (entry.Cells == cells)
+			return;
+
+		RemoveFromCells(it->second);
+		entry.Cells = cells;
+		AddToCells(it->second);
+	}
+
+	void SpatialIndex::Remove(entt::entity entity)
+	{
+		auto it = m_EntryLookup.find(entity);
+		if (it == m_EntryLookup.end())
+			return;
+
+		const uint32_t index = it->second;
+		const uint32_t lastIndex = (uint32_t)m_Entries.size() - 1;
+		RemoveFromCells(index);
+		m_EntryLookup.erase(it);
+
+		// Move the last entry into the hole so the entries stay packed
+		if (index != lastIndex)
+		{
+			ReplaceInCells(lastIndex, index);
+			m_Entries[index] = m_Entries[lastIndex];
+			m_EntryLookup[m_Entries[index].Entity] = index;
+		}
+		m_Entries.pop_back();
+	}
+
+	void SpatialIndex::Clear()
+	{
+		m_Entries.clear();
+		m_EntryLookup.clear();
+		m_Cells.clear();
+		m_OversizedEntries.clear();
+	}
+
+	void SpatialIndex::AddToCells(uint32_t entryIndex)
+	{
+		Entry& entry = m_Entries[entryIndex];
+		const glm::ivec4& cells = entry.Cells;
+
+		const int64_t cellCount = ((int64_t)cells.z - cells.x + 1) * ((int64_t)cells.w - cells.y + 1);
+		entry.Oversized = cellCount > s_MaxCellsPerEntry;
+		if (entry.Oversized)
+		{
+			m_OversizedEntries.push_back(entryIndex);
+			return;
+		}
+
+		for (int32_t y = cells.y; y <= cells.w; y++)
+		{
+			for (int32_t x = cells.x; x <= cells.z; x++)
+				m_Cells[GetCellKey(x, y)].push_back(entryIndex);
+		}
+	}
+
+	void SpatialIndex::RemoveFromCells(uint32_t entryIndex)
+	{
+		const Entry& entry = m_Entries[entryIndex];
+		auto removeFrom = [entryIndex](std::vector<uint32_t>& list)
+		{
+			auto it = std::find(list.begin(), list.end(), entryIndex);
+			*it = list.back();
+			list.pop_back();
+		};
+
+		if (entry.Oversized)
+		{
+			removeFrom(m_OversizedEntries);
+			return;
+		}
+
+		const glm::ivec4& cells = entry.Cells;
+		for (int32_t y = cells.y; y <= cells.w; y++)
+		{
+			for (int32_t x = cells.x; x <= cells.z; x++)
+			{
+				auto cell = m_Cells.find(GetCellKey(x, y));
+				removeFrom(cell->second);
+				// Drop empty cells so the map only holds the cells that are in use
+				if (cell->second.empty())
+					m_Cells.erase(cell);
+			}
+		}
+	}
+
+	void SpatialIndex::ReplaceInCells(uint32_t oldIndex, uint32_t newIndex)
+	{
+		const Entry& entry = m_Entries[oldIndex];
+		auto replaceIn = [oldIndex, newIndex](std::vector<uint32_t>& list)
+		{
+			*std::find(list.begin(), list.end(), oldIndex) = newIndex;
+		};
+
+		if (entry.Oversized)
+		{
+			replaceIn(m_OversizedEntries);
+			return;
+		}
+
+		const glm::ivec4& cells = entry.Cells;
+		for (int32_t y = cells.y; y <= cells.w; y++)
+		{
+			for (int32_t x = cells.x; x <= cells.z; x++)
+				replaceIn(m_Cells[GetCellKey(x, y)]);
+		}
+	}
+
+	void SpatialIndex::NextQueryStamp() const
+	{
+		// Every query gets a new stamp, entries already stamped with it were already tested. Only
+		// when the stamp wraps around do the entries have to be cleared
+		if (++m_QueryStamp == 0)
+		{
+			for (const Entry& entry : m_Entries)
+				entry.QueryStamp = 0;
+			m_QueryStamp = 1;
+		}
+	}
+
+	template<typename Func>
+	void SpatialIndex::ForEachCandidate(const glm::ivec4& cells, Func func) const
+	{
+		NextQueryStamp();
+
+		auto visit = [&](uint32_t entryIndex)
+		{
+			const Entry& entry = m_Entries[entryIndex];
+			if (entry.QueryStamp == m_QueryStamp)
+				return;
+			entry.QueryStamp = m_QueryStamp;
+			func(entry);
+		};
+
+		for (uint32_t entryIndex : m_OversizedEntries)
+			visit(entryIndex);
+
+		// Large queries look at every cell in use instead of every cell in the range, which is
+		// faster once most of the cells in the range would be empty
+		const int64_t cellCount = ((int64_t)cells.z - cells.x + 1) * ((int64_t)cells.w - cells.y + 1);
+		if (cellCount > (int64_t)m_Cells.size())
+		{
+			for (const auto& [key, list] : m_Cells)
+			{
+				const int32_t x = (int32_t)(uint32_t)(key >> 32);
+				const int32_t y = (int32_t)(uint32_t)key;
+				if (x < cells.x || x > cells.z || y < cells.y || y > cells.w)
+					continue;
+				for (uint32_t entryIndex : list)
+					visit(entryIndex);
+			}
+			return;
+		}
+
+		for (int32_t y = cells.y; y <= cells.w; y++)
+		{
+			for (int32_t x = cells.x; x <= cells.z; x++)
+			{
+				auto cell = m_Cells.find(GetCellKey(x, y));
+				if (cell == m_Cells.end())
+					continue;
+				for (uint32_t entryIndex : cell->second)
+					visit(entryIndex);
+			}
+		}
+	}
+
+	void SpatialIndex::QueryAABB(const glm::vec2& min, const glm::vec2& max, std::vector<entt::entity>& results) const
+	{
+		PC_PROFILE_FUNCTION();
+
+		ForEachCandidate(GetCellRange(min, max), [&](const Entry& entry)
+			{
+				if (entry.Min.x <= max.x && entry.Max.x >= min.x && entry.Min.y <= max.y && entry.Max.y >= min.y)
+					results.push_back(entry.Entity);
+			});
+	}
+
+	void SpatialIndex::QueryPoint(const glm::vec2& point, std::vector<entt::entity>& results) const
+	{
+		ForEachCandidate(GetCellRange(point, point), [&](const Entry& entry)
+			{
+				if (point.x >= entry.Min.x && point.x <= entry.Max.x && point.y >= entry.Min.y && point.y <= entry.Max.y)
+					results.push_back(entry.Entity);
+			});
+	}
+
+	void SpatialIndex::QueryRadius(const glm::vec2& center, float radius, std::vector<entt::entity>& results) const
+	{
+		PC_PROFILE_FUNCTION();
+
+		const float radiusSquared = radius * radius;
+		ForEachCandidate(GetCellRange(center - radius, center + radius), [&](const Entry& entry)
+			{
+				// The closest point of the bounds to the center of the circle
+				const glm::vec2 closest = glm::clamp(center, entry.Min, entry.Max);
+				const glm::vec2 offset = center - closest;
+				if (glm::dot(offset, offset) <= radiusSquared)
+					results.push_back(entry.Entity);
+			});
+	}
+
+	entt::entity SpatialIndex::Raycast(const glm::vec2& origin, const glm::vec2& direction, float maxDistance, float* hitDistance) const
+	{
+		PC_PROFILE_FUNCTION();
+
+		// The cells are walked until the ray is past the max distance, so it has to be finite
+		PC_CORE_ASSERT(std::isfinite(maxDistance), "The max distance of a raycast must be finite!");
+
+		const float length = glm::length(direction);
+		if (length == 0.0f)
+			return entt::null;
+		const glm::vec2 rayDirection = direction / length;
+		const glm::vec2 inverseDirection = 1.0f / rayDirection;
+
+		NextQueryStamp();
+
+		entt::entity closestEntity = entt::null;
+		float closestDistance = maxDistance;
+
+		// Slab test, the distance along the ray the ray enters the bounds is the hit distance
+		auto testEntry = [&](uint32_t entryIndex)
+		{
+			const Entry& entry = m_Entries[entryIndex];
+			if (entry.QueryStamp == m_QueryStamp)
+				return;
+			entry.QueryStamp = m_QueryStamp;
+
+			const glm::vec2 t0 = (entry.Min - origin) * inverseDirection;
+			const glm::vec2 t1 = (entry.Max - origin) * inverseDirection;
+			const glm::vec2 tMin = glm::min(t0, t1);
+			const glm::vec2 tMax = glm::max(t0, t1);
+			const float enter = std::max(std::max(tMin.x, tMin.y), 0.0f);
+			const float exit = std::min(tMax.x, tMax.y);
+			if (enter <= exit && enter <= closestDistance)
+			{
+				closestDistance = enter;
+				closestEntity = entry.Entity;
+			}
+		};
+
+		for (uint32_t entryIndex : m_OversizedEntries)
+			testEntry(entryIndex);
+
+		// Walk the cells along the ray in order. Once the ray leaves a cell past the closest hit so
+		// far, no later cell can have a closer hit
+		int32_t x = (int32_t)std::floor(origin.x * m_InverseCellSize);
+		int32_t y = (int32_t)std::floor(origin.y * m_InverseCellSize);
+		const int32_t stepX = rayDirection.x < 0.0f ? -1 : 1;
+		const int32_t stepY = rayDirection.y < 0.0f ? -1 : 1;
+
+		// The distance along the ray to the next cell boundary on each axis, and between boundaries
+		const float nextBoundaryX = (x + (stepX > 0 ? 1 : 0)) * m_CellSize;
+		const float nextBoundaryY = (y + (stepY > 0 ? 1 : 0)) * m_CellSize;
+		float tNextX = rayDirection.x != 0.0f ? (nextBoundaryX - origin.x) * inverseDirection.x : std::numeric_limits<float>::infinity();
+		float tNextY = rayDirection.y != 0.0f ? (nextBoundaryY - origin.y) * inverseDirection.y : std::numeric_limits<float>::infinity();
+		const float tDeltaX = rayDirection.x != 0.0f ? m_CellSize * std::abs(inverseDirection.x) : std::numeric_limits<float>::infinity();
+		const float tDeltaY = rayDirection.y != 0.0f ? m_CellSize * std::abs(inverseDirection.y) : std::numeric_limits<float>::infinity();
+
+		float tCell = 0.0f;
+		while (tCell <= closestDistance)
+		{
+			auto cell = m_Cells.find(GetCellKey(x, y));
+			if (cell != m_Cells.end())
+			{
+				for (uint32_t entryIndex : cell->second)
+					testEntry(entryIndex);
+			}
+
+			if (tNextX < tNextY)
+			{
+				tCell = tNextX;
+				tNextX += tDeltaX;
+				x += stepX;
+			}
+			else
+			{
+				tCell = tNextY;
+				tNextY += tDeltaY;
+				y += stepY;
+			}
+		}
+
+		if (hitDistance && closestEntity != entt::null)
+			*hitDistance = closestDistance;
+		return closestEntity;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <entt.hpp>
+
+namespace Pinecone
+{
+	/// <summary>
+	/// A 2D spatial index of entity bounds, used to find the entities in a region without looking at
+	/// every entity. It is a uniform grid of cells stored in a hash map, so only cells with entities in
+	/// them use memory and the world can be any size. Entities are added, moved and removed one at a
+	/// time and the grid is never rebuilt. Queries are not thread safe, even though they are const
+	/// </summary>
+	class SpatialIndex
+	{
+	public:
+		/// <summary>
+		/// The SpatialIndex constructor
+		/// </summary>
+		/// <param name="cellSize">The size of each grid cell in world units. Works best when it is a
+		/// little larger than most entities</param>
+		SpatialIndex(float cellSize = 4.0f);
+
+		/// <summary>
+		/// Add an entity to the index or move it if it is already in the index
+		/// </summary>
+		/// <param name="entity">The entity</param>
+		/// <param name="min">The bottom left corner of the entities bounds</param>
+		/// <param name="max">The top right corner of the entities bounds</param>
+		void Update(entt::entity entity, const glm::vec2& min, const glm::vec2& max);
+		/// <summary>
+		/// Remove an entity from the index. Does nothing if the entity is not in the index
+		/// </summary>
+		/// <param name="entity">The entity</param>
+		void Remove(entt::entity entity);
+		/// <summary>
+		/// Remove every entity from the index
+		/// </summary>
+		void Clear();
+
+		/// <summary>
+		/// Check if an entity is in the index
+		/// </summary>
+		/// <param name="entity">The entity</param>
+		/// <returns>True if the entity is in the index</returns>
+		bool Contains(entt::entity entity) const { return m_EntryLookup.find(entity) != m_EntryLookup.end(); }
+		/// <summary>
+		/// Get the number of entities in the index
+		/// </summary>
+		/// <returns>The number of entities</returns>
+		uint32_t GetEntityCount() const { return (uint32_t)m_Entries.size(); }
+
+		/// <summary>
+		/// Find every entity whose bounds overlap a box
+		/// </summary>
+		/// <param name="min">The bottom left corner of the box</param>
+		/// <param name="max">The top right corner of the box</param>
+		/// <param name="results">The entities that were found are added to this</param>
+		void QueryAABB(const glm::vec2& min, const glm::vec2& max, std::vector<entt::entity>& results) const;
+		/// <summary>
+		/// Find every entity whose bounds contain a point
+		/// </summary>
+		/// <param name="point">The point</param>
+		/// <param name="results">The entities that were found are added to this</param>
+		void QueryPoint(const glm::vec2& point, std::vector<entt::entity>& results) const;
+		/// <summary>
+		/// Find every entity whose bounds overlap a circle
+		/// </summary>
+		/// <param name="center">The center of the circle</param>
+		/// <param name="radius">The radius of the circle</param>
+		/// <param name="results">The entities that were found are added to this</param>
+		void QueryRadius(const glm::vec2& center, float radius, std::vector<entt::entity>& results) const;
+		/// <summary>
+		/// Find the first entity whose bounds are hit by a ray
+		/// </summary>
+		/// <param name="origin">The start of the ray</param>
+		/// <param name="direction">The direction of the ray, does not have to be normalized</param>
+		/// <param name="maxDistance">How far along the ray to look, must be finite</param>
+		/// <param name="hitDistance">Set to the distance along the ray of the hit, if not null</param>
+		/// <returns>The entity that was hit, or entt::null if nothing was hit</returns>
+		entt::entity Raycast(const glm::vec2& origin, const glm::vec2& direction, float maxDistance, float* hitDistance = nullptr) const;
+	private:
+		struct Entry
+		{
+			entt::entity Entity;
+			glm::vec2 Min;
+			glm::vec2 Max;
+			// The range of cells the entry is in: min x, min y, max x, max y
+			glm::ivec4 Cells;
+			// Entries that would cover too many cells are kept in a separate list instead
+			bool Oversized;
+			// The last query that looked at the entry, so an entry in several cells is only tested once
+			mutable uint32_t QueryStamp;
+		};
+
+		glm::ivec4 GetCellRange(const glm::vec2& min, const glm::vec2& max) const;
+		void AddToCells(uint32_t entryIndex);
+		void RemoveFromCells(uint32_t entryIndex);
+		void ReplaceInCells(uint32_t oldIndex, uint32_t newIndex);
+		void NextQueryStamp() const;
+
+		template<typename Func>
+		void ForEachCandidate(const glm::ivec4& cells, Func func) const;
+
+		static uint64_t GetCellKey(int32_t x, int32_t y) { return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y; }
+	private:
+		float m_CellSize;
+		float m_InverseCellSize;
+
+		std::vector<Entry> m_Entries;
+		std::unordered_map<entt::entity, uint32_t> m_EntryLookup;
+		std::unordered_map<uint64_t, std::vector<uint32_t>> m_Cells;
+		std::vector<uint32_t> m_OversizedEntries;
+
+		mutable uint32_t m_QueryStamp = 0;
+	};
+}
\ No newline at end of file
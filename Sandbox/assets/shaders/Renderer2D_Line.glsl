@@ -1,28 +1,62 @@
-// Basic line shader
+// Instanced line shader. Every instance is one line segment, which is expanded into a quad as wide
+// as the line in screen space. The fragment shader shapes the quad into a line with round ends
 
 #type vertex
 #version 450 core
 
-layout(location = 0) in vec3 a_Position;
-layout(location = 1) in vec4 a_Color;
+layout(location = 0) in vec3 a_Start;
+layout(location = 1) in vec3 a_End;
+layout(location = 2) in int a_Color;
+layout(location = 3) in float a_Width;
 
 layout(std140, binding = 0) uniform Camera
 {
 	mat4 u_ViewProjection;
+	vec2 u_ViewportSize;
 };
 
-struct VertexOutput
-{
-	vec4 Color;
-};
+layout(location = 0) out vec4 v_Color;
+// The position in pixels along (x) and across (y) the line, relative to the start of the line
+layout(location = 1) noperspective out vec2 v_LinePosition;
+// The length and half the width of the line in pixels
+layout(location = 2) flat out vec2 v_LineSize;
 
-layout (location = 0) out VertexOutput Output;
+// The corners of the two triangles that make up the quad. x picks the end of the line and y the side
+const vec2 c_LineCorners[6] = vec2[6](
+	vec2(0.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+	vec2(1.0, 1.0), vec2(0.0, 1.0), vec2(0.0, -1.0)
+);
 
 void main()
 {
-	Output.Color = a_Color;
+	vec4 clipStart = u_ViewProjection * vec4(a_Start, 1.0);
+	vec4 clipEnd = u_ViewProjection * vec4(a_End, 1.0);
+
+	// Work in pixels so the width of the line does not depend on the camera
+	vec2 screenStart = (clipStart.xy / clipStart.w * 0.5 + 0.5) * u_ViewportSize;
+	vec2 screenEnd = (clipEnd.xy / clipEnd.w * 0.5 + 0.5) * u_ViewportSize;
+
+	vec2 delta = screenEnd - screenStart;
+	float lineLength = length(delta);
+	vec2 direction = lineLength > 0.0001 ? delta / lineLength : vec2(1.0, 0.0);
+	vec2 normal = vec2(-direction.y, direction.x);
+
+	// Grow the quad by half the width past each end for the round ends, and by another pixel
+	// on every side for the anti-aliased edge
+	float halfWidth = a_Width * 0.5;
+	float extent = halfWidth + 1.0;
+
+	vec2 corner = c_LineCorners[gl_VertexID];
+	vec2 linePosition = vec2(mix(-extent, lineLength + extent, corner.x), corner.y * extent);
+	vec2 screenPosition = screenStart + direction * linePosition.x + normal * linePosition.y;
 
-	gl_Position = u_ViewProjection * vec4(a_Position, 1.0);
+	v_Color = unpackUnorm4x8(uint(a_Color));
+	v_LinePosition = linePosition;
+	v_LineSize = vec2(lineLength, halfWidth);
+
+	// Back to clip space, keeping the depth and w of the end the corner belongs to
+	vec4 clip = corner.x == 0.0 ? clipStart : clipEnd;
+	gl_Position = vec4((screenPosition / u_ViewportSize * 2.0 - 1.0) * clip.w, clip.z, clip.w);
 }
 
 #type fragment
@@ -30,14 +64,19 @@ void main()
 
 layout(location = 0) out vec4 o_Color;
 
-struct VertexOutput
-{
-	vec4 Color;
-};
-
-layout (location = 0) in VertexOutput Input;
+layout(location = 0) in vec4 v_Color;
+layout(location = 1) noperspective in vec2 v_LinePosition;
+layout(location = 2) flat in vec2 v_LineSize;
 
 void main()
 {
-	o_Color = Input.Color;
+	// Distance from the line segment, which is a capsule once the half width is taken away
+	float along = clamp(v_LinePosition.x, 0.0, v_LineSize.x);
+	float distance = length(v_LinePosition - vec2(along, 0.0));
+
+	float coverage = clamp(v_LineSize.y - distance + 0.5, 0.0, 1.0);
+	if (coverage == 0.0)
+		discard;
+
+	o_Color = vec4(v_Color.rgb, v_Color.a * coverage);
 }
@@ -0,0 +1,136 @@
+// Instanced quad shader. Every instance is one quad, the corners are generated from gl_VertexID.
+// Circles and rounded rectangles are instances as well, their shape is a signed distance field
+// evaluated for each pixel of the quad
+
+#type vertex
+#version 450 core
+
+layout(location = 0) in vec4 a_TransformRow0;
+layout(location = 1) in vec3 a_TransformRow1;
+layout(location = 2) in int a_Color;
+layout(location = 3) in vec4 a_TexRect;
+layout(location = 4) in int a_TexIndex;
+layout(location = 5) in float a_TilingFactor;
+layout(location = 6) in int a_Shape;
+
+layout(std140, binding = 0) uniform Camera
+{
+	mat4 u_ViewProjection;
+};
+
+struct VertexOutput
+{
+	vec4 Color;
+	vec2 TexCoord;
+	float TilingFactor;
+};
+
+layout(location = 0) out VertexOutput Output;
+layout(location = 3) out flat int v_TexIndex;
+// The position in the shape, in the same units as its size with the center at 0
+layout(location = 4) out vec2 v_LocalPosition;
+layout(location = 5) out flat vec2 v_Size;
+// The thickness, fade and corner radius of the shape
+layout(location = 6) out flat vec3 v_Params;
+layout(location = 7) out flat int v_Shape;
+
+// The corners of the two triangles that make up a quad, in the same order as the quad indices
+const vec2 c_QuadCorners[6] = vec2[6](
+	vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0),
+	vec2(1.0, 1.0), vec2(0.0, 1.0), vec2(0.0, 0.0)
+);
+
+void main()
+{
+	vec2 corner = c_QuadCorners[gl_VertexID];
+	vec3 localPosition = vec3(corner - 0.5, 1.0);
+
+	// The size of the shape is the length of each transformed axis
+	vec2 size = vec2(length(vec2(a_TransformRow0.x, a_TransformRow1.x)), length(vec2(a_TransformRow0.y, a_TransformRow1.y)));
+
+	Output.Color = unpackUnorm4x8(uint(a_Color));
+	Output.TexCoord = mix(a_TexRect.xy, a_TexRect.zw, corner);
+	Output.TilingFactor = a_TilingFactor;
+	v_TexIndex = a_TexIndex;
+	v_LocalPosition = localPosition.xy * size;
+	v_Size = size;
+	v_Params = a_TexRect.xyz;
+	v_Shape = a_Shape;
+
+	vec3 position = vec3(dot(a_TransformRow0.xyz, localPosition), dot(a_TransformRow1, localPosition), a_TransformRow0.w);
+	gl_Position = u_ViewProjection * vec4(position, 1.0);
+}
+
+#type fragment
+#version 450 core
+
+layout(location = 0) out vec4 o_Color;
+
+struct VertexOutput
+{
+	vec4 Color;
+	vec2 TexCoord;
+	float TilingFactor;
+};
+
+layout(location = 0) in VertexOutput Input;
+layout(location = 3) in flat int v_TexIndex;
+layout(location = 4) in vec2 v_LocalPosition;
+layout(location = 5) in flat vec2 v_Size;
+layout(location = 6) in flat vec3 v_Params;
+layout(location = 7) in flat int v_Shape;
+
+layout(binding = 0) uniform sampler2D u_Textures[32];
+
+const int c_Quad = 0;
+const int c_Circle = 1;
+const int c_RoundedRect = 2;
+
+// How much of the pixel the shape covers
+float GetShapeAlpha()
+{
+	vec2 halfSize = v_Size * 0.5;
+	float halfMin = min(halfSize.x, halfSize.y);
+
+	// Signed distance to the edge of the shape, negative inside
+	float distance;
+	if (v_Shape == c_Circle)
+	{
+		// Measured on the unit circle and scaled back, which keeps ellipses close enough
+		distance = (length(v_LocalPosition / halfSize) - 1.0) * halfMin;
+	}
+	else
+	{
+		float radius = min(v_Params.z, halfMin);
+		vec2 q = abs(v_LocalPosition) - halfSize + radius;
+		distance = length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - radius;
+	}
+
+	// Fade over at least one pixel so the edges are anti-aliased at any scale
+	float fade = max(v_Params.y * halfMin, fwidth(distance));
+	float alpha = 1.0 - smoothstep(-fade, 0.0, distance);
+
+	// Cut out the inside of rings and outlines
+	if (v_Params.x < 1.0)
+	{
+		float thickness = v_Params.x * halfMin;
+		alpha *= smoothstep(-thickness - fade, -thickness, distance);
+	}
+	return alpha;
+}
+
+void main()
+{
+	vec4 texColor = Input.Color;
+
+	// The shape is the same for every pixel of an instance, so the branch never diverges within it
+	if (v_Shape == c_Quad)
+		texColor *= texture(u_Textures[v_TexIndex], Input.TexCoord * Input.TilingFactor);
+	else
+		texColor.a *= GetShapeAlpha();
+
+	if (texColor.a == 0.0)
+		discard;
+
+	o_Color = texColor;
+}
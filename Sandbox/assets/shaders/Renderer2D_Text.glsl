@@ -4,6 +4,7 @@
 layout(location = 0) in vec3 a_Position;
 layout(location = 1) in vec4 a_Color;
 layout(location = 2) in vec2 a_TexCoord;
+layout(location = 3) in float a_AtlasIndex;
 
 layout(std140, binding = 0) uniform Camera
 {
@@ -17,11 +18,13 @@ struct VertexOutput
 };
 
 layout (location = 0) out VertexOutput Output;
+layout (location = 2) out flat float v_AtlasIndex;
 
 void main()
 {
 	Output.Color = a_Color;
 	Output.TexCoord = a_TexCoord;
+	v_AtlasIndex = a_AtlasIndex;
 
 	gl_Position = u_ViewProjection * vec4(a_Position, 1.0);
 }
@@ -38,12 +41,13 @@ struct VertexOutput
 };
 
 layout (location = 0) in VertexOutput Input;
+layout (location = 2) in flat float v_AtlasIndex;
 
-layout (binding = 0) uniform sampler2D u_FontAtlas;
+layout (binding = 0) uniform sampler2D u_FontAtlases[16];
 
-float screenPxRange() {
+float screenPxRange(int atlasIndex) {
 	const float pxRange = 2.0;
-    vec2 unitRange = vec2(pxRange) / vec2(textureSize(u_FontAtlas, 0));
+    vec2 unitRange = vec2(pxRange) / vec2(textureSize(u_FontAtlases[atlasIndex], 0));
     vec2 screenTexSize = vec2(1.0) / fwidth(Input.TexCoord);
     return max(0.5*dot(unitRange, screenTexSize), 1.0);
 }
@@ -54,11 +58,11 @@ float median(float r, float g, float b) {
 
 void main()
 {
-	vec4 texColor = Input.Color * texture(u_FontAtlas, Input.TexCoord);
+	int atlasIndex = int(v_AtlasIndex);
 
-	vec3 msd = texture(u_FontAtlas, Input.TexCoord).rgb;
+	vec3 msd = texture(u_FontAtlases[atlasIndex], Input.TexCoord).rgb;
     float sd = median(msd.r, msd.g, msd.b);
-    float screenPxDistance = screenPxRange()*(sd - 0.5);
+    float screenPxDistance = screenPxRange(atlasIndex)*(sd - 0.5);
     float opacity = clamp(screenPxDistance + 0.5, 0.0, 1.0);
 	if (opacity == 0.0)
 		discard;
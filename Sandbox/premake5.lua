@@ -19,7 +19,9 @@ project "Sandbox"
 		"%{wks.location}/Pinecone/src",
 		"%{wks.location}/Pinecone/vendor",
 		"%{IncludeDir.glm}",
-		"%{IncludeDir.entt}"
+		"%{IncludeDir.entt}",
+		"%{IncludeDir.msdfgen}",
+		"%{IncludeDir.msdf_atlas_gen}"
 	}
 
 	links
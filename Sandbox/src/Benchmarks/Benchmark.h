@@ -0,0 +1,82 @@
+#pragma once
+
+#include <Pinecone.h>
+
+#include <chrono>
+
+using namespace Pinecone;
+
+namespace Sandbox
+{
+	/// <summary>
+	/// The results of a benchmark, one line per measurement
+	/// </summary>
+	class BenchmarkReport
+	{
+	public:
+		/// <summary>
+		/// Add a line to the report, formatted like printf. The line is logged as well
+		/// </summary>
+		/// <param name="format">The printf format string</param>
+		/// <param name="args">The values to format</param>
+		template<typename... Args>
+		void Add(const char* format, Args... args)
+		{
+			char line[256];
+			snprintf(line, sizeof(line), format, args...);
+			PC_INFO("{0}", line);
+			m_Lines.emplace_back(line);
+		}
+
+		const std::vector<std::string>& GetLines() const { return m_Lines; }
+		void Clear() { m_Lines.clear(); }
+	private:
+		std::vector<std::string> m_Lines;
+	};
+
+	/// <summary>
+	/// Run a function a number of times and get the average time it took
+	/// </summary>
+	/// <param name="iterations">The number of times to run the function</param>
+	/// <param name="func">The function to time</param>
+	/// <returns>The average time of one run (in milliseconds)</returns>
+	template<typename Func>
+	double MeasureMilliseconds(uint32_t iterations, Func func)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < iterations; i++)
+			func();
+		auto end = std::chrono::steady_clock::now();
+
+		return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+	}
+
+	// The benchmarks. Renderer benchmarks draw into the framebuffer bound by the benchmark layer
+
+	/// <summary>
+	/// Textured quads drawn with one texture and with 31 textures in random order, which measures
+	/// the cost of finding the texture slot of each quad
+	/// </summary>
+	void RunTextureSlotBenchmark(BenchmarkReport& report);
+	/// <summary>
+	/// Rotated quads drawn with a transform matrix, with a position, size and rotation and as one
+	/// bulk DrawQuads call, which measures how fast quad corners are made
+	/// </summary>
+	void RunQuadBenchmark(BenchmarkReport& report);
+	/// <summary>
+	/// A long string of printable characters drawn with the default font, which measures the
+	/// glyph and kerning lookups of DrawString. The same lookups made with msdf-atlas-gen
+	/// getGlyph and getAdvance, as fonts did before the glyph table, are measured as the reference
+	/// </summary>
+	void RunStringBenchmark(BenchmarkReport& report);
+	/// <summary>
+	/// The scenes spatial index with 10k, 100k and 1M entities: building it, moving entities and each
+	/// kind of query, next to a brute force box query. Also the cost of the scenes transform update pass
+	/// </summary>
+	void RunSpatialIndexBenchmark(BenchmarkReport& report);
+	/// <summary>
+	/// The cost of scheduling an empty job, a continuation and a ParallelFor batch, and how a
+	/// ParallelFor over heavy work scales with the number of worker threads
+	/// </summary>
+	void RunJobSystemBenchmark(BenchmarkReport& report);
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "BenchmarkLayer.h"
+
+#include <imgui/imgui.h>
+
+namespace Sandbox
+{
+	struct BenchmarkEntry
+	{
+		const char* Name;
+		void(*Run)(BenchmarkReport&);
+	};
+
+	static const BenchmarkEntry s_Benchmarks[] =
+	{
+		{ "Texture Slots", RunTextureSlotBenchmark },
+		{ "Quads", RunQuadBenchmark },
+		{ "Strings", RunStringBenchmark },
+		{ "Spatial Index", RunSpatialIndexBenchmark },
+		{ "Job System", RunJobSystemBenchmark },
+	};
+
+	BenchmarkLayer::BenchmarkLayer()
+		: Layer("BenchmarkLayer")
+	{
+	}
+
+	void BenchmarkLayer::OnAttach()
+	{
+		PC_PROFILE_FUNCTION();
+
+		FramebufferSpecification fbSpec;
+		fbSpec.Attachments = { FramebufferTextureFormat::RGBA8, FramebufferTextureFormat::Depth };
+		fbSpec.Width = 1280;
+		fbSpec.Height = 720;
+		m_Framebuffer = Framebuffer::Create(fbSpec);
+	}
+
+	void BenchmarkLayer::OnUpdate(Timestep ts)
+	{
+		PC_PROFILE_FUNCTION();
+
+		if (m_PendingBenchmark < 0)
+			return;
+
+		const BenchmarkEntry& benchmark = s_Benchmarks[m_PendingBenchmark];
+		m_PendingBenchmark = -1;
+
+		m_Report.Clear();
+		PC_INFO("Running benchmark: {0}", benchmark.Name);
+
+		m_Framebuffer->Bind();
+		RenderCommand::Clear();
+
+		benchmark.Run(m_Report);
+
+		m_Framebuffer->Unbind();
+	}
+
+	void BenchmarkLayer::OnImGuiRender()
+	{
+		PC_PROFILE_FUNCTION();
+
+		ImGui::Begin("Benchmarks");
+
+		for (int i = 0; i < (int)(sizeof(s_Benchmarks) / sizeof(s_Benchmarks[0])); i++)
+		{
+			if (ImGui::Button(s_Benchmarks[i].Name))
+				m_PendingBenchmark = i;
+		}
+
+		ImGui::Separator();
+		for (const std::string& line : m_Report.GetLines())
+			ImGui::TextUnformatted(line.c_str());
+
+		ImGui::End();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Benchmark.h"
+
+namespace Sandbox
+{
+	/// <summary>
+	/// Runs the engine benchmarks from the "Benchmarks" window. A benchmark starts at the beginning
+	/// of the frame after its button is pressed, its results are shown in the window and logged
+	/// </summary>
+	class BenchmarkLayer : public Layer
+	{
+	public:
+		BenchmarkLayer();
+		~BenchmarkLayer() = default;
+
+		void OnAttach() override;
+
+		void OnUpdate(Timestep ts) override;
+		void OnImGuiRender() override;
+	private:
+		// Renderer benchmarks draw into their own framebuffer, so the frame of the sandbox is not touched
+		Ref<Framebuffer> m_Framebuffer;
+
+		BenchmarkReport m_Report;
+		// The index of the benchmark to run in the next update, -1 for none
+		int m_PendingBenchmark = -1;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include "Benchmark.h"
+
+#include <thread>
+
+namespace Sandbox
+{
+	// Enough arithmetic per item that the work, not the scheduling, decides the time
+	static float DoWork(uint32_t item)
+	{
+		float value = (float)item;
+		for (uint32_t i = 0; i < 256; i++)
+			value = std::sqrt(value * 1.0001f + 1.0f);
+		return value;
+	}
+
+	static void RunSchedulingOverhead(BenchmarkReport& report)
+	{
+		PC_PROFILE_FUNCTION();
+
+		const uint32_t jobCount = 100000;
+		double schedule = MeasureMilliseconds(10, [&]()
+		{
+			JobCounter counter;
+			for (uint32_t i = 0; i < jobCount; i++)
+				JobSystem::Schedule([]() {}, &counter);
+			JobSystem::Wait(counter);
+		});
+
+		// Every job is a continuation of the one before it, so they run one after another
+		const uint32_t chainLength = 1000;
+		double chain = MeasureMilliseconds(10, [&]()
+		{
+			std::vector<JobCounter> counters(chainLength);
+			JobSystem::Schedule([]() {}, &counters[0]);
+			for (uint32_t i = 1; i < chainLength; i++)
+				JobSystem::ScheduleAfter(counters[i - 1], []() {}, &counters[i]);
+			for (JobCounter& counter : counters)
+				JobSystem::Wait(counter);
+		});
+
+		double parallelFor = MeasureMilliseconds(10, [&]()
+		{
+			JobSystem::ParallelFor(jobCount, 1, [](uint32_t begin, uint32_t end) {});
+		});
+
+		report.Add("%u workers: empty job %.0f ns, continuation %.0f ns, ParallelFor batch %.0f ns", JobSystem::GetWorkerCount(),
+			schedule * 1e6 / jobCount, chain * 1e6 / chainLength, parallelFor * 1e6 / jobCount);
+	}
+
+	static double MeasureParallelWork(std::vector<float>& results)
+	{
+		return MeasureMilliseconds(5, [&]()
+		{
+			JobSystem::ParallelFor((uint32_t)results.size(), 0, [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; i++)
+					results[i] = DoWork(i);
+			});
+		});
+	}
+
+	void RunJobSystemBenchmark(BenchmarkReport& report)
+	{
+		PC_PROFILE_FUNCTION();
+
+		RunSchedulingOverhead(report);
+
+		std::vector<float> results(50000);
+		double serial = MeasureMilliseconds(5, [&]()
+		{
+			for (uint32_t i = 0; i < (uint32_t)results.size(); i++)
+				results[i] = DoWork(i);
+		});
+		report.Add("Serial: %.2f ms", serial);
+
+		// The job system is started again with each worker count. Shutdown runs the jobs that are
+		// still queued, so nothing scheduled before the benchmark is lost
+		const uint32_t workerCount = JobSystem::GetWorkerCount();
+		const uint32_t hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+		for (uint32_t workers = 1; workers < hardwareThreads; workers *= 2)
+		{
+			JobSystem::Shutdown();
+			JobSystem::Init(workers);
+
+			double parallel = MeasureParallelWork(results);
+			report.Add("%u workers: %.2f ms, %.2fx serial", workers, parallel, serial / parallel);
+		}
+
+		JobSystem::Shutdown();
+		JobSystem::Init(workerCount);
+
+		double parallel = MeasureParallelWork(results);
+		report.Add("%u workers (default): %.2f ms, %.2fx serial", workerCount, parallel, serial / parallel);
+	}
+}
\ No newline at end of file
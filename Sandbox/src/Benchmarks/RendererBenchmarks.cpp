@@ -0,0 +1,320 @@
+#include "Benchmark.h"
+
+#include <Pinecone/Renderer/Font.h>
+
+#undef INFINITE
+#include <msdf-atlas-gen.h>
+
+#include <random>
+
+namespace Sandbox
+{
+	static const uint32_t s_QuadCount = 200000;
+	static const uint32_t s_FrameCount = 10;
+
+	static SceneCamera CreateBenchmarkCamera()
+	{
+		SceneCamera camera;
+		camera.SetViewportSize(1280, 720);
+		camera.SetOrthographic(10.0f, -1.0f, 1.0f);
+		return camera;
+	}
+
+	// Lay the quads out in a 100x100 grid, so they cover the view of the benchmark camera
+	static glm::vec2 GetGridPosition(uint32_t index)
+	{
+		return { (float)(index % 100) * 0.1f - 5.0f, (float)(index / 100 % 100) * 0.1f - 5.0f };
+	}
+
+	void RunTextureSlotBenchmark(BenchmarkReport& report)
+	{
+		PC_PROFILE_FUNCTION();
+
+		// 31 textures and the white texture fill every texture slot of a batch
+		TextureSpecification spec;
+		spec.GenerateMips = false;
+
+		std::vector<Ref<Texture2D>> textures;
+		for (uint32_t i = 0; i < 31; i++)
+		{
+			uint32_t pixel = 0xff000000 | (i * 0x00080808);
+			Ref<Texture2D> texture = Texture2D::Create(spec);
+			texture->SetData(&pixel, sizeof(pixel));
+			textures.push_back(texture);
+		}
+
+		std::mt19937 random(1234);
+		std::vector<uint32_t> order(s_QuadCount);
+		for (uint32_t& index : order)
+			index = random() % (uint32_t)textures.size();
+
+		SceneCamera camera = CreateBenchmarkCamera();
+		auto drawFrame = [&](bool mixed)
+		{
+			Renderer2D::BeginScene(camera, glm::mat4(1.0f));
+			for (uint32_t i = 0; i < s_QuadCount; i++)
+				Renderer2D::DrawQuad(GetGridPosition(i), { 0.1f, 0.1f }, textures[mixed ? order[i] : 0]);
+			Renderer2D::EndScene();
+		};
+
+		drawFrame(true); // Warm up
+		double single = MeasureMilliseconds(s_FrameCount, [&]() { drawFrame(false); });
+		double mixed = MeasureMilliseconds(s_FrameCount, [&]() { drawFrame(true); });
+
+		report.Add("%u textured quads per frame, %u frames", s_QuadCount, s_FrameCount);
+		report.Add("1 texture:   %.1f ns/quad", single * 1e6 / s_QuadCount);
+		report.Add("31 textures: %.1f ns/quad", mixed * 1e6 / s_QuadCount);
+		report.Add("Slot lookup: %.1f ns/quad", (mixed - single) * 1e6 / s_QuadCount);
+	}
+
+	void RunQuadBenchmark(BenchmarkReport& report)
+	{
+		PC_PROFILE_FUNCTION();
+
+		std::vector<QuadInstance> quads(s_QuadCount);
+		std::vector<glm::mat4> transforms(s_QuadCount);
+		for (uint32_t i = 0; i < s_QuadCount; i++)
+		{
+			QuadInstance& quad = quads[i];
+			quad.Position = glm::vec3(GetGridPosition(i), 0.0f);
+			quad.Size = { 0.1f, 0.1f };
+			quad.Rotation = (float)i * 0.01f;
+			quad.Color = { 1.0f, (float)(i % 256) / 255.0f, 0.5f, 1.0f };
+
+			transforms[i] = glm::translate(glm::mat4(1.0f), quad.Position)
+				* glm::rotate(glm::mat4(1.0f), quad.Rotation, { 0.0f, 0.0f, 1.0f })
+				* glm::scale(glm::mat4(1.0f), { quad.Size.x, quad.Size.y, 1.0f });
+		}
+
+		SceneCamera camera = CreateBenchmarkCamera();
+		auto measure = [&](auto draw)
+		{
+			return MeasureMilliseconds(s_FrameCount, [&]()
+			{
+				Renderer2D::BeginScene(camera, glm::mat4(1.0f));
+				draw();
+				Renderer2D::EndScene();
+			});
+		};
+
+		measure([&]() { Renderer2D::DrawQuads(quads); }); // Warm up
+		double matrix = measure([&]()
+		{
+			for (uint32_t i = 0; i < s_QuadCount; i++)
+				Renderer2D::DrawQuad(transforms[i], quads[i].Color);
+		});
+		double rotated = measure([&]()
+		{
+			for (const QuadInstance& quad : quads)
+				Renderer2D::DrawRotatedQuad(quad.Position, quad.Size, quad.Rotation, quad.Color);
+		});
+		double bulk = measure([&]() { Renderer2D::DrawQuads(quads); });
+
+		report.Add("%u rotated quads per frame, %u frames", s_QuadCount, s_FrameCount);
+		report.Add("DrawQuad (matrix):  %.0f quads/ms", s_QuadCount / matrix);
+		report.Add("DrawRotatedQuad:    %.0f quads/ms", s_QuadCount / rotated);
+		report.Add("DrawQuads (bulk):   %.0f quads/ms", s_QuadCount / bulk);
+	}
+
+	/// <summary>
+	/// The glyph geometry of a font loaded with msdf-atlas-gen, the way fonts were loaded before the
+	/// glyph table. Used as the reference for the glyph lookups of DrawString
+	/// </summary>
+	struct ReferenceFontGeometry
+	{
+		std::vector<msdf_atlas::GlyphGeometry> Glyphs;
+		msdf_atlas::FontGeometry FontGeometry{ &Glyphs };
+
+		bool Load(const char* filepath)
+		{
+			msdfgen::FreetypeHandle* ft = msdfgen::initializeFreetype();
+			msdfgen::FontHandle* font = ft ? msdfgen::loadFont(ft, filepath) : nullptr;
+			if (!font)
+			{
+				if (ft)
+					msdfgen::deinitializeFreetype(ft);
+				return false;
+			}
+
+			// Packed with the same settings as Font, so every glyph has its atlas and plane bounds
+			FontGeometry.loadCharset(font, 1.0, msdf_atlas::Charset::ASCII);
+			msdf_atlas::TightAtlasPacker atlasPacker;
+			atlasPacker.setPixelRange(2.0);
+			atlasPacker.setMiterLimit(1.0);
+			atlasPacker.setPadding(0);
+			atlasPacker.setScale(40.0);
+			atlasPacker.pack(Glyphs.data(), (int)Glyphs.size());
+
+			msdfgen::destroyFont(font);
+			msdfgen::deinitializeFreetype(ft);
+			return true;
+		}
+	};
+
+	// Build the glyph quads of a string into a buffer with msdf-atlas-gen getGlyph and getAdvance lookups
+	static void BuildReferenceGlyphQuads(const std::string& string, const msdf_atlas::FontGeometry& fontGeometry, const glm::mat4& transform, std::vector<glm::vec4>& corners)
+	{
+		const auto& metrics = fontGeometry.getMetrics();
+		double fsScale = 1.0 / (metrics.ascenderY - metrics.descenderY);
+		double x = 0.0;
+		double y = 0.0;
+
+		for (size_t i = 0; i < string.size(); i++)
+		{
+			char character = string[i];
+			if (character == '\r')
+				continue;
+
+			if (character == '\n')
+			{
+				x = 0.0;
+				y -= fsScale * metrics.lineHeight;
+				continue;
+			}
+
+			auto glyph = fontGeometry.getGlyph(character);
+			if (!glyph)
+				glyph = fontGeometry.getGlyph('?');
+			if (!glyph)
+				return;
+			if (character == '\t')
+				glyph = fontGeometry.getGlyph(' ');
+
+			double al, ab, ar, at;
+			glyph->getQuadAtlasBounds(al, ab, ar, at);
+			double pl, pb, pr, pt;
+			glyph->getQuadPlaneBounds(pl, pb, pr, pt);
+			glm::vec2 quadMin((float)(pl * fsScale + x), (float)(pb * fsScale + y));
+			glm::vec2 quadMax((float)(pr * fsScale + x), (float)(pt * fsScale + y));
+
+			corners.push_back(transform * glm::vec4(quadMin, 0.0f, 1.0f));
+			corners.push_back(transform * glm::vec4(quadMin.x, quadMax.y, 0.0f, 1.0f));
+			corners.push_back(transform * glm::vec4(quadMax, 0.0f, 1.0f));
+			corners.push_back(transform * glm::vec4(quadMax.x, quadMin.y, 0.0f, 1.0f));
+			corners.push_back({ (float)al, (float)ab, (float)ar, (float)at });
+
+			if (i < string.size() - 1)
+			{
+				double advance = glyph->getAdvance();
+				fontGeometry.getAdvance(advance, character, string[i + 1]);
+				x += fsScale * advance;
+			}
+		}
+	}
+
+	// Build the glyph quads of a string into a buffer with the glyph table of a font, the lookups DrawString makes
+	static void BuildGlyphQuads(const std::string& string, const Font& font, const glm::mat4& transform, std::vector<glm::vec4>& corners)
+	{
+		const int32_t fallbackGlyph = font.GetGlyphIndex('?');
+		if (fallbackGlyph < 0)
+			return;
+		const int32_t spaceGlyph = font.GetGlyphIndex(' ');
+		float x = 0.0f;
+		float y = 0.0f;
+
+		for (size_t i = 0; i < string.size(); i++)
+		{
+			char character = string[i];
+			if (character == '\r')
+				continue;
+
+			if (character == '\n')
+			{
+				x = 0.0f;
+				y -= font.GetLineHeight();
+				continue;
+			}
+
+			int32_t glyphIndex = font.GetGlyphIndex((uint8_t)character);
+			bool kerning = glyphIndex >= 0;
+			if (character == '\t')
+			{
+				glyphIndex = spaceGlyph;
+				kerning = false;
+			}
+			else if (glyphIndex < 0)
+				glyphIndex = fallbackGlyph;
+
+			const FontGlyph& glyph = font.GetGlyph((uint32_t)glyphIndex);
+			glm::vec2 quadMin = glyph.QuadMin + glm::vec2(x, y);
+			glm::vec2 quadMax = glyph.QuadMax + glm::vec2(x, y);
+
+			corners.push_back(transform * glm::vec4(quadMin, 0.0f, 1.0f));
+			corners.push_back(transform * glm::vec4(quadMin.x, quadMax.y, 0.0f, 1.0f));
+			corners.push_back(transform * glm::vec4(quadMax, 0.0f, 1.0f));
+			corners.push_back(transform * glm::vec4(quadMax.x, quadMin.y, 0.0f, 1.0f));
+			corners.push_back({ glyph.TexCoordMin, glyph.TexCoordMax });
+
+			if (i < string.size() - 1)
+			{
+				x += glyph.Advance;
+				int32_t nextGlyph = font.GetGlyphIndex((uint8_t)string[i + 1]);
+				if (kerning && nextGlyph >= 0)
+					x += font.GetKerning((uint32_t)glyphIndex, (uint32_t)nextGlyph);
+			}
+		}
+	}
+
+	void RunStringBenchmark(BenchmarkReport& report)
+	{
+		PC_PROFILE_FUNCTION();
+
+		// Every printable ASCII character in turn, with a line break every 100 characters
+		const uint32_t charCount = 5000;
+		std::string string;
+		string.reserve(charCount);
+		for (uint32_t i = 0; i < charCount; i++)
+			string += i % 100 == 99 ? '\n' : (char)(' ' + i % 95);
+
+		Ref<Font> font = Font::GetDefault();
+		glm::mat4 transform = glm::translate(glm::mat4(1.0f), { -5.0f, 5.0f, 0.0f }) * glm::scale(glm::mat4(1.0f), { 0.1f, 0.1f, 1.0f });
+
+		SceneCamera camera = CreateBenchmarkCamera();
+		const uint32_t stringCount = 40;
+		auto drawFrame = [&]()
+		{
+			Renderer2D::BeginScene(camera, glm::mat4(1.0f));
+			for (uint32_t i = 0; i < stringCount; i++)
+				Renderer2D::DrawString(string, font, transform, glm::vec4(1.0f));
+			Renderer2D::EndScene();
+		};
+
+		drawFrame(); // Warm up
+		double frame = MeasureMilliseconds(s_FrameCount, drawFrame);
+
+		// The lookups alone, without drawing, with the glyph table and with msdf-atlas-gen as the reference
+		std::vector<glm::vec4> corners;
+		corners.reserve((size_t)charCount * 5);
+		double table = MeasureMilliseconds(s_FrameCount, [&]()
+		{
+			for (uint32_t i = 0; i < stringCount; i++)
+			{
+				corners.clear();
+				BuildGlyphQuads(string, *font, transform, corners);
+			}
+		});
+
+		uint32_t glyphCount = stringCount * charCount;
+		report.Add("%u characters per frame, %u frames", glyphCount, s_FrameCount);
+		report.Add("DrawString:                 %.1f ns/glyph", frame * 1e6 / glyphCount);
+		report.Add("Glyph table lookups:        %.1f ns/glyph", table * 1e6 / glyphCount);
+
+		const char* fontPath = "assets/fonts/opensans/OpenSans-Regular.ttf";
+		ReferenceFontGeometry reference;
+		if (!reference.Load(fontPath))
+		{
+			report.Add("Reference font %s failed to load", fontPath);
+			return;
+		}
+
+		double msdf = MeasureMilliseconds(s_FrameCount, [&]()
+		{
+			for (uint32_t i = 0; i < stringCount; i++)
+			{
+				corners.clear();
+				BuildReferenceGlyphQuads(string, reference.FontGeometry, transform, corners);
+			}
+		});
+		report.Add("msdf-atlas-gen lookups:     %.1f ns/glyph (reference)", msdf * 1e6 / glyphCount);
+	}
+}
\ No newline at end of file
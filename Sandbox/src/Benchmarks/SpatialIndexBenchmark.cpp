@@ -0,0 +1,126 @@
+#include "Benchmark.h"
+
+#include <random>
+
+namespace Sandbox
+{
+	struct EntityBounds
+	{
+		glm::vec2 Min;
+		glm::vec2 Max;
+	};
+
+	static void RunSpatialIndexSize(BenchmarkReport& report, uint32_t entityCount)
+	{
+		PC_PROFILE_FUNCTION();
+
+		// 1x1 entities at about one per 4 square units
+		const float worldSize = std::sqrt((float)entityCount * 4.0f);
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> position(0.0f, worldSize);
+
+		std::vector<EntityBounds> bounds(entityCount);
+		for (EntityBounds& entity : bounds)
+		{
+			entity.Min = { position(random), position(random) };
+			entity.Max = entity.Min + glm::vec2(1.0f);
+		}
+
+		SpatialIndex index;
+		double build = MeasureMilliseconds(1, [&]()
+		{
+			for (uint32_t i = 0; i < entityCount; i++)
+				index.Update((entt::entity)i, bounds[i].Min, bounds[i].Max);
+		});
+
+		// Move 1% of the entities a short distance, like a frame of a game
+		const uint32_t moveCount = std::max(entityCount / 100, 1u);
+		std::uniform_int_distribution<uint32_t> pick(0, entityCount - 1);
+		double move = MeasureMilliseconds(10, [&]()
+		{
+			for (uint32_t i = 0; i < moveCount; i++)
+			{
+				uint32_t e = pick(random);
+				bounds[e].Min += glm::vec2(0.1f);
+				bounds[e].Max += glm::vec2(0.1f);
+				index.Update((entt::entity)e, bounds[e].Min, bounds[e].Max);
+			}
+		});
+
+		// A 1280x720 view 20 units wide in the middle of the world
+		const glm::vec2 center = glm::vec2(worldSize * 0.5f);
+		const glm::vec2 viewMin = center - glm::vec2(10.0f, 5.625f);
+		const glm::vec2 viewMax = center + glm::vec2(10.0f, 5.625f);
+
+		std::vector<entt::entity> results;
+		const uint32_t queryCount = 100;
+		double viewport = MeasureMilliseconds(queryCount, [&]()
+		{
+			results.clear();
+			index.QueryAABB(viewMin, viewMax, results);
+		});
+		double brute = MeasureMilliseconds(queryCount, [&]()
+		{
+			results.clear();
+			for (uint32_t i = 0; i < entityCount; i++)
+			{
+				if (bounds[i].Min.x <= viewMax.x && bounds[i].Max.x >= viewMin.x && bounds[i].Min.y <= viewMax.y && bounds[i].Max.y >= viewMin.y)
+					results.push_back((entt::entity)i);
+			}
+		});
+		double point = MeasureMilliseconds(queryCount, [&]()
+		{
+			results.clear();
+			index.QueryPoint(center, results);
+		});
+		double radius = MeasureMilliseconds(queryCount, [&]()
+		{
+			results.clear();
+			index.QueryRadius(center, 5.0f, results);
+		});
+		double ray = MeasureMilliseconds(queryCount, [&]()
+		{
+			index.Raycast(center, glm::normalize(glm::vec2(1.0f, 0.3f)), 50.0f);
+		});
+
+		report.Add("%7u  build %.1f ms, move 1%% %.3f ms", entityCount, build, move);
+		report.Add("         viewport %.1f us (brute force %.1f us), point %.1f us, radius 5 %.1f us, ray 50 %.1f us",
+			viewport * 1000.0, brute * 1000.0, point * 1000.0, radius * 1000.0, ray * 1000.0);
+	}
+
+	// The transform update pass only visits the transforms that changed, so once the first update has placed
+	// every game object an update with nothing moved should cost next to nothing
+	static void RunSceneUpdateSize(BenchmarkReport& report, uint32_t gameObjectCount)
+	{
+		PC_PROFILE_FUNCTION();
+
+		const float worldSize = std::sqrt((float)gameObjectCount * 4.0f);
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> position(0.0f, worldSize);
+
+		Scene scene;
+		for (uint32_t i = 0; i < gameObjectCount; i++)
+		{
+			GameObject gameObject = scene.CreateGameObject();
+			gameObject.GetComponent<TransformComponent>().SetTranslation({ position(random), position(random), 0.0f });
+			gameObject.AddComponent<SpriteComponent>();
+		}
+
+		const glm::vec2 center = glm::vec2(worldSize * 0.5f);
+		double first = MeasureMilliseconds(1, [&]() { scene.QueryPoint(center); });
+		double still = MeasureMilliseconds(10, [&]() { scene.QueryPoint(center); });
+
+		report.Add("%7u  scene first update %.2f ms, update with nothing moved %.3f ms", gameObjectCount, first, still);
+	}
+
+	void RunSpatialIndexBenchmark(BenchmarkReport& report)
+	{
+		PC_PROFILE_FUNCTION();
+
+		for (uint32_t entityCount : { 10000u, 100000u, 1000000u })
+			RunSpatialIndexSize(report, entityCount);
+
+		for (uint32_t gameObjectCount : { 10000u, 100000u })
+			RunSceneUpdateSize(report, gameObjectCount);
+	}
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <Pinecone/Core/EntryPoint.h>
 
 #include "SandboxLayer.h"
+#include "Benchmarks/BenchmarkLayer.h"
 
 using namespace Pinecone;
 
@@ -14,6 +15,7 @@ namespace Sandbox
 			: Application()
 		{
 			PushLayer(new SandboxLayer());
+			PushLayer(new BenchmarkLayer());
 		}
 	};
 }
@@ -24,11 +24,14 @@ namespace Sandbox
 		fbSpec.Height = 720;
 		m_Framebuffer = Framebuffer::Create(fbSpec); 
 
-		m_PineconeTexture = Texture2D::Create("assets/textures/pinecone.png");
-		m_TreeTexture = Texture2D::Create(TextureSpecification(TextureFilter::NEAREST), "assets/textures/tree.png");
+		m_PineconeTexture = AssetManager::LoadTexture("assets/textures/pinecone.png", true);
+		m_TreeTexture = AssetManager::LoadTexture(TextureSpecification(TextureFilter::NEAREST), "assets/textures/tree.png", true);
 
 		RenderCommand::SetClearColor({ 0.2f, 0.2f, 0.2f, 1.0f });
 
+		// One recording context for every thread that can run jobs
+		Renderer2D::SetRecordingContextCount(JobSystem::GetWorkerCount() + 1);
+
 		m_ActiveScene = CreateRef<Scene>();
 
 		m_Square = m_ActiveScene->CreateGameObject("Pinecone");
@@ -55,6 +58,8 @@ namespace Sandbox
 
 	void SandboxLayer::OnDetach()
 	{
+		AssetManager::Release(m_PineconeTexture);
+		AssetManager::Release(m_TreeTexture);
 	}
 
 	void SandboxLayer::OnUpdate(Timestep ts)
@@ -71,14 +76,13 @@ namespace Sandbox
 			m_Framebuffer->Resize((uint32_t)m_ViewportSize.x, (uint32_t)m_ViewportSize.y);
 		}
 
-		auto& pineconeTransform = m_Square.GetComponent<TransformComponent>();
 		if (Input::IsKeyPressed(Key::Q))
 		{
-			pineconeTransform.Rotation += glm::radians(glm::vec3{ 0.0f, 0.0f, 45.0f } * (float)ts);
+			m_Square.PatchComponent<TransformComponent>([&](auto& transform) { transform.Rotation += glm::radians(glm::vec3{ 0.0f, 0.0f, 45.0f } * (float)ts); });
 		}
 		if (Input::IsKeyPressed(Key::E))
 		{
-			pineconeTransform.Rotation -= glm::radians(glm::vec3{ 0.0f, 0.0f, 45.0f } * (float)ts);
+			m_Square.PatchComponent<TransformComponent>([&](auto& transform) { transform.Rotation -= glm::radians(glm::vec3{ 0.0f, 0.0f, 45.0f } * (float)ts); });
 		}
 
 		Renderer2D::ResetStats();
@@ -94,6 +98,27 @@ namespace Sandbox
 
 		Renderer2D::DrawString("Hello World!", Font::GetDefault(), glm::mat4(1.0f), glm::vec4(1.0f));
 
+		if (m_RecordedGrid)
+		{
+			// Each job records a band of rows into its own context, EndScene merges them in order
+			const uint32_t gridSize = 100;
+			const uint32_t contextCount = Renderer2D::GetRecordingContextCount();
+			JobSystem::ParallelFor(contextCount, [=](uint32_t contextIndex)
+			{
+				Renderer2D::BeginRecording(contextIndex);
+				for (uint32_t y = contextIndex * gridSize / contextCount; y < (contextIndex + 1) * gridSize / contextCount; y++)
+				{
+					for (uint32_t x = 0; x < gridSize; x++)
+					{
+						glm::vec2 position = { (float)x * 0.1f - 5.0f, (float)y * 0.1f - 5.0f };
+						glm::vec4 color = { (float)x / gridSize, (float)y / gridSize, 1.0f, 0.25f };
+						Renderer2D::DrawQuad(position, { 0.08f, 0.08f }, color);
+					}
+				}
+				Renderer2D::EndRecording();
+			});
+		}
+
 		Renderer2D::EndScene();
 
 		m_Framebuffer->Unbind();
@@ -175,8 +200,17 @@ namespace Sandbox
 		ImGui::Text("Renderer2D Stats:");
 		ImGui::Text("Draw Calls: %d", stats.DrawCalls);
 		ImGui::Text("Quads: %d", stats.QuadCount);
+		ImGui::Text("Lines: %d", stats.LineCount);
+		ImGui::Text("Culled: %d", stats.CulledCount);
 		ImGui::Text("Vertices: %d", stats.GetTotalVertexCount());
 		ImGui::Text("Indices: %d", stats.GetTotalIndexCount());
+		ImGui::Text("Batch Breaks Removed: %d", stats.BatchBreaksRemoved);
+		ImGui::Text("Textures Loading: %d", TextureStreamer::GetPendingCount());
+
+		bool retained = m_ActiveScene->IsRetainedRendering();
+		if (ImGui::Checkbox("Retained Sprites", &retained))
+			m_ActiveScene->SetRetainedRendering(retained);
+		ImGui::Checkbox("Recorded Grid", &m_RecordedGrid);
 
 		ImGui::End();
 
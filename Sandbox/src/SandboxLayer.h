@@ -26,8 +26,8 @@ namespace Sandbox
 		bool OnKeyPressed(KeyPressedEvent& e);
 		bool OnWindowResized(WindowResizeEvent& e);
 	private:
-		Ref<Texture2D> m_PineconeTexture;
-		Ref<Texture2D> m_TreeTexture;
+		TextureHandle m_PineconeTexture;
+		TextureHandle m_TreeTexture;
 
 		Ref<Scene> m_ActiveScene;
 		Ref<Framebuffer> m_Framebuffer;
@@ -39,5 +39,8 @@ namespace Sandbox
 		GameObject m_Camera;
 
 		Ref<Font> m_Font;
+
+		// Draw a grid of quads recorded on the job system, one recording context per job
+		bool m_RecordedGrid = false;
 	};
 }
\ No newline at end of file
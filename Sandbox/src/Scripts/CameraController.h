@@ -27,25 +27,28 @@ namespace Sandbox
 
 		void OnUpdate(Timestep ts) override
 		{
-			auto& transform = GetComponent<TransformComponent>();
 			float speed = 5.0f;
+			glm::vec3 velocity = { 0.0f, 0.0f, 0.0f };
 
 			if (Input::IsKeyPressed(Key::W))
 			{
-				transform.Translation += glm::vec3{ 0.0f, -speed, 0.0f } * (float)ts;
+				velocity += glm::vec3{ 0.0f, -speed, 0.0f };
 			}
 			if (Input::IsKeyPressed(Key::S))
 			{
-				transform.Translation += glm::vec3{ 0.0f, +speed, 0.0f } * (float)ts;
+				velocity += glm::vec3{ 0.0f, +speed, 0.0f };
 			}
 			if (Input::IsKeyPressed(Key::A))
 			{
-				transform.Translation += glm::vec3{ +speed, 0.0f, 0.0f } * (float)ts;
+				velocity += glm::vec3{ +speed, 0.0f, 0.0f };
 			}
 			if (Input::IsKeyPressed(Key::D))
 			{
-				transform.Translation += glm::vec3{ -speed, 0.0f, 0.0f } * (float)ts;
+				velocity += glm::vec3{ -speed, 0.0f, 0.0f };
 			}
+
+			if (velocity != glm::vec3{ 0.0f, 0.0f, 0.0f })
+				PatchComponent<TransformComponent>([&](auto& transform) { transform.Translation += velocity * (float)ts; });
 		}
 	};
 }
\ No newline at end of file